@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+#
+# Builds the WebAssembly modules into dist/ (requires Emscripten's emcc).
+#
+#   ./build_wasm.sh            single-threaded module: dist/periodic_delaunay.js
+#   ./build_wasm.sh --threads  pthreads module:        dist/periodic_delaunay_mt.js
+#
+# The pthreads module runs the PSM's parallel insertion and the per-cell
+# acuteness loops on a pool of Web Workers sharing one SharedArrayBuffer.
+# Browsers only expose SharedArrayBuffer to cross-origin isolated pages, so
+# it must be served with
+#   Cross-Origin-Opener-Policy: same-origin
+#   Cross-Origin-Embedder-Policy: require-corp
+# index.html falls back to the single-threaded module otherwise.
+
+set -euo pipefail
+cd "$(dirname "$0")"
+
+SOURCES=(
+    src/cpp/periodic_delaunay.cpp
+    src/cpp/acuteness_wasm.cpp
+    src/cpp/delaunay_core.cpp
+    src/cpp/acuteness.cpp
+    src/cpp/physics_step.cpp
+    src/cpp/neighbor_index.cpp
+    src/cpp/render_buffers.cpp
+    src/cpp/snapshot.cpp
+    src/cpp/tet_centers.cpp
+    src/cpp/batch_compute.cpp
+    src/cpp/delaunay_2d.cpp
+    src/cpp/analysis_cache.cpp
+    src/cpp/Delaunay_psm.cpp
+)
+
+FLAGS=(
+    -O3 -std=c++17 -msimd128
+    -Isrc/cpp
+    --bind
+    -sMODULARIZE=1
+    -sALLOW_MEMORY_GROWTH=1
+)
+
+if [[ "${1:-}" == "--threads" ]]; then
+    emcc "${SOURCES[@]}" "${FLAGS[@]}" \
+        -pthread \
+        -sPTHREAD_POOL_SIZE=navigator.hardwareConcurrency \
+        -sEXPORT_NAME=PeriodicDelaunayModuleMT \
+        -o dist/periodic_delaunay_mt.js
+else
+    emcc "${SOURCES[@]}" "${FLAGS[@]}" \
+        -sEXPORT_NAME=PeriodicDelaunayModule \
+        -o dist/periodic_delaunay.js
+fi
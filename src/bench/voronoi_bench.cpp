@@ -0,0 +1,405 @@
+// voronoi_bench.cpp
+//
+// Benchmark of the triangulation and acuteness pipelines on the native core
+// (the same code as the WASM module, see delaunay_core.h). Runs every
+// combination of mode (periodic / non-periodic), distribution and size, and
+// prints one JSON object per combination and line (JSON Lines), with the
+// median time of each stage in milliseconds:
+//
+//   {"mode":"periodic","distribution":"uniform","num_points":10000,...,
+//    "stages_ms":{"marshal":..,"reorder":..,"insertion":..,...}}
+//
+// Distributions:
+//   uniform    uniform in the unit cube
+//   clustered  gaussian blobs (sigma 0.02) around 32 random centers
+//   lattice    regular grid with 1e-7 jitter (nearly cospherical points,
+//              exercises the symbolic perturbation of the predicates)
+//
+// Each combination reuses one DelaunayContext, like the demo's frame loop:
+// the warm-up runs are not timed, the stages of the timed runs are reduced
+// to their median. Every line also reports the bytes the context holds after
+// the triangulation ("retained_bytes", "bytes_per_point"), which with
+// --low-memory is what caps the point count within the WASM heap. With --baseline, totals are compared against a previous
+// output; the exit code is 2 if one got slower than the tolerance or failed.
+
+#include "delaunay_core.h"
+#include "acuteness.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Options {
+    std::vector<int> sizes = {1000, 10000, 100000, 1000000};
+    std::vector<std::string> distributions = {"uniform", "clustered", "lattice"};
+    std::vector<std::string> modes = {"periodic", "non-periodic"};
+    int repeat = 3;
+    int warmup = 1;
+    int threads = 0;  // 0 = all cores
+    bool acuteness = true;
+    bool spatial_order = false;
+    bool low_memory = false;
+    unsigned seed = 1;
+    std::string output;    // empty = stdout
+    std::string baseline;
+    double tolerance = 0.2;
+};
+
+// Stage names, in pipeline order, as written in "stages_ms".
+static const char* const STAGES[] = {
+    "marshal", "reorder", "insertion", "periodic_phase_1", "periodic_phase_2",
+    "compress", "dedup", "output", "total", "voronoi_cells", "acuteness",
+    "geometry_acuteness"
+};
+static const int NB_STAGES = int(sizeof(STAGES) / sizeof(STAGES[0]));
+
+static void usage(const char* program) {
+    std::cerr <<
+        "Usage: " << program << " [options]\n"
+        "\n"
+        "  --sizes <n,n,...>          Point counts (default 1000,10000,100000,1000000)\n"
+        "  --distributions <d,...>    uniform,clustered,lattice (default all)\n"
+        "  --modes <m,...>            periodic,non-periodic (default both)\n"
+        "  --repeat <n>               Timed runs per combination (default 3)\n"
+        "  --warmup <n>               Untimed runs per combination (default 1)\n"
+        "  --threads <n>              Worker threads (default: all cores)\n"
+        "  --no-acuteness             Skip the Voronoi cell and acuteness stages\n"
+        "  --spatial-order            Sort the points once up front, so the timed runs\n"
+        "                             reuse the BRIO order (sort_points_spatially)\n"
+        "  --low-memory               Free the stores the timed queries do not read after\n"
+        "                             each triangulation (DelaunayContext::set_low_memory)\n"
+        "  --seed <s>                 Seed of the point generators (default 1)\n"
+        "  --output <file>            Write the results there instead of stdout\n"
+        "  --baseline <file>          Compare totals with a previous output\n"
+        "  --tolerance <x>            Allowed slowdown over the baseline (default 0.2)\n";
+}
+
+static std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static bool parse_args(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-acuteness") {
+            options.acuteness = false;
+            continue;
+        }
+        if (arg == "--spatial-order") {
+            options.spatial_order = true;
+            continue;
+        }
+        if (arg == "--low-memory") {
+            options.low_memory = true;
+            continue;
+        }
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--sizes") {
+            options.sizes.clear();
+            for (const std::string& size : split(value)) {
+                options.sizes.push_back(std::atoi(size.c_str()));
+            }
+        } else if (arg == "--distributions") {
+            options.distributions = split(value);
+        } else if (arg == "--modes") {
+            options.modes = split(value);
+        } else if (arg == "--repeat") {
+            options.repeat = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--warmup") {
+            options.warmup = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--threads") {
+            options.threads = std::atoi(value.c_str());
+        } else if (arg == "--seed") {
+            options.seed = unsigned(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--baseline") {
+            options.baseline = value;
+        } else if (arg == "--tolerance") {
+            options.tolerance = std::atof(value.c_str());
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    for (const std::string& distribution : options.distributions) {
+        if (distribution != "uniform" && distribution != "clustered" && distribution != "lattice") {
+            std::cerr << "Unknown distribution " << distribution << std::endl;
+            return false;
+        }
+    }
+    for (const std::string& mode : options.modes) {
+        if (mode != "periodic" && mode != "non-periodic") {
+            std::cerr << "Unknown mode " << mode << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static double wrap01(double x) {
+    x -= std::floor(x);
+    return x >= 1.0 ? 0.0 : x;
+}
+
+static void generate_points(const std::string& distribution, int n, unsigned seed,
+                            std::vector<double>& points) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    points.resize(size_t(n) * 3);
+    if (distribution == "uniform") {
+        for (double& coord : points) {
+            coord = uniform(rng);
+        }
+    } else if (distribution == "clustered") {
+        const int nb_clusters = 32;
+        std::vector<double> centers(nb_clusters * 3);
+        for (double& coord : centers) {
+            coord = uniform(rng);
+        }
+        std::normal_distribution<double> blob(0.0, 0.02);
+        std::uniform_int_distribution<int> pick(0, nb_clusters - 1);
+        for (int i = 0; i < n; ++i) {
+            const double* center = &centers[size_t(pick(rng)) * 3];
+            for (int c = 0; c < 3; ++c) {
+                points[size_t(i) * 3 + c] = wrap01(center[c] + blob(rng));
+            }
+        }
+    } else {
+        const int m = int(std::ceil(std::cbrt(double(n)) - 1e-9));
+        std::uniform_real_distribution<double> jitter(-1e-7, 1e-7);
+        for (int i = 0; i < n; ++i) {
+            const int index[3] = {i % m, (i / m) % m, i / (m * m)};
+            for (int c = 0; c < 3; ++c) {
+                points[size_t(i) * 3 + c] = wrap01((index[c] + 0.5) / m + jitter(rng));
+            }
+        }
+    }
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : 0.5 * (values[mid - 1] + values[mid]);
+}
+
+struct RunResult {
+    double stages[NB_STAGES];
+    int num_raw_tets;
+    int num_unique_tets;
+};
+
+static bool run_once(DelaunayContext& context, const std::vector<double>& points,
+                     bool acuteness, int max_neighbors, RunResult& result,
+                     std::vector<float>& cell_vertices, std::vector<int>& cell_indices,
+                     std::vector<int>& scores, GeometryAcutenessScores& geometry_scores) {
+    const int n = int(points.size() / 3);
+    GEO::Stopwatch marshal_watch("marshal", false);
+    context.set_points(points.data(), n);
+    const double marshal = marshal_watch.elapsed_time();
+    if (!context.compute()) {
+        return false;
+    }
+    const DelaunayStats& t = context.stats();
+    const double stages[] = {
+        marshal + t.marshal, t.reorder, t.insertion, t.periodic_phase_1, t.periodic_phase_2,
+        t.compress, t.dedup, t.output, marshal + t.total, 0.0, 0.0, 0.0
+    };
+    std::copy(stages, stages + NB_STAGES, result.stages);
+    result.num_raw_tets = t.num_raw_tets;
+    result.num_unique_tets = t.num_unique_tets;
+
+    if (acuteness) {
+        GEO::Stopwatch cells_watch("voronoi_cells", false);
+        context.compute_voronoi_cells();
+        result.stages[NB_STAGES - 3] = cells_watch.elapsed_time();
+
+        GEO::Stopwatch acuteness_watch("acuteness", false);
+        const std::vector<int>& packed = context.voronoi_cells();
+        const std::vector<double>& vertices = context.voronoi_cell_vertices();
+        cell_vertices.assign(vertices.begin(), vertices.end());
+        cell_indices.resize(size_t(packed[0]) + 1);
+        for (int i = 0; i <= packed[0]; ++i) {
+            cell_indices[i] = packed[3 + i] * 3;
+        }
+        calculateCellAcutenessInto(cell_vertices, cell_indices, scores, max_neighbors);
+        result.stages[NB_STAGES - 2] = acuteness_watch.elapsed_time();
+
+        GEO::Stopwatch geometry_watch("geometry_acuteness", false);
+        analyzeGeometryAcutenessInto(context.points().data(), n, context.tets().data(),
+                                     int(context.tets().size() / 4), context.is_periodic(),
+                                     geometry_scores);
+        result.stages[NB_STAGES - 1] = geometry_watch.elapsed_time();
+    }
+    return true;
+}
+
+static std::string json_string(const std::string& value) {
+    return "\"" + value + "\"";
+}
+
+// Reads "key":value out of one of our own output lines.
+static std::string json_field(const std::string& line, const std::string& key) {
+    const std::string pattern = "\"" + key + "\":";
+    size_t pos = line.find(pattern);
+    if (pos == std::string::npos) {
+        return std::string();
+    }
+    pos += pattern.size();
+    size_t end = pos;
+    if (line[pos] == '"') {
+        end = line.find('"', pos + 1);
+        return line.substr(pos + 1, end - pos - 1);
+    }
+    while (end < line.size() && line[end] != ',' && line[end] != '}') {
+        ++end;
+    }
+    return line.substr(pos, end - pos);
+}
+
+static std::string record_key(const std::string& line) {
+    return json_field(line, "mode") + "/" + json_field(line, "distribution") + "/" +
+           json_field(line, "num_points");
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_args(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::map<std::string, double> baseline_totals;
+    if (!options.baseline.empty()) {
+        std::ifstream in(options.baseline);
+        if (!in) {
+            std::cerr << "Cannot open " << options.baseline << std::endl;
+            return 1;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            std::string total = json_field(line, "total");
+            if (!total.empty()) {
+                baseline_totals[record_key(line)] = std::atof(total.c_str());
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output);
+        if (!file) {
+            std::cerr << "Cannot write " << options.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.output.empty() ? std::cout : file;
+
+    initialize_geogram();
+    if (options.threads > 0) {
+        GEO::Process::set_max_threads(GEO::index_t(options.threads));
+    }
+    const int threads = int(GEO::Process::maximum_concurrent_threads());
+    const int max_neighbors = 6;
+
+    bool regression = false;
+    std::vector<double> points;
+    std::vector<float> cell_vertices;
+    std::vector<int> cell_indices;
+    std::vector<int> scores;
+    GeometryAcutenessScores geometry_scores;
+
+    for (const std::string& mode : options.modes) {
+        for (const std::string& distribution : options.distributions) {
+            for (int n : options.sizes) {
+                generate_points(distribution, n, options.seed, points);
+                DelaunayContext context(mode == "periodic");
+                context.set_low_memory(options.low_memory,
+                                       options.acuteness ? KEEP_VORONOI_CELLS : KEEP_TETS_ONLY);
+                if (options.spatial_order) {
+                    // Lay the points out the way a caller of sort_points_spatially() would.
+                    context.set_points(points.data(), n);
+                    if (context.sort_points_spatially()) {
+                        const std::vector<double> unsorted = points;
+                        const std::vector<int>& order = context.spatial_order();
+                        for (int k = 0; k < n; ++k) {
+                            std::copy(&unsorted[size_t(order[k]) * 3],
+                                      &unsorted[size_t(order[k]) * 3] + 3, &points[size_t(k) * 3]);
+                        }
+                    }
+                }
+                std::vector<std::vector<double>> samples(NB_STAGES);
+                RunResult result = {};
+                bool ok = true;
+                for (int run = 0; run < options.warmup + options.repeat && ok; ++run) {
+                    ok = run_once(context, points, options.acuteness, max_neighbors, result,
+                                  cell_vertices, cell_indices, scores, geometry_scores);
+                    if (ok && run >= options.warmup) {
+                        for (int s = 0; s < NB_STAGES; ++s) {
+                            samples[s].push_back(result.stages[s] * 1000.0);
+                        }
+                    }
+                }
+
+                std::ostringstream line;
+                line.precision(6);
+                line << "{\"mode\":" << json_string(mode)
+                     << ",\"distribution\":" << json_string(distribution)
+                     << ",\"num_points\":" << n
+                     << ",\"threads\":" << threads
+                     << ",\"repeat\":" << options.repeat
+                     << ",\"spatial_order\":" << (options.spatial_order ? "true" : "false")
+                     << ",\"low_memory\":" << (options.low_memory ? "true" : "false")
+                     << ",\"ok\":" << (ok ? "true" : "false");
+                if (ok) {
+                    line << ",\"num_raw_tets\":" << result.num_raw_tets
+                         << ",\"num_unique_tets\":" << result.num_unique_tets
+                         << ",\"nb_reallocations\":" << context.stats().nb_reallocations
+                         << ",\"peak_memory_bytes\":" << (long long)(context.stats().peak_memory_bytes)
+                         << ",\"retained_bytes\":" << (long long)(context.stats().retained_bytes)
+                         << ",\"bytes_per_point\":" << context.stats().retained_bytes / std::max(n, 1)
+                         << ",\"stages_ms\":{";
+                    for (int s = 0; s < NB_STAGES; ++s) {
+                        line << (s ? "," : "") << json_string(STAGES[s]) << ":"
+                             << median(samples[s]);
+                    }
+                    line << "}";
+                }
+                line << "}";
+                out << line.str() << std::endl;
+
+                auto base = baseline_totals.find(record_key(line.str()));
+                if (ok && base != baseline_totals.end()) {
+                    const double total = std::atof(json_field(line.str(), "total").c_str());
+                    const double ratio = total / std::max(base->second, 1e-9);
+                    std::cerr << base->first << ": " << total << " ms, x" << ratio
+                              << " of baseline" << std::endl;
+                    regression = regression || ratio > 1.0 + options.tolerance;
+                }
+                if (!ok) {
+                    std::cerr << mode << "/" << distribution << "/" << n
+                              << ": triangulation failed" << std::endl;
+                    regression = true;
+                }
+            }
+        }
+    }
+    return regression ? 2 : 0;
+}
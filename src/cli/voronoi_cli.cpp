@@ -0,0 +1,917 @@
+// voronoi_cli.cpp
+//
+// Native command-line driver for offline batch runs: triangulates a point
+// file with the same core as the WASM module (delaunay_core.h), extracts the
+// Voronoi cells and scores their acuteness (acuteness.h), using every core of
+// the machine.
+//
+//   voronoi_cli [options] <points-file | ->
+//
+// The points file holds one "x y z" triplet per line, in the unit cube;
+// blank lines and lines starting with '#' are ignored. A binary snapshot
+// (snapshot.h) can stand in for it, and then only the outputs that the
+// snapshot lacks trigger a triangulation. See usage() for the options and
+// the output formats. With --2d the points are "x y" pairs in the unit
+// square, triangulated by DelaunayContext2d (delaunay_2d.h).
+
+#include "delaunay_core.h"
+#include "acuteness.h"
+#include "batch_compute.h"
+#include "delaunay_2d.h"
+#include "neighbor_index.h"
+#include "snapshot.h"
+#include "tet_centers.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Options {
+    std::string points_file;
+    std::string tets_file;
+    std::string neighbors_file;
+    std::string nearest_file;
+    std::string cells_file;
+    std::string scores_file;
+    std::string snapshot_file;      // input snapshot instead of a points file
+    std::string save_snapshot_file;
+    bool is_periodic = true;
+    int max_neighbors = 6;
+    int num_nearest = 8;
+    int threads = 0;       // 0 = all cores
+    int random_points = 0; // > 0: generate uniform points instead of reading a file
+    int batch = 0;         // > 0 with random_points: that many point sets in one batch
+    bool plane = false;    // --2d: xy points, DelaunayContext2d
+    bool check = false;    // --check: verify the outputs, see run_checks()
+    unsigned seed = 1;
+    int log_level = LOG_ERRORS;
+};
+
+static void usage(const char* program) {
+    std::cerr <<
+        "Usage: " << program << " [options] <points-file | ->\n"
+        "\n"
+        "Options:\n"
+        "  --periodic             Periodic unit cube (default)\n"
+        "  --non-periodic         Points clipped by the unit cube\n"
+        "  --tets <file>          Write the unique tets, one 'a b c d' per line\n"
+        "  --neighbors <file>     Write the Delaunay neighbors of each point, one\n"
+        "                         sorted 'j k ...' list per line\n"
+        "  --nearest <file>       Write the k nearest points of each point (kd-tree,\n"
+        "                         periodic distances if periodic), nearest first\n"
+        "  --num-nearest <k>      k for --nearest (default 8)\n"
+        "  --cells <file>         Write the Voronoi cells (format below)\n"
+        "  --scores <file>        Write one acuteness score per cell and line\n"
+        "  --snapshot <file>      Read the points, tets, neighbors and scores from a\n"
+        "                         binary snapshot instead of a points file; its\n"
+        "                         periodicity overrides --periodic/--non-periodic\n"
+        "  --save-snapshot <file> Write a binary snapshot of the points, tets,\n"
+        "                         neighbors and (with --scores) scores\n"
+        "  --max-neighbors <k>    Neighbors per vertex for the scores (default 6)\n"
+        "  --threads <n>          Worker threads (default: all cores)\n"
+        "  --random <n>           Use n uniform random points instead of a file\n"
+        "  --seed <s>             Seed for --random (default 1)\n"
+        "  --batch <k>            With --random: triangulate k point sets (seeds s to\n"
+        "                         s + k - 1) in one batch; --tets and --scores then\n"
+        "                         hold one block per set, after a '# job <j>' line\n"
+        "  --log-level <l>        0 quiet, 1 errors (default), 2 info, 3 debug\n"
+        "  --check                Check the triangulation against independent\n"
+        "                         computations (full vs incremental and deduplicated\n"
+        "                         tets, snapshot round trip, kd-tree vs brute force,\n"
+        "                         Euler characteristic); exit status 2 on a mismatch\n"
+        "  --2d                   'x y' points in the unit square: --tets writes\n"
+        "                         triangles 'a b c', --cells polygons (format\n"
+        "                         below), --scores their acute angles; no\n"
+        "                         snapshots, --nearest or --batch; --check only\n"
+        "                         runs the triangle count and incremental checks\n"
+        "\n"
+        "Cells format, for each cell i:\n"
+        "  cell <i> <num_vertices> <num_faces>\n"
+        "  v <x> <y> <z>                         (num_vertices lines)\n"
+        "  f <neighbor> <v0> <v1> ...            (num_faces lines, neighbor -1 = box,\n"
+        "                                         vertex indices local to the cell)\n"
+        "With --2d, for each cell i:\n"
+        "  cell <i> <num_vertices>\n"
+        "  v <x> <y> <neighbor>                  (counterclockwise, neighbor across the\n"
+        "                                         edge to the next vertex, -1 = box)\n";
+}
+
+static bool parse_args(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << name << std::endl;
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* value = nullptr;
+        if (arg == "--periodic") {
+            options.is_periodic = true;
+        } else if (arg == "--non-periodic") {
+            options.is_periodic = false;
+        } else if (arg == "--tets" || arg == "--neighbors" || arg == "--nearest" ||
+                   arg == "--cells" || arg == "--scores" || arg == "--snapshot" ||
+                   arg == "--save-snapshot") {
+            if (!(value = next(arg.c_str()))) return false;
+            (arg == "--tets" ? options.tets_file :
+             arg == "--neighbors" ? options.neighbors_file :
+             arg == "--nearest" ? options.nearest_file :
+             arg == "--cells" ? options.cells_file :
+             arg == "--scores" ? options.scores_file :
+             arg == "--snapshot" ? options.snapshot_file : options.save_snapshot_file) = value;
+        } else if (arg == "--num-nearest") {
+            if (!(value = next(arg.c_str()))) return false;
+            options.num_nearest = std::atoi(value);
+        } else if (arg == "--max-neighbors") {
+            if (!(value = next(arg.c_str()))) return false;
+            options.max_neighbors = std::atoi(value);
+        } else if (arg == "--threads") {
+            if (!(value = next(arg.c_str()))) return false;
+            options.threads = std::atoi(value);
+        } else if (arg == "--random") {
+            if (!(value = next(arg.c_str()))) return false;
+            options.random_points = std::atoi(value);
+        } else if (arg == "--batch") {
+            if (!(value = next(arg.c_str()))) return false;
+            options.batch = std::atoi(value);
+        } else if (arg == "--seed") {
+            if (!(value = next(arg.c_str()))) return false;
+            options.seed = unsigned(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--2d") {
+            options.plane = true;
+        } else if (arg == "--log-level") {
+            if (!(value = next(arg.c_str()))) return false;
+            options.log_level = std::atoi(value);
+        } else if (arg == "--check") {
+            options.check = true;
+        } else if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (arg.size() > 1 && arg[0] == '-' && arg[1] == '-') {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        } else if (options.points_file.empty()) {
+            options.points_file = arg;
+        } else {
+            std::cerr << "Unexpected argument " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.random_points > 0 || !options.points_file.empty() ||
+           !options.snapshot_file.empty();
+}
+
+static bool read_points(std::istream& in, std::vector<double>& points, int dimension = 3) {
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        double x, y, z = 0.0;
+        if (!(fields >> x >> y) || (dimension == 3 && !(fields >> z))) {
+            std::cerr << "Line " << line_number << ": expected "
+                      << (dimension == 3 ? "'x y z'" : "'x y'") << std::endl;
+            return false;
+        }
+        points.push_back(x);
+        points.push_back(y);
+        if (dimension == 3) {
+            points.push_back(z);
+        }
+    }
+    return true;
+}
+
+static void write_tets(std::ostream& out, const std::vector<int>& tets) {
+    for (size_t t = 0; t + 3 < tets.size(); t += 4) {
+        out << tets[t] << ' ' << tets[t + 1] << ' ' << tets[t + 2] << ' ' << tets[t + 3] << '\n';
+    }
+}
+
+// One line per point: its row of a CSR neighbor list.
+static void write_neighbors(std::ostream& out, const std::vector<int>& rowptr,
+                            const std::vector<int>& neighbors) {
+    for (size_t v = 0; v + 1 < rowptr.size(); ++v) {
+        for (int k = rowptr[v]; k < rowptr[v + 1]; ++k) {
+            out << (k > rowptr[v] ? " " : "") << neighbors[k];
+        }
+        out << '\n';
+    }
+}
+
+// Unpacks the layout documented in DelaunayContext::compute_voronoi_cells().
+static void write_cells(std::ostream& out, const std::vector<int>& packed,
+                        const std::vector<double>& vertices) {
+    const int n = packed[0], num_faces = packed[1];
+    const int* cell_vertex_ptr = &packed[3];
+    const int* cell_face_ptr = cell_vertex_ptr + n + 1;
+    const int* face_ptr = cell_face_ptr + n + 1;
+    const int* face_neighbor = face_ptr + num_faces + 1;
+    const int* face_vertices = face_neighbor + num_faces;
+    out.precision(17);
+    for (int i = 0; i < n; ++i) {
+        const int v_begin = cell_vertex_ptr[i], v_end = cell_vertex_ptr[i + 1];
+        const int f_begin = cell_face_ptr[i], f_end = cell_face_ptr[i + 1];
+        out << "cell " << i << ' ' << v_end - v_begin << ' ' << f_end - f_begin << '\n';
+        for (int v = v_begin; v < v_end; ++v) {
+            out << "v " << vertices[size_t(v) * 3] << ' ' << vertices[size_t(v) * 3 + 1]
+                << ' ' << vertices[size_t(v) * 3 + 2] << '\n';
+        }
+        for (int f = f_begin; f < f_end; ++f) {
+            out << "f " << face_neighbor[f];
+            for (int k = face_ptr[f]; k < face_ptr[f + 1]; ++k) {
+                out << ' ' << face_vertices[k] - v_begin;
+            }
+            out << '\n';
+        }
+    }
+}
+
+// Packs the Voronoi cell vertices into the acuteness kernels' flat layout.
+static void pack_cells_for_acuteness(const std::vector<int>& packed,
+                                     const std::vector<double>& vertices,
+                                     std::vector<float>& cell_vertices,
+                                     std::vector<int>& cell_indices) {
+    const int n = packed[0];
+    const int* cell_vertex_ptr = &packed[3];
+    cell_vertices.assign(vertices.begin(), vertices.end());
+    cell_indices.resize(size_t(n) + 1);
+    for (int i = 0; i <= n; ++i) {
+        cell_indices[i] = cell_vertex_ptr[i] * 3;
+    }
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// --check: each check_* compares an output with an independent computation,
+// prints one line and returns false on a mismatch.
+
+static bool report_check(const char* name, bool ok, const std::string& detail) {
+    std::cerr << "check " << name << ": " << (ok ? "ok" : "MISMATCH") << " (" << detail << ")"
+              << std::endl;
+    return ok;
+}
+
+// Simplices of `size` point indices each, with sorted indices, sorted and
+// without repeats. `num_repeats` gets the number of repeats dropped.
+static std::vector<std::vector<int>> canonical_simplices(const std::vector<int>& simplices, int size,
+                                                         size_t* num_repeats = nullptr) {
+    std::vector<std::vector<int>> result;
+    result.reserve(simplices.size() / size_t(size));
+    for (size_t s = 0; s + size_t(size) <= simplices.size(); s += size_t(size)) {
+        result.emplace_back(simplices.begin() + s, simplices.begin() + s + size_t(size));
+        std::sort(result.back().begin(), result.back().end());
+    }
+    std::sort(result.begin(), result.end());
+    const size_t count = result.size();
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    if (num_repeats) {
+        *num_repeats = count - result.size();
+    }
+    return result;
+}
+
+// The faces of `dimension` + 1 indices of the simplices of `size` indices,
+// e.g. the edges (dimension 1) of the tets (size 4).
+static std::vector<int> simplex_faces(const std::vector<int>& simplices, int size, int dimension) {
+    std::vector<int> faces;
+    for (size_t s = 0; s + size_t(size) <= simplices.size(); s += size_t(size)) {
+        for (int mask = 0; mask < (1 << size); ++mask) {
+            int bits = 0;
+            for (int k = 0; k < size; ++k) bits += (mask >> k) & 1;
+            if (bits != dimension + 1) continue;
+            for (int k = 0; k < size; ++k) {
+                if ((mask >> k) & 1) faces.push_back(simplices[s + size_t(k)]);
+            }
+        }
+    }
+    return faces;
+}
+
+// The unique simplices and the Euler characteristic V - E + F (- T) of the
+// complex, which is 0 on the torus and 1 on the box: this catches duplicate,
+// missing and overlapping simplices.
+static bool check_euler(const char* name, const std::vector<int>& simplices, int size,
+                        int num_points, bool is_periodic) {
+    size_t num_repeats = 0;
+    const size_t num_simplices = canonical_simplices(simplices, size, &num_repeats).size();
+    long long euler = num_points;
+    for (int dimension = 1; dimension < size; ++dimension) {
+        const long long count = dimension + 1 == size
+            ? (long long)num_simplices
+            : (long long)canonical_simplices(simplex_faces(simplices, size, dimension),
+                                             dimension + 1).size();
+        euler += dimension % 2 ? -count : count;
+    }
+    const long long expected = is_periodic ? 0 : 1;
+    std::ostringstream detail;
+    detail << num_simplices << " unique, " << num_repeats << " repeated, Euler characteristic "
+           << euler << ", expected " << expected;
+    return report_check(name, num_repeats == 0 && euler == expected, detail.str());
+}
+
+// Periodic tets, unwrapped with their translations, tile the unit cube
+// exactly once: their volumes sum to 1. A repeated or missing tet shows up
+// as a volume off by that tet's.
+static bool check_dedup(const DelaunayContext& context) {
+    DelaunayContext translated(true);
+    translated.set_keeps_tet_translations(true);
+    translated.set_points(context.points().data(), context.num_points());
+    if (!translated.compute()) {
+        return report_check("dedup", false, "triangulation failed");
+    }
+    const std::vector<double>& points = translated.points();
+    const std::vector<int>& tets = translated.tets();
+    const std::vector<int8_t>& translations = translated.tet_translations();
+    double volume = 0.0;
+    for (size_t t = 0; t * 4 < tets.size(); ++t) {
+        double rel[3][3];
+        for (int k = 1; k < 4; ++k) {
+            for (int c = 0; c < 3; ++c) {
+                rel[k - 1][c] = points[size_t(tets[t * 4 + k]) * 3 + c] -
+                                points[size_t(tets[t * 4]) * 3 + c] +
+                                translations[t * 12 + size_t(k) * 3 + size_t(c)];
+            }
+        }
+        volume += std::abs(rel[0][0] * (rel[1][1] * rel[2][2] - rel[1][2] * rel[2][1]) -
+                           rel[0][1] * (rel[1][0] * rel[2][2] - rel[1][2] * rel[2][0]) +
+                           rel[0][2] * (rel[1][0] * rel[2][1] - rel[1][1] * rel[2][0])) / 6.0;
+    }
+    size_t num_repeats = 0;
+    const bool same = canonical_simplices(tets, 4) == canonical_simplices(context.tets(), 4, &num_repeats);
+    std::ostringstream detail;
+    detail.precision(12);
+    detail << tets.size() / 4 << " tets, " << num_repeats << " repeated, volume " << volume;
+    return report_check("dedup", same && num_repeats == 0 && std::abs(volume - 1.0) < 1e-9,
+                        detail.str());
+}
+
+// No point lies inside the circumsphere of a tet (kd-tree radius queries
+// around the circumcenters, minimum image distances if periodic).
+static bool check_empty_spheres(const DelaunayContext& context, bool is_periodic) {
+    const std::vector<double>& points = context.points();
+    const std::vector<int>& tets = context.tets();
+    const int num_tets = int(tets.size() / 4);
+    std::vector<double> centers(size_t(num_tets) * 3);
+    compute_tet_centers(points.data(), tets.data(), num_tets, nullptr, is_periodic,
+                        TET_CIRCUMCENTER, centers.data());
+    NeighborIndex index(is_periodic);
+    index.sync(context);
+    std::vector<int> inside;
+    int num_bad = 0;
+    for (int t = 0; t < num_tets; ++t) {
+        const double* center = &centers[size_t(t) * 3];
+        double sq_radius = 0.0;
+        for (int c = 0; c < 3; ++c) {
+            double delta = std::abs(points[size_t(tets[size_t(t) * 4]) * 3 + c] - center[c]);
+            if (is_periodic) delta = std::min(delta, 1.0 - delta);
+            sq_radius += delta * delta;
+        }
+        // Shrunk so that the tet's own vertices are not reported
+        index.within_radius(center, std::sqrt(sq_radius) * (1.0 - 1e-9), inside);
+        num_bad += !inside.empty();
+    }
+    std::ostringstream detail;
+    detail << num_tets << " tets, " << num_bad << " with a point inside";
+    return report_check("empty spheres", num_bad == 0, detail.str());
+}
+
+// Incremental updates after small moves of a few points against a full
+// triangulation of the moved points. Context is DelaunayContext or
+// DelaunayContext2d, whose simplices() has `size` indices per simplex.
+template <class Context, class Simplices>
+static bool check_incremental(const std::vector<double>& points, int dimension, bool is_periodic,
+                              unsigned seed, int size, const Simplices& simplices) {
+    const int n = int(points.size() / size_t(dimension));
+    std::vector<double> moved = points;
+    Context context(is_periodic);
+    context.set_points(moved.data(), n);
+    if (!context.compute()) {
+        return report_check("incremental", false, "triangulation failed");
+    }
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> step(-1e-4, 1e-4);
+    int num_incremental = 0, num_rounds = 5;
+    bool ok = true;
+    for (int round = 0; round < num_rounds && ok; ++round) {
+        for (int k = 0; k < std::max(1, n / 400); ++k) {
+            const size_t v = size_t(rng() % unsigned(n));
+            for (int d = 0; d < dimension; ++d) {
+                double& coord = moved[v * size_t(dimension) + size_t(d)];
+                coord = std::min(std::max(coord + step(rng), 0.0), 1.0);
+            }
+        }
+        context.set_points(moved.data(), n);
+        if (!context.compute_incremental(0.05)) {
+            return report_check("incremental", false, "update failed");
+        }
+        num_incremental += context.last_update_was_incremental();
+        Context full(is_periodic);
+        full.set_points(moved.data(), n);
+        ok = full.compute() && canonical_simplices(simplices(context), size) ==
+                                   canonical_simplices(simplices(full), size);
+    }
+    std::ostringstream detail;
+    detail << num_incremental << " of " << num_rounds << " updates incremental";
+    return report_check("incremental", ok, detail.str());
+}
+
+// Snapshot write -> read, field by field.
+static bool check_snapshot(const Snapshot& snapshot) {
+    std::vector<uint8_t> bytes;
+    Snapshot read;
+    const bool written = write_snapshot(snapshot, bytes);
+    const bool ok = written && read_snapshot(bytes.data(), bytes.size(), read) &&
+                    read.is_periodic == snapshot.is_periodic && read.points == snapshot.points &&
+                    read.weights == snapshot.weights && read.tets == snapshot.tets &&
+                    read.adjacency_rowptr == snapshot.adjacency_rowptr &&
+                    read.adjacency == snapshot.adjacency && read.scores == snapshot.scores;
+    std::ostringstream detail;
+    detail << bytes.size() << " bytes";
+    return report_check("snapshot", ok, detail.str());
+}
+
+// kd-tree nearest points of a sample of points against a brute-force scan
+// (minimum image distances if periodic).
+static bool check_nearest(const DelaunayContext& context, int k, bool is_periodic) {
+    const int n = context.num_points();
+    const std::vector<double>& points = context.points();
+    NeighborIndex index(is_periodic);
+    index.sync(context);
+    k = std::min(k, n - 1);
+    std::vector<int> found(size_t(std::max(k, 0)));
+    std::vector<std::pair<double, int>> candidates;
+    const int num_samples = std::min(n, 200);
+    int num_bad = 0;
+    for (int sample = 0; sample < num_samples; ++sample) {
+        const int i = int((long long)sample * n / num_samples);
+        candidates.clear();
+        for (int j = 0; j < n; ++j) {
+            if (j == i) continue;
+            double sq_dist = 0.0;
+            for (int d = 0; d < 3; ++d) {
+                double delta = std::abs(points[size_t(j) * 3 + d] - points[size_t(i) * 3 + d]);
+                if (is_periodic) delta = std::min(delta, 1.0 - delta);
+                sq_dist += delta * delta;
+            }
+            candidates.emplace_back(sq_dist, j);
+        }
+        std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end());
+        const int count = index.nearest_to_point(i, k, found.data());
+        bool same = count == k;
+        for (int m = 0; m < k && same; ++m) {
+            same = found[m] == candidates[m].second;
+        }
+        num_bad += !same;
+    }
+    std::ostringstream detail;
+    detail << num_samples << " points, " << k << " nearest, " << num_bad << " differ";
+    return report_check("nearest", num_bad == 0, detail.str());
+}
+
+// --check for the 3D triangulation of `context`, with the outputs as a
+// snapshot. Returns 0, or 2 on a mismatch.
+static int run_checks(const Options& options, const DelaunayContext& context,
+                      const Snapshot& outputs) {
+    const int n = context.num_points();
+    bool ok = check_euler("euler", context.tets(), 4, n, options.is_periodic);
+    if (options.is_periodic) {
+        ok = check_dedup(context) && ok;
+    }
+    ok = check_empty_spheres(context, options.is_periodic) && ok;
+    ok = check_incremental<DelaunayContext>(
+        context.points(), 3, options.is_periodic, options.seed, 4,
+        [](const DelaunayContext& c) -> const std::vector<int>& { return c.tets(); }) && ok;
+    ok = check_snapshot(outputs) && ok;
+    ok = check_nearest(context, options.num_nearest, options.is_periodic) && ok;
+    return ok ? 0 : 2;
+}
+
+// Number of triangles of the 2D triangulation: 2n on the torus, and
+// 2n - 2 - h in the box, for h points on the convex hull (h edges of a
+// single triangle).
+static bool check_triangle_count(const std::vector<int>& triangles, int num_points,
+                                 bool is_periodic) {
+    const auto edges = simplex_faces(triangles, 3, 1);
+    std::vector<std::pair<int, int>> sorted;
+    for (size_t e = 0; e + 1 < edges.size(); e += 2) {
+        sorted.emplace_back(std::min(edges[e], edges[e + 1]), std::max(edges[e], edges[e + 1]));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    long long num_hull = 0;
+    for (size_t e = 0; e < sorted.size();) {
+        size_t end = e;
+        while (end < sorted.size() && sorted[end] == sorted[e]) ++end;
+        num_hull += end - e == 1;
+        e = end;
+    }
+    const long long num_triangles = (long long)(triangles.size() / 3);
+    const long long expected = is_periodic ? 2LL * num_points : 2LL * num_points - 2 - num_hull;
+    std::ostringstream detail;
+    detail << num_triangles << " triangles, expected " << expected;
+    if (!is_periodic) {
+        detail << " with " << num_hull << " hull points";
+    }
+    return report_check("triangles", num_triangles == expected, detail.str());
+}
+
+// --check for the 2D triangulation of `context`. Returns 0, or 2 on a
+// mismatch.
+static int run_plane_checks(const Options& options, const DelaunayContext2d& context) {
+    const int n = context.num_points();
+    bool ok = check_triangle_count(context.triangles(), n, options.is_periodic);
+    ok = check_euler("euler", context.triangles(), 3, n, options.is_periodic) && ok;
+    ok = check_incremental<DelaunayContext2d>(
+        context.points(), 2, options.is_periodic, options.seed, 3,
+        [](const DelaunayContext2d& c) -> const std::vector<int>& { return c.triangles(); }) && ok;
+    return ok ? 0 : 2;
+}
+
+// --batch: options.batch random point sets through one DelaunayBatch.
+static int run_batch(const Options& options) {
+    const int n = options.random_points;
+    std::vector<double> points(size_t(options.batch) * size_t(n) * 3);
+    std::vector<int> offsets(size_t(options.batch) + 1);
+    for (int j = 0; j < options.batch; ++j) {
+        std::mt19937 rng(options.seed + unsigned(j));
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for (size_t k = size_t(j) * n * 3; k < size_t(j + 1) * n * 3; ++k) {
+            points[k] = uniform(rng);
+        }
+        offsets[j + 1] = (j + 1) * n;
+    }
+
+    DelaunayBatch batch(options.is_periodic);
+    BatchOptions batch_options;
+    batch_options.scores = !options.scores_file.empty();
+    batch_options.max_neighbors = options.max_neighbors;
+    const auto start = std::chrono::steady_clock::now();
+    const int num_ok = batch.compute(points.data(), offsets.data(), options.batch, batch_options);
+    std::cerr << "Batch of " << options.batch << " x " << n << " points: " << num_ok
+              << " succeeded, " << batch.tets().size() / 4 << " tets in " << seconds_since(start)
+              << " s" << std::endl;
+
+    if (!options.tets_file.empty()) {
+        std::ofstream out(options.tets_file);
+        const std::vector<int>& tet_offsets = batch.tet_offsets();
+        for (int j = 0; j < options.batch; ++j) {
+            out << "# job " << j << '\n';
+            write_tets(out, std::vector<int>(batch.tets().begin() + size_t(tet_offsets[j]) * 4,
+                                             batch.tets().begin() + size_t(tet_offsets[j + 1]) * 4));
+        }
+        if (!out) {
+            std::cerr << "Cannot write " << options.tets_file << std::endl;
+            return 1;
+        }
+    }
+    if (!options.scores_file.empty()) {
+        std::ofstream out(options.scores_file);
+        for (int j = 0; j < options.batch; ++j) {
+            out << "# job " << j << '\n';
+            for (int k = offsets[j]; k < offsets[j + 1]; ++k) {
+                out << batch.scores()[k] << '\n';
+            }
+        }
+        if (!out) {
+            std::cerr << "Cannot write " << options.scores_file << std::endl;
+            return 1;
+        }
+    }
+    return num_ok == options.batch ? 0 : 1;
+}
+
+// --2d: triangulates options.random_points random points or the xy points
+// file with a DelaunayContext2d.
+static int run_plane(const Options& options) {
+    std::vector<double> points;
+    if (options.random_points > 0) {
+        std::mt19937 rng(options.seed);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        points.resize(size_t(options.random_points) * 2);
+        for (double& coord : points) {
+            coord = uniform(rng);
+        }
+    } else if (options.points_file == "-") {
+        if (!read_points(std::cin, points, 2)) return 1;
+    } else {
+        std::ifstream in(options.points_file);
+        if (!in) {
+            std::cerr << "Cannot open " << options.points_file << std::endl;
+            return 1;
+        }
+        if (!read_points(in, points, 2)) return 1;
+    }
+    const int num_points = int(points.size() / 2);
+
+    DelaunayContext2d context(options.is_periodic);
+    context.set_points(points.data(), num_points);
+    auto start = std::chrono::steady_clock::now();
+    if (!context.compute()) {
+        std::cerr << "Delaunay computation failed" << std::endl;
+        return 1;
+    }
+    const DelaunayStats& stats = context.stats();
+    std::cerr << "Triangulated " << num_points << " points: " << stats.num_unique_tets
+              << " triangles";
+    if (options.is_periodic) {
+        std::cerr << " (" << stats.num_raw_tets << " with the periodic copies)";
+    }
+    std::cerr << " in " << seconds_since(start) << " s" << std::endl;
+
+    if (!options.tets_file.empty()) {
+        std::ofstream out(options.tets_file);
+        const std::vector<int>& triangles = context.triangles();
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+            out << triangles[t] << ' ' << triangles[t + 1] << ' ' << triangles[t + 2] << '\n';
+        }
+        if (!out) {
+            std::cerr << "Cannot write " << options.tets_file << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.neighbors_file.empty()) {
+        context.compute_adjacency();
+        std::ofstream out(options.neighbors_file);
+        write_neighbors(out, context.adjacency_rowptr(), context.adjacency());
+        if (!out) {
+            std::cerr << "Cannot write " << options.neighbors_file << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.cells_file.empty() || !options.scores_file.empty()) {
+        start = std::chrono::steady_clock::now();
+        context.compute_voronoi_cells();
+        // Layout documented in DelaunayContext2d::compute_voronoi_cells().
+        const std::vector<int>& packed = context.voronoi_cells();
+        const std::vector<double>& vertices = context.voronoi_cell_vertices();
+        const int* cell_vertex_ptr = &packed[2];
+        const int* edge_neighbor = cell_vertex_ptr + num_points + 1;
+        std::cerr << "Extracted " << packed[0] << " Voronoi cells (" << packed[1]
+                  << " vertices) in " << seconds_since(start) << " s" << std::endl;
+
+        if (!options.cells_file.empty()) {
+            std::ofstream out(options.cells_file);
+            out.precision(17);
+            for (int i = 0; i < num_points; ++i) {
+                out << "cell " << i << ' ' << cell_vertex_ptr[i + 1] - cell_vertex_ptr[i] << '\n';
+                for (int v = cell_vertex_ptr[i]; v < cell_vertex_ptr[i + 1]; ++v) {
+                    out << "v " << vertices[size_t(v) * 2] << ' ' << vertices[size_t(v) * 2 + 1]
+                        << ' ' << edge_neighbor[v] << '\n';
+                }
+            }
+            if (!out) {
+                std::cerr << "Cannot write " << options.cells_file << std::endl;
+                return 1;
+            }
+        }
+
+        if (!options.scores_file.empty()) {
+            std::vector<int> scores;
+            calculateCellAcuteness2dInto(vertices.data(), cell_vertex_ptr, num_points, scores);
+            std::ofstream out(options.scores_file);
+            for (int score : scores) {
+                out << score << '\n';
+            }
+            if (!out) {
+                std::cerr << "Cannot write " << options.scores_file << std::endl;
+                return 1;
+            }
+        }
+    }
+    return options.check ? run_plane_checks(options, context) : 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_args(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (options.plane) {
+        if (options.batch > 0 || !options.snapshot_file.empty() ||
+            !options.save_snapshot_file.empty() || !options.nearest_file.empty()) {
+            std::cerr << "--2d does not take --batch, snapshots or --nearest" << std::endl;
+            return 1;
+        }
+        set_log_level(options.log_level);
+        initialize_geogram();
+        if (options.threads > 0) {
+            GEO::Process::set_max_threads(GEO::index_t(options.threads));
+        }
+        return run_plane(options);
+    }
+
+    if (options.batch > 0) {
+        if (options.random_points < 4) {
+            std::cerr << "--batch needs --random with at least 4 points" << std::endl;
+            return 1;
+        }
+        set_log_level(options.log_level);
+        initialize_geogram();
+        if (options.threads > 0) {
+            GEO::Process::set_max_threads(GEO::index_t(options.threads));
+        }
+        return run_batch(options);
+    }
+
+    Snapshot snapshot;
+    const bool from_snapshot = !options.snapshot_file.empty();
+    std::vector<double> points;
+    if (from_snapshot) {
+        if (!load_snapshot(options.snapshot_file, snapshot)) {
+            std::cerr << "Cannot read snapshot " << options.snapshot_file << std::endl;
+            return 1;
+        }
+        options.is_periodic = snapshot.is_periodic;
+        points = snapshot.points;
+    } else if (options.random_points > 0) {
+        std::mt19937 rng(options.seed);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        points.resize(size_t(options.random_points) * 3);
+        for (double& coord : points) {
+            coord = uniform(rng);
+        }
+    } else if (options.points_file == "-") {
+        if (!read_points(std::cin, points)) return 1;
+    } else {
+        std::ifstream in(options.points_file);
+        if (!in) {
+            std::cerr << "Cannot open " << options.points_file << std::endl;
+            return 1;
+        }
+        if (!read_points(in, points)) return 1;
+    }
+    const int num_points = int(points.size() / 3);
+    if (num_points < 4) {
+        std::cerr << "Need at least 4 points, got " << num_points << std::endl;
+        return 1;
+    }
+
+    set_log_level(options.log_level);
+    initialize_geogram();
+    if (options.threads > 0) {
+        GEO::Process::set_max_threads(GEO::index_t(options.threads));
+    }
+
+    DelaunayContext context(options.is_periodic);
+    context.set_points(points.data(), num_points);
+    if (!snapshot.weights.empty()) {
+        context.set_weights(snapshot.weights.data(), num_points);
+    }
+    // Triangulates on first use only: a snapshot already holds the tets.
+    bool triangulated = false;
+    auto triangulate = [&]() {
+        if (triangulated) {
+            return true;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        if (!context.compute()) {
+            std::cerr << "Delaunay computation failed" << std::endl;
+            return false;
+        }
+        const DelaunayStats& stats = context.stats();
+        std::cerr << "Triangulated " << num_points << " points: " << stats.num_unique_tets
+                  << " tets (" << stats.num_raw_tets << " before dedup) in "
+                  << seconds_since(start) << " s, peak memory "
+                  << stats.peak_memory_bytes / (1024.0 * 1024.0) << " MiB" << std::endl;
+        triangulated = true;
+        return true;
+    };
+    if (from_snapshot) {
+        std::cerr << "Loaded " << num_points << " points and " << snapshot.tets.size() / 4
+                  << " tets from " << options.snapshot_file << std::endl;
+    } else if (!triangulate()) {
+        return 1;
+    }
+    const std::vector<int>& tets = from_snapshot ? snapshot.tets : context.tets();
+
+    if (!options.tets_file.empty()) {
+        std::ofstream out(options.tets_file);
+        write_tets(out, tets);
+        if (!out) {
+            std::cerr << "Cannot write " << options.tets_file << std::endl;
+            return 1;
+        }
+    }
+
+    const bool snapshot_adjacency = from_snapshot && !snapshot.adjacency_rowptr.empty();
+    if (!snapshot_adjacency && (!options.neighbors_file.empty() || !options.save_snapshot_file.empty() ||
+                                options.check)) {
+        if (!triangulate()) return 1;
+        context.compute_adjacency();
+    }
+    const std::vector<int>& rowptr = snapshot_adjacency ? snapshot.adjacency_rowptr : context.adjacency_rowptr();
+    const std::vector<int>& adjacency = snapshot_adjacency ? snapshot.adjacency : context.adjacency();
+
+    if (!options.neighbors_file.empty()) {
+        std::ofstream out(options.neighbors_file);
+        write_neighbors(out, rowptr, adjacency);
+        if (!out) {
+            std::cerr << "Cannot write " << options.neighbors_file << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.nearest_file.empty()) {
+        const auto start = std::chrono::steady_clock::now();
+        NeighborIndex index(options.is_periodic);
+        index.sync(context);
+        std::vector<int> nearest;
+        const int k = index.all_nearest(options.num_nearest, nearest);
+        std::vector<int> nearest_rowptr(size_t(num_points) + 1);
+        for (int v = 0; v <= num_points; ++v) {
+            nearest_rowptr[v] = v * k;
+        }
+        std::cerr << "Found the " << k << " nearest points of each point in "
+                  << seconds_since(start) << " s" << std::endl;
+        std::ofstream out(options.nearest_file);
+        write_neighbors(out, nearest_rowptr, nearest);
+        if (!out) {
+            std::cerr << "Cannot write " << options.nearest_file << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<int> scores;
+    const bool snapshot_scores = from_snapshot && snapshot.scores.size() == size_t(num_points);
+    if (snapshot_scores) {
+        scores = snapshot.scores;
+    }
+    if (!options.cells_file.empty() || (!options.scores_file.empty() && !snapshot_scores)) {
+        if (!triangulate()) return 1;
+        auto start = std::chrono::steady_clock::now();
+        context.compute_voronoi_cells();
+        const std::vector<int>& packed = context.voronoi_cells();
+        std::cerr << "Extracted " << packed[0] << " Voronoi cells (" << packed[2]
+                  << " vertices) in " << seconds_since(start) << " s" << std::endl;
+
+        if (!options.cells_file.empty()) {
+            std::ofstream out(options.cells_file);
+            write_cells(out, packed, context.voronoi_cell_vertices());
+            if (!out) {
+                std::cerr << "Cannot write " << options.cells_file << std::endl;
+                return 1;
+            }
+        }
+
+        if (!options.scores_file.empty() && !snapshot_scores) {
+            start = std::chrono::steady_clock::now();
+            std::vector<float> cell_vertices;
+            std::vector<int> cell_indices;
+            pack_cells_for_acuteness(packed, context.voronoi_cell_vertices(), cell_vertices, cell_indices);
+            calculateCellAcutenessInto(cell_vertices, cell_indices, scores, options.max_neighbors);
+            std::cerr << "Scored " << scores.size() << " cells in " << seconds_since(start) << " s"
+                      << std::endl;
+        }
+    }
+
+    if (!options.scores_file.empty()) {
+        std::ofstream out(options.scores_file);
+        for (int score : scores) {
+            out << score << '\n';
+        }
+        if (!out) {
+            std::cerr << "Cannot write " << options.scores_file << std::endl;
+            return 1;
+        }
+    }
+
+    Snapshot out;
+    out.is_periodic = options.is_periodic;
+    // The triangulation wraps periodic points into [0,1).
+    out.points = triangulated ? context.points() : points;
+    out.weights = snapshot.weights;
+    out.tets = tets;
+    out.adjacency_rowptr = rowptr;
+    out.adjacency = adjacency;
+    if (!options.scores_file.empty()) {
+        out.scores = scores;
+    }
+    if (!options.save_snapshot_file.empty() && !save_snapshot(out, options.save_snapshot_file)) {
+        std::cerr << "Cannot write " << options.save_snapshot_file << std::endl;
+        return 1;
+    }
+
+    if (options.check) {
+        // The checks read the context's own triangulation.
+        if (!triangulate()) return 1;
+        return run_checks(options, context, out);
+    }
+    return 0;
+}
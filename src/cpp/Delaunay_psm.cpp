@@ -7657,6 +7657,134 @@ namespace {
         std::vector<pthread_t> thread_impl_;
     };
 
+#endif
+
+#if defined(GEO_OS_EMSCRIPTEN) && defined(__EMSCRIPTEN_PTHREADS__)
+
+    // Thread manager for the pthreads (SharedArrayBuffer) build of the
+    // WASM module. Under Emscripten each pthread is a Web Worker taken from
+    // the pool (-sPTHREAD_POOL_SIZE), and starting or joining one goes
+    // through postMessage, so the workers are created once, kept waiting on
+    // a condition variable, and handed Thread objects at each call. The
+    // calling thread takes part in the work.
+    class GEOGRAM_API EmscriptenThreadPoolManager : public ThreadManager {
+    public:
+        EmscriptenThreadPoolManager() :
+	    jobs_(nullptr),
+	    nb_jobs_(0),
+	    next_job_(0),
+	    nb_pending_(0),
+	    stop_(false) {
+            pthread_mutex_init(&mutex_, nullptr);
+            pthread_cond_init(&work_cond_, nullptr);
+            pthread_cond_init(&done_cond_, nullptr);
+        }
+
+        index_t maximum_concurrent_threads() override {
+            return Process::number_of_cores();
+        }
+
+    protected:
+
+        ~EmscriptenThreadPoolManager() override {
+            pthread_mutex_lock(&mutex_);
+            stop_ = true;
+            pthread_cond_broadcast(&work_cond_);
+            pthread_mutex_unlock(&mutex_);
+            for(pthread_t& worker : workers_) {
+                pthread_join(worker, nullptr);
+            }
+            pthread_cond_destroy(&done_cond_);
+            pthread_cond_destroy(&work_cond_);
+            pthread_mutex_destroy(&mutex_);
+        }
+
+        static void* run_worker(void* manager_in) {
+            EmscriptenThreadPoolManager* manager =
+                reinterpret_cast<EmscriptenThreadPoolManager*>(manager_in);
+            pthread_mutex_lock(&manager->mutex_);
+            for(;;) {
+                while(!manager->stop_ && manager->next_job_ == manager->nb_jobs_) {
+                    pthread_cond_wait(&manager->work_cond_, &manager->mutex_);
+                }
+                if(manager->stop_) {
+                    break;
+                }
+                manager->run_next_job();
+            }
+            pthread_mutex_unlock(&manager->mutex_);
+            return nullptr;
+        }
+
+        // Runs the next job of the current batch, mutex_ being locked.
+        void run_next_job() {
+            Thread* T = (*jobs_)[next_job_];
+            ++next_job_;
+            pthread_mutex_unlock(&mutex_);
+            // Sets the thread-local-storage instance pointer, so
+            // that Thread::current() can retrieve it.
+            set_current_thread(T);
+            T->run();
+            set_current_thread(nullptr);
+            pthread_mutex_lock(&mutex_);
+            --nb_pending_;
+            if(nb_pending_ == 0) {
+                pthread_cond_signal(&done_cond_);
+            }
+        }
+
+        void run_concurrent_threads (
+            ThreadGroup& threads, index_t max_threads
+        ) override {
+            geo_argused(max_threads);
+
+            for(index_t i = 0; i < threads.size(); i++) {
+                set_thread_id(threads[i],i);
+            }
+
+            pthread_mutex_lock(&mutex_);
+
+            // Grow the pool on demand. If the Emscripten pool is exhausted,
+            // the remaining jobs are shared by the existing workers.
+            while(workers_.size() + 1 < threads.size()) {
+                pthread_t worker;
+                if(pthread_create(&worker, nullptr, &run_worker, this) != 0) {
+                    break;
+                }
+                workers_.push_back(worker);
+            }
+
+            jobs_ = &threads;
+            nb_jobs_ = threads.size();
+            next_job_ = 0;
+            nb_pending_ = threads.size();
+            pthread_cond_broadcast(&work_cond_);
+
+            while(next_job_ < nb_jobs_) {
+                run_next_job();
+            }
+            while(nb_pending_ != 0) {
+                pthread_cond_wait(&done_cond_, &mutex_);
+            }
+
+            jobs_ = nullptr;
+            nb_jobs_ = 0;
+            next_job_ = 0;
+            pthread_mutex_unlock(&mutex_);
+        }
+
+    private:
+        pthread_mutex_t mutex_;
+        pthread_cond_t work_cond_;
+        pthread_cond_t done_cond_;
+        std::vector<pthread_t> workers_;
+        ThreadGroup* jobs_;
+        index_t nb_jobs_;
+        index_t next_job_;
+        index_t nb_pending_;
+        bool stop_;
+    };
+
 #endif
 
     GEO_NORETURN_DECL void abnormal_program_termination(
@@ -7754,7 +7882,13 @@ namespace GEO {
     namespace Process {
 
         bool os_init_threads() {
-#ifdef GEO_USE_PTHREAD_MANAGER
+#if defined(GEO_OS_EMSCRIPTEN) && defined(__EMSCRIPTEN_PTHREADS__)
+            Logger::out("Process")
+                << "Using Emscripten thread pool"
+                << std::endl;
+            set_thread_manager(new EmscriptenThreadPoolManager);
+            return true;
+#elif defined(GEO_USE_PTHREAD_MANAGER)
             Logger::out("Process")
                 << "Using posix threads"
                 << std::endl;
@@ -8744,17 +8878,15 @@ namespace GEO {
 	// in a portable way.
         auto now(std::chrono::system_clock::now());
         auto elapsed = now-start_;
-        auto elapsed_milliseconds =
-	    std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
-        return 0.001 * double(elapsed_milliseconds.count());
+	// Full clock resolution: the stages of small (1k points) runs
+	// take well under a millisecond.
+        return std::chrono::duration<double>(elapsed).count();
     }
 
     double Stopwatch::now() {
         auto now(std::chrono::system_clock::now());
         auto elapsed = now.time_since_epoch();
-        auto elapsed_milliseconds =
-	    std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
-        return 0.001 * double(elapsed_milliseconds.count());
+        return std::chrono::duration<double>(elapsed).count();
     }
 
     Stopwatch::~Stopwatch() {
@@ -23823,6 +23955,14 @@ namespace GEO {
     Delaunay2d::~Delaunay2d() {
     }
 
+    size_t Delaunay2d::memory_bytes() const {
+	return sizeof(index_t) * (
+	    cell_to_v_store_.capacity() + cell_to_cell_store_.capacity() +
+	    cell_next_.capacity() + reorder_.capacity() +
+	    v_to_cell_.capacity() + cicl_.capacity()
+	) + sizeof(double) * heights_.capacity();
+    }
+
     void Delaunay2d::set_vertices(index_t nb_vertices, const double* vertices) {
         has_empty_cells_ = false;
 	Stopwatch W("DelInternal", benchmark_mode_);
@@ -29917,6 +30057,28 @@ namespace GEO {
 	    nb_failed_locate_ = 0;
 	}
 
+	// Re-reads the master's state like the constructor does, but keeps
+	// the scratch buffers (S_, tets_to_delete_, tets_to_release_, cavity_)
+	// allocated, so that a PeriodicDelaunay3d reused across several calls
+	// to compute() does not reallocate them.
+	void reset(index_t pool_begin, index_t pool_end) {
+	    max_t_ = master_->cell_next_.size();
+
+	    nb_vertices_ = master_->nb_vertices();
+	    nb_vertices_non_periodic_ = master_->nb_vertices_non_periodic_;
+	    vertices_ = master_->vertex_ptr(0);
+	    weights_ = master_->weights_;
+	    dimension_ = master_->dimension();
+	    reorder_ = master_->reorder_.data();
+
+	    b_hint_ = NO_TETRAHEDRON;
+	    e_hint_ = NO_TETRAHEDRON;
+	    has_empty_cells_ = false;
+
+	    reset_stats();
+	    set_pool(pool_begin, pool_end);
+	}
+
         void set_pool(index_t pool_begin, index_t pool_end) {
 	    pool_begin_ = pool_begin;
 	    pool_end_ = pool_end;
@@ -30303,7 +30465,7 @@ namespace GEO {
             // are inserted after, in sequential mode).
             if(
                 nb_tets_to_create_ > nb_free_ &&
-                Process::is_running_threads()
+                master_->threads_running_
             ) {
                 memory_overflow_ = true;
                 ok = false;
@@ -31242,7 +31404,7 @@ namespace GEO {
             // If the memory pool is full, then we expand it.
             // This cannot be done when running multiple threads.
             if(first_free_ == END_OF_LIST) {
-                geo_debug_assert(!Process::is_running_threads());
+                geo_debug_assert(!master_->threads_running_);
 
                 if(
                     master_->cell_to_v_store_.size() ==
@@ -31896,6 +32058,8 @@ namespace GEO {
         update_periodic_v_to_cell_(false),
         has_empty_cells_(false),
         nb_reallocations_(0),
+        max_threads_(0),
+        threads_running_(false),
         convex_cell_exact_predicates_(true)
     {
         debug_mode_ = CmdLine::get_arg_bool("dbg:delaunay");
@@ -31918,6 +32082,8 @@ namespace GEO {
         update_periodic_v_to_cell_(false),
         has_empty_cells_(false),
         nb_reallocations_(0),
+        max_threads_(0),
+        threads_running_(false),
         convex_cell_exact_predicates_(true)
     {
         debug_mode_ = CmdLine::get_arg_bool("dbg:delaunay");
@@ -32023,6 +32189,9 @@ namespace GEO {
 		Process::maximum_concurrent_threads(),
 		CellStatusArray::MAX_THREADS
 	    );
+	    if(max_threads_ != 0) {
+		nb_threads = std::min(nb_threads, max_threads_);
+	    }
 	    index_t pool_size = expected_tetra / nb_threads;
 	    if (pool_size == 0) {
 		// There are more threads than expected_tetra
@@ -32030,14 +32199,23 @@ namespace GEO {
 		nb_threads = expected_tetra;
 	    }
 	    index_t pool_begin = 0;
-	    threads_.clear();
+	    // Threads created by a previous call to compute() are reused
+	    // (with their scratch buffers), only their pools are reset.
+	    bool reuse_threads = (threads_.size() == nb_threads);
+	    if(!reuse_threads) {
+		threads_.clear();
+	    }
 	    for(index_t t=0; t<nb_threads; ++t) {
 		index_t pool_end =
 		    (t == nb_threads - 1) ? expected_tetra
 		                          : pool_begin + pool_size;
-		threads_.push_back(
-		    new PeriodicDelaunay3dThread(this, pool_begin, pool_end)
-		);
+		if(reuse_threads) {
+		    thread(t)->reset(pool_begin, pool_end);
+		} else {
+		    threads_.push_back(
+			new PeriodicDelaunay3dThread(this, pool_begin, pool_end)
+		    );
+		}
 		pool_begin = pool_end;
 	    }
 
@@ -32279,6 +32457,55 @@ namespace GEO {
         return nb_tets;
     }
 
+    void PeriodicDelaunay3d::release_construction_buffers(
+	bool keep_adjacency
+    ) {
+	geo_assert(!threads_running_);
+
+	// The free lists and the cell status are rebuilt by compute().
+	vector<index_t>().swap(cell_next_);
+	cell_status_.clear();
+
+	// The periodic copies are only referenced by the tets.
+	if(periodic_) {
+	    reorder_.resize(nb_vertices_non_periodic_);
+	    reorder_.shrink_to_fit();
+	}
+
+	cell_to_v_store_.shrink_to_fit();
+	if(keep_adjacency) {
+	    cell_to_cell_store_.shrink_to_fit();
+	    if(periodic_ && !update_periodic_v_to_cell_) {
+		// Only the real vertices have a v_to_cell entry.
+		v_to_cell_.resize(nb_vertices_non_periodic_);
+		v_to_cell_.shrink_to_fit();
+	    }
+	} else {
+	    vector<index_t>().swap(cell_to_cell_store_);
+	    vector<index_t>().swap(v_to_cell_);
+	    vector<index_t>().swap(periodic_v_to_cell_rowptr_);
+	    vector<index_t>().swap(periodic_v_to_cell_data_);
+	}
+
+	set_arrays(
+	    nb_cells(),
+	    cell_to_v_store_.data(),
+	    keep_adjacency ? cell_to_cell_store_.data() : nullptr
+	);
+    }
+
+    size_t PeriodicDelaunay3d::memory_bytes() const {
+	return sizeof(index_t) * (
+	    cell_to_v_store_.capacity() + cell_to_cell_store_.capacity() +
+	    cell_next_.capacity() + reorder_.capacity() + levels_.capacity() +
+	    v_to_cell_.capacity() + cicl_.capacity() +
+	    periodic_v_to_cell_rowptr_.capacity() +
+	    periodic_v_to_cell_data_.capacity()
+	) +
+	sizeof(Numeric::uint32) * vertex_instances_.capacity() +
+	sizeof(CellStatusArray::cell_status_t) * cell_status_.capacity();
+    }
+
     index_t PeriodicDelaunay3d::nearest_vertex(const double* p) const {
         // TODO
         return Delaunay::nearest_vertex(p);
@@ -32738,7 +32965,15 @@ namespace GEO {
             }
 
 	    check_max_t();
-	    Process::run_threads(threads_);
+	    // A single thread runs in the calling thread (and may grow the
+	    // tet stores), see set_max_threads().
+	    if(threads_.size() == 1) {
+		thread0->run();
+	    } else {
+		threads_running_ = true;
+		Process::run_threads(threads_);
+		threads_running_ = false;
+	    }
 
             for(index_t t=0; t<this->nb_threads(); ++t) {
                 if(thread(t)->has_empty_cells()) {
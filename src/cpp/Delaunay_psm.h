@@ -9942,6 +9942,12 @@ namespace GEO {
             abort_if_empty_cell_ = x;
         }
 
+	/**
+	 * \brief Bytes allocated by the triangle stores and the insertion
+	 *  buffers.
+	 */
+	size_t memory_bytes() const;
+
     protected:
 
         static constexpr index_t NO_TRIANGLE = NO_INDEX;
@@ -10548,6 +10554,10 @@ namespace GEO {
             return size_;
         }
 
+        index_t capacity() const {
+            return capacity_;
+        }
+
         void clear() {
             geo_debug_assert(!Process::is_running_threads());
 #ifdef GEO_DEBUG
@@ -10628,6 +10638,103 @@ namespace GEO {
 
         void compute();
 
+	/**
+	 * \brief Timings and counters of the last call to compute()
+	 * \details Filled whether or not benchmark mode is enabled.
+	 */
+	struct Stats {
+
+	    Stats();
+
+	    void reset();
+
+	    std::string to_string() {
+		return raw_ ? to_string_raw() : to_string_pretty();
+	    }
+
+	    std::string to_string_raw() const;
+	    std::string to_string_pretty() const;
+
+	    bool raw_;
+
+	    double  total_t_;
+
+	    double  phase_0_t_;
+
+	    double  phase_I_t_;
+	    double  phase_I_classify_t_;
+	    index_t phase_I_nb_inside_;
+	    index_t phase_I_nb_cross_;
+	    index_t phase_I_nb_outside_;
+	    double  phase_I_insert_t_;
+	    index_t phase_I_insert_nb_;
+
+	    double  phase_II_t_;
+	    double  phase_II_classify_t_;
+	    double  phase_II_insert_t_;
+	    index_t phase_II_insert_nb_;
+	};
+
+	const Stats& stats() const {
+	    return stats_;
+	}
+
+	/**
+	 * \brief Number of times a thread ran out of tets in its pool
+	 *  and the tet stores had to be grown, since construction.
+	 */
+	index_t nb_reallocations() const {
+	    return nb_reallocations_;
+	}
+
+	/**
+	 * \brief Caps the number of threads compute() inserts the points
+	 *  with (0, the default, for Process::maximum_concurrent_threads()).
+	 * \details With a single thread, compute() runs it in the calling
+	 *  thread instead of going through Process::run_threads(), so that
+	 *  several triangulations can be computed concurrently, one per
+	 *  thread of a caller's parallel_for().
+	 */
+	void set_max_threads(index_t max_threads) {
+	    max_threads_ = max_threads;
+	}
+
+	/**
+	 * \brief Frees what compute() only needs while inserting the points.
+	 * \details Frees the free lists (cell_next), the cell status array,
+	 *  the periodic copies in the insertion order and in v_to_cell, and
+	 *  shrinks the tet stores to the tets kept by compress(). If
+	 *  keep_adjacency is false, also frees the tet adjacency (cell_to_cell)
+	 *  and v_to_cell: cell_vertex() and vertex() still work, but
+	 *  cell_adjacent(), get_incident_tets() and
+	 *  copy_Laguerre_cell_from_Delaunay() do not, until the next compute(),
+	 *  which reallocates everything.
+	 */
+	void release_construction_buffers(bool keep_adjacency);
+
+	/**
+	 * \brief Bytes allocated by the tet stores, the vertex to tet maps
+	 *  and the construction buffers (the threads' scratch excluded).
+	 */
+	size_t memory_bytes() const;
+
+	/**
+	 * \brief Order in which the real vertices are inserted, as computed
+	 *  by set_vertices(): the BRIO order, or the identity if reordering
+	 *  is disabled. Has nb_vertices_non_periodic() entries.
+	 */
+	const index_t* insertion_order() const {
+	    return reorder_.data();
+	}
+
+	/**
+	 * \brief Bounds of the BRIO levels in insertion_order(), see
+	 *  set_BRIO_levels().
+	 */
+	const vector<index_t>& BRIO_levels() const {
+	    return levels_;
+	}
+
         void use_exact_predicates_for_convex_cell(bool x) {
             convex_cell_exact_predicates_ = x;
         }
@@ -10763,40 +10870,15 @@ namespace GEO {
 
         index_t nb_reallocations_;
 
-        bool convex_cell_exact_predicates_;
-
-	struct Stats {
-
-	    Stats();
-
-	    void reset();
-
-	    std::string to_string() {
-		return raw_ ? to_string_raw() : to_string_pretty();
-	    }
-
-	    std::string to_string_raw() const;
-	    std::string to_string_pretty() const;
-
-	    bool raw_;
-
-	    double  total_t_;
+        index_t max_threads_;
 
-	    double  phase_0_t_;
+        // True while the insertion threads run concurrently (then they
+        // cannot grow the tet stores), see set_max_threads().
+        bool threads_running_;
 
-	    double  phase_I_t_;
-	    double  phase_I_classify_t_;
-	    index_t phase_I_nb_inside_;
-	    index_t phase_I_nb_cross_;
-	    index_t phase_I_nb_outside_;
-	    double  phase_I_insert_t_;
-	    index_t phase_I_insert_nb_;
+        bool convex_cell_exact_predicates_;
 
-	    double  phase_II_t_;
-	    double  phase_II_classify_t_;
-	    double  phase_II_insert_t_;
-	    index_t phase_II_insert_nb_;
-	} stats_;
+	Stats stats_;
 
 	friend class LaguerreDiagramOmegaSimple3d;
     };
@@ -0,0 +1,905 @@
+/**
+ * acuteness.cpp
+ * 
+ * Cell acuteness kernels, shared by the WASM module (acuteness_wasm.cpp) and
+ * the native library and CLI.
+ *
+ * Build for wasm with -msimd128 to enable the wasm SIMD kernel; elsewhere the
+ * same kernel runs with scalar lanes, which the compiler vectorizes for the
+ * host (-march=native in the native build). Natively and in the pthreads
+ * WASM build the cells are spread over the PSM's thread pool.
+ */
+
+#include "acuteness.h"
+#include <cmath>
+#include <algorithm>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define ACUTENESS_USE_GEO_THREADS
+#endif
+
+#ifdef ACUTENESS_USE_GEO_THREADS
+#include "Delaunay_psm.h"
+#endif
+
+// Largest maxNeighbors kept on the stack; more neighbors use the heap
+// scratch of CellScratch.
+const int MAX_STACK_NEIGHBORS = 16;
+
+// Runs f(begin, end) over [0, count), on the PSM's thread pool when there
+// are enough items for the threads to pay off.
+template <class F>
+static void forEachSlice(int count, const F& f) {
+#ifdef ACUTENESS_USE_GEO_THREADS
+    // Below this many items the threads cost more than they save.
+    const int MIN_PARALLEL_ITEMS = 256;
+    if (count >= MIN_PARALLEL_ITEMS) {
+        GEO::initialize();
+        GEO::parallel_for_slice(0, GEO::index_t(count), [&](GEO::index_t begin, GEO::index_t end) {
+            f(int(begin), int(end));
+        });
+        return;
+    }
+#endif
+    f(0, count);
+}
+
+// Structure-of-arrays copy of the cell being scored, padded to a multiple
+// of 4 lanes. Grown once per thread and reused for every cell.
+struct CellScratch {
+    std::vector<float> x, y, z, distSq;
+    // Neighbor scratch above MAX_STACK_NEIGHBORS
+    std::vector<float> bestDist, nx, ny, nz, nl;
+    std::vector<int> bestIdx;
+    
+    void reserveNeighbors(int numNeighbors) {
+        size_t padded = size_t(numNeighbors) + 3;
+        if (nx.size() < padded) {
+            bestDist.resize(padded);
+            bestIdx.resize(padded);
+            nx.resize(padded);
+            ny.resize(padded);
+            nz.resize(padded);
+            nl.resize(padded);
+        }
+    }
+    
+    void load(const std::vector<float>& vertices, int start, int cellSize) {
+        size_t padded = size_t((cellSize + 3) & ~3);
+        if (x.size() < padded) {
+            x.resize(padded);
+            y.resize(padded);
+            z.resize(padded);
+            distSq.resize(padded);
+        }
+        for (int v = 0; v < cellSize; v++) {
+            x[v] = vertices[start + v * 3];
+            y[v] = vertices[start + v * 3 + 1];
+            z[v] = vertices[start + v * 3 + 2];
+        }
+        for (size_t v = size_t(cellSize); v < padded; v++) {
+            x[v] = y[v] = z[v] = 0.0f;
+        }
+    }
+};
+
+static thread_local CellScratch g_cellScratch;
+
+// Squared distances from vertex c to every vertex of the cell, 4 at a time.
+static void computeDistances(CellScratch& cell, int cellSize, int c) {
+    const float cx = cell.x[c], cy = cell.y[c], cz = cell.z[c];
+#ifdef __wasm_simd128__
+    const v128_t vcx = wasm_f32x4_splat(cx);
+    const v128_t vcy = wasm_f32x4_splat(cy);
+    const v128_t vcz = wasm_f32x4_splat(cz);
+    for (int i = 0; i < cellSize; i += 4) {
+        v128_t dx = wasm_f32x4_sub(wasm_v128_load(&cell.x[i]), vcx);
+        v128_t dy = wasm_f32x4_sub(wasm_v128_load(&cell.y[i]), vcy);
+        v128_t dz = wasm_f32x4_sub(wasm_v128_load(&cell.z[i]), vcz);
+        v128_t d2 = wasm_f32x4_add(
+            wasm_f32x4_add(wasm_f32x4_mul(dx, dx), wasm_f32x4_mul(dy, dy)),
+            wasm_f32x4_mul(dz, dz));
+        wasm_v128_store(&cell.distSq[i], d2);
+    }
+#else
+    for (int i = 0; i < cellSize; i++) {
+        float dx = cell.x[i] - cx, dy = cell.y[i] - cy, dz = cell.z[i] - cz;
+        cell.distSq[i] = dx * dx + dy * dy + dz * dz;
+    }
+#endif
+}
+
+// Number of acute angles between pairs of the k neighbor vectors
+// (nx, ny, nz, with squared lengths nl, padded up to a multiple of 4 with
+// zero vectors of unit nl). The angle between two vectors is below HALF_PI
+// exactly when their dot product is positive, so no acos is needed (this
+// only differs from acos(...) < 1.5707963f within 1e-7 rad of 90 degrees).
+// Zero-length vectors count as acute, as they always have.
+static int countAcutePairs(const float* nx, const float* ny, const float* nz,
+                           const float* nl, int k) {
+    int acute = 0;
+    for (int j = 0; j < k; j++) {
+        if (nl[j] == 0.0f) {
+            acute += k - 1 - j;
+            continue;
+        }
+#ifdef __wasm_simd128__
+        const v128_t jx = wasm_f32x4_splat(nx[j]);
+        const v128_t jy = wasm_f32x4_splat(ny[j]);
+        const v128_t jz = wasm_f32x4_splat(nz[j]);
+        const v128_t zero = wasm_f32x4_splat(0.0f);
+        const v128_t lanes = wasm_i32x4_make(0, 1, 2, 3);
+        v128_t counts = wasm_i32x4_splat(0);
+        for (int i = j + 1; i < k; i += 4) {
+            v128_t dot = wasm_f32x4_add(
+                wasm_f32x4_add(wasm_f32x4_mul(jx, wasm_v128_load(&nx[i])),
+                               wasm_f32x4_mul(jy, wasm_v128_load(&ny[i]))),
+                wasm_f32x4_mul(jz, wasm_v128_load(&nz[i])));
+            v128_t isAcute = wasm_v128_or(wasm_f32x4_gt(dot, zero),
+                                          wasm_f32x4_eq(wasm_v128_load(&nl[i]), zero));
+            // Lanes at or past k are padding.
+            isAcute = wasm_v128_and(isAcute, wasm_i32x4_lt(lanes, wasm_i32x4_splat(k - i)));
+            counts = wasm_i32x4_sub(counts, isAcute);  // true lanes are -1
+        }
+        acute += wasm_i32x4_extract_lane(counts, 0) + wasm_i32x4_extract_lane(counts, 1) +
+                 wasm_i32x4_extract_lane(counts, 2) + wasm_i32x4_extract_lane(counts, 3);
+#else
+        for (int i = j + 1; i < k; i++) {
+            float dot = nx[j] * nx[i] + ny[j] * ny[i] + nz[j] * nz[i];
+            if (dot > 0.0f || nl[i] == 0.0f) {
+                acute++;
+            }
+        }
+#endif
+    }
+    return acute;
+}
+
+int cellAcutenessScore(
+    const std::vector<float>& vertices,
+    int start,
+    int end,
+    int maxNeighbors
+) {
+    int cellSize = (end - start) / 3;  // 3 floats per vertex
+    
+    if (cellSize < 4) {
+        return 0;
+    }
+    
+    CellScratch& cell = g_cellScratch;
+    cell.load(vertices, start, cellSize);
+    
+    const int numNeighbors = std::max(0, std::min(maxNeighbors, cellSize - 1));
+    int acuteAngles = 0;
+    
+    // Nearest neighbors by (distance, index), kept sorted, and their vectors
+    // in SoA, padded for the 4-lane pair loop
+    float stackDist[MAX_STACK_NEIGHBORS], stackX[MAX_STACK_NEIGHBORS + 3];
+    float stackY[MAX_STACK_NEIGHBORS + 3], stackZ[MAX_STACK_NEIGHBORS + 3];
+    float stackL[MAX_STACK_NEIGHBORS + 3];
+    int stackIdx[MAX_STACK_NEIGHBORS];
+    float *bestDist = stackDist, *nx = stackX, *ny = stackY, *nz = stackZ, *nl = stackL;
+    int* bestIdx = stackIdx;
+    if (numNeighbors > MAX_STACK_NEIGHBORS) {
+        cell.reserveNeighbors(numNeighbors);
+        bestDist = cell.bestDist.data();
+        bestIdx = cell.bestIdx.data();
+        nx = cell.nx.data();
+        ny = cell.ny.data();
+        nz = cell.nz.data();
+        nl = cell.nl.data();
+    }
+    
+    // For each vertex in the cell
+    for (int v = 0; v < cellSize; v++) {
+        computeDistances(cell, cellSize, v);
+        
+        int found = 0;
+        for (int other = 0; other < cellSize && numNeighbors > 0; other++) {
+            if (other == v) continue;
+            float d = cell.distSq[other];
+            if (found == numNeighbors && !(d < bestDist[found - 1])) continue;
+            int pos = found < numNeighbors ? found++ : found - 1;
+            while (pos > 0 && d < bestDist[pos - 1]) {
+                bestDist[pos] = bestDist[pos - 1];
+                bestIdx[pos] = bestIdx[pos - 1];
+                pos--;
+            }
+            bestDist[pos] = d;
+            bestIdx[pos] = other;
+        }
+        
+        for (int j = 0; j < numNeighbors; j++) {
+            int o = bestIdx[j];
+            nx[j] = cell.x[o] - cell.x[v];
+            ny[j] = cell.y[o] - cell.y[v];
+            nz[j] = cell.z[o] - cell.z[v];
+            nl[j] = bestDist[j];
+        }
+        for (int j = numNeighbors; j < numNeighbors + 3; j++) {
+            nx[j] = ny[j] = nz[j] = 0.0f;
+            nl[j] = 1.0f;
+        }
+        
+        acuteAngles += countAcutePairs(nx, ny, nz, nl, numNeighbors);
+    }
+    
+    return acuteAngles / cellSize;  // Normalized score
+}
+
+int calculateCellAcutenessInto(
+    const std::vector<float>& vertices,  // Flat array of vertices
+    const std::vector<int>& cellIndices,  // Indices marking cell boundaries
+    std::vector<int>& scores,
+    int maxNeighbors
+) {
+    if (cellIndices.size() < 2) {
+        scores.clear();
+        return 0;
+    }
+    const int numCells = int(cellIndices.size()) - 1;
+    scores.resize(numCells);
+    
+    forEachSlice(numCells, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            scores[i] = cellAcutenessScore(vertices, cellIndices[i], cellIndices[i + 1], maxNeighbors);
+        }
+    });
+    return numCells;
+}
+
+std::vector<int> calculateCellAcuteness(
+    const std::vector<float>& vertices,
+    const std::vector<int>& cellIndices,
+    int maxNeighbors
+) {
+    std::vector<int> scores;
+    calculateCellAcutenessInto(vertices, cellIndices, scores, maxNeighbors);
+    return scores;
+}
+
+int updateCellAcuteness(
+    const std::vector<float>& vertices,
+    const std::vector<int>& cellIndices,
+    const std::vector<int>& changedCells,  // Indices of cells that changed
+    std::vector<int>& scores,              // Previous scores, updated in place
+    int maxNeighbors
+) {
+    if (cellIndices.size() < 2) {
+        scores.clear();
+        return 0;
+    }
+    int numCells = int(cellIndices.size()) - 1;
+    if (int(scores.size()) != numCells) {
+        scores.resize(numCells, 0);
+    }
+    
+    int updated = 0;
+    for (int cellIdx : changedCells) {
+        if (cellIdx < 0 || cellIdx >= numCells) continue;
+        
+        scores[cellIdx] = cellAcutenessScore(vertices, cellIndices[cellIdx], cellIndices[cellIdx + 1], maxNeighbors);
+        updated++;
+    }
+    
+    return updated;
+}
+
+// --- Geometry acuteness (GeometryAnalysis.js) ---
+
+// Points (or barycenters) this close to a face of the box get damped scores
+// in non-periodic mode.
+const double BOUNDARY_THRESHOLD = 0.1;
+
+// A Delaunay edge (a, b), a < b, in the list of a.
+struct EdgeNode {
+    int a, b;
+    int next;
+    int rawCount;  // occurrences in the tets
+};
+
+// A Delaunay triangle (a, b, c), a < b < c, in the list of a, with its
+// first two tets.
+struct TriangleNode {
+    int b, c;
+    int next;
+    int count;
+    int tets[2];
+};
+
+// Edge and triangle lists of buildGeometryTopology(), and the topology and
+// barycenters of analyzeGeometryAcutenessInto(), grown once per thread and
+// reused.
+struct GeometryScratch {
+    std::vector<int> edgeHead, triangleHead;
+    std::vector<EdgeNode> edges;
+    std::vector<TriangleNode> triangles;
+    std::vector<int> occurrenceEdge;  // edge of each (tet, local edge)
+    std::vector<int> edgeTetPtr, edgeTets, edgeTetCount;
+    std::vector<int> cursor;
+    GeometryTopology topology;
+    std::vector<double> barycenters;
+};
+
+static thread_local GeometryScratch g_geometryScratch;
+
+static bool isNearBox(const double* p) {
+    for (int c = 0; c < 3; c++) {
+        if (p[c] < BOUNDARY_THRESHOLD || p[c] > 1 - BOUNDARY_THRESHOLD) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Math.round() of a non-negative score.
+static int roundScore(double score) {
+    return int(std::floor(score + 0.5));
+}
+
+// calculateAngle(a, b) < PI / 2 in GeometryAnalysis.js: zero vectors count
+// as acute, other pairs by the sign of their dot product (see
+// countAcutePairs).
+static inline bool isAcute(const double* a, const double* b) {
+    if (a[0] * a[0] + a[1] * a[1] + a[2] * a[2] == 0.0 ||
+        b[0] * b[0] + b[1] * b[1] + b[2] * b[2] == 0.0) {
+        return true;
+    }
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] > 0.0;
+}
+
+static inline void difference(const double* a, const double* b, double* out) {
+    out[0] = a[0] - b[0];
+    out[1] = a[1] - b[1];
+    out[2] = a[2] - b[2];
+}
+
+// Index of edge (a, b) in the list of a, appended if missing.
+static int findOrAddEdge(GeometryScratch& g, int a, int b) {
+    for (int e = g.edgeHead[a]; e >= 0; e = g.edges[e].next) {
+        if (g.edges[e].b == b) {
+            return e;
+        }
+    }
+    const int e = int(g.edges.size());
+    g.edges.push_back({a, b, g.edgeHead[a], 0});
+    g.edgeHead[a] = e;
+    return e;
+}
+
+// Records tet t as one of the tets of triangle (a, b, c).
+static void addTriangle(GeometryScratch& g, int a, int b, int c, int t) {
+    int f = g.triangleHead[a];
+    while (f >= 0 && !(g.triangles[f].b == b && g.triangles[f].c == c)) {
+        f = g.triangles[f].next;
+    }
+    if (f < 0) {
+        f = int(g.triangles.size());
+        g.triangles.push_back({b, c, g.triangleHead[a], 0, {-1, -1}});
+        g.triangleHead[a] = f;
+    }
+    TriangleNode& triangle = g.triangles[f];
+    if (triangle.count < 2) {
+        triangle.tets[triangle.count] = t;
+    }
+    triangle.count++;
+}
+
+// _computeVoronoiBarycentric().
+void geometryBarycenter(const double* points, const int* tet, bool isPeriodic, double* out) {
+    const double* ref = &points[size_t(tet[0]) * 3];
+    for (int c = 0; c < 3; c++) {
+        double sum = ref[c];
+        for (int k = 1; k < 4; k++) {
+            double value = points[size_t(tet[k]) * 3 + c];
+            if (isPeriodic) {
+                const double diff = value - ref[c];
+                if (diff > 0.5) value -= 1.0;
+                else if (diff < -0.5) value += 1.0;
+            }
+            sum += value;
+        }
+        double center = sum / 4;
+        if (isPeriodic) {
+            while (center < 0) center += 1.0;
+            while (center >= 1) center -= 1.0;
+        }
+        out[c] = center;
+    }
+}
+
+// vertexAcuteness(): the 3 angles between the edges at each corner.
+static int tetVertexScore(const double* points, const int* tet) {
+    int acute = 0;
+    for (int j = 0; j < 4; j++) {
+        const double* center = &points[size_t(tet[j]) * 3];
+        double edges[3][3];
+        for (int k = 0, o = 0; k < 4; k++) {
+            if (k != j) {
+                difference(&points[size_t(tet[k]) * 3], center, edges[o++]);
+            }
+        }
+        acute += isAcute(edges[0], edges[1]) + isAcute(edges[1], edges[2]) +
+                 isAcute(edges[2], edges[0]);
+    }
+    return acute;
+}
+
+// Vertices of one face or cell, grown once per thread.
+struct PolyScratch {
+    std::vector<double> xyz;
+    std::vector<double> distSq;
+    std::vector<std::pair<double, int>> angles;
+};
+
+static thread_local PolyScratch g_polyScratch;
+
+// faceAcuteness() of the face whose vertices are the barycenters of tets
+// [tets, tets + m): the getFaces() polygon (minimum image of the first
+// vertex, sorted by angle around the centroid) and its acute interior
+// angles.
+static int faceScore(const double* barycenters, const int* tets, int m, bool isPeriodic) {
+    PolyScratch& face = g_polyScratch;
+    face.xyz.resize(size_t(m) * 3);
+    double* xyz = face.xyz.data();
+    for (int i = 0; i < m; i++) {
+        const double* b = &barycenters[size_t(tets[i]) * 3];
+        for (int c = 0; c < 3; c++) {
+            double value = b[c];
+            if (isPeriodic && i > 0) {
+                const double delta = value - xyz[c];
+                if (delta > 0.5) value -= 1.0;
+                else if (delta < -0.5) value += 1.0;
+            }
+            xyz[i * 3 + c] = value;
+        }
+    }
+    double centroid[3] = {0.0, 0.0, 0.0};
+    for (int i = 0; i < m; i++) {
+        for (int c = 0; c < 3; c++) {
+            centroid[c] = centroid[c] + xyz[i * 3 + c] / m;
+        }
+    }
+
+    // _sortVerticesByAngle(): angles in the plane of the first vertex and
+    // the first one not collinear with it, if any.
+    double v1[3], v2[3];
+    difference(xyz, centroid, v1);
+    bool planar = false;
+    for (int i = 1; i < m && !planar; i++) {
+        difference(&xyz[i * 3], centroid, v2);
+        const double cross[3] = {v1[1] * v2[2] - v1[2] * v2[1],
+                                 v1[2] * v2[0] - v1[0] * v2[2],
+                                 v1[0] * v2[1] - v1[1] * v2[0]};
+        planar = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]) > 1e-6;
+    }
+    face.angles.resize(size_t(m));
+    for (int i = 0; i < m; i++) {
+        double v[3];
+        difference(&xyz[i * 3], centroid, v);
+        face.angles[i].first = planar ?
+            std::atan2(v[0] * v2[0] + v[1] * v2[1] + v[2] * v2[2],
+                       v[0] * v1[0] + v[1] * v1[1] + v[2] * v1[2]) : 0.0;
+        face.angles[i].second = i;
+    }
+    // By (angle, index): the order of the JS stable sort.
+    std::sort(face.angles.begin(), face.angles.end());
+
+    int acute = 0;
+    for (int i = 0; i < m; i++) {
+        const double* prev = &xyz[size_t(face.angles[(i + m - 1) % m].second) * 3];
+        const double* curr = &xyz[size_t(face.angles[i].second) * 3];
+        const double* next = &xyz[size_t(face.angles[(i + 1) % m].second) * 3];
+        double toPrev[3], toNext[3];
+        difference(prev, curr, toPrev);
+        difference(next, curr, toNext);
+        acute += isAcute(toPrev, toNext);
+    }
+    return acute;
+}
+
+// cellAcuteness() of a cell whose vertices are the barycenters of tets
+// [tets, tets + m): angles between each vertex and its 3 nearest ones.
+static int cellScore(const double* barycenters, const int* tets, int m) {
+    if (m < 4) {
+        return 0;
+    }
+    PolyScratch& cell = g_polyScratch;
+    cell.xyz.resize(size_t(m) * 3);
+    cell.distSq.resize(size_t(m) * size_t(m));
+    double* xyz = cell.xyz.data();
+    double* distSq = cell.distSq.data();
+    for (int i = 0; i < m; i++) {
+        std::copy(&barycenters[size_t(tets[i]) * 3], &barycenters[size_t(tets[i]) * 3] + 3, &xyz[i * 3]);
+    }
+    // Symmetric distance matrix, each pair once.
+    for (int i = 0; i < m; i++) {
+        for (int j = i + 1; j < m; j++) {
+            double d[3];
+            difference(&xyz[j * 3], &xyz[i * 3], d);
+            distSq[i * m + j] = distSq[j * m + i] = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+        }
+    }
+    int acute = 0;
+    for (int i = 0; i < m; i++) {
+        // 3 nearest by (distance, index), as after the JS stable sort
+        const double* row = &distSq[i * m];
+        double bestDist[3];
+        int best[3];
+        int found = 0;
+        for (int j = 0; j < m; j++) {
+            if (j == i) continue;
+            const double dist = row[j];
+            if (found == 3 && !(dist < bestDist[2])) continue;
+            int pos = found < 3 ? found++ : 2;
+            while (pos > 0 && dist < bestDist[pos - 1]) {
+                bestDist[pos] = bestDist[pos - 1];
+                best[pos] = best[pos - 1];
+                pos--;
+            }
+            bestDist[pos] = dist;
+            best[pos] = j;
+        }
+        double toNeighbor[3][3];
+        for (int k = 0; k < 3; k++) {
+            difference(&xyz[best[k] * 3], &xyz[i * 3], toNeighbor[k]);
+        }
+        acute += isAcute(toNeighbor[0], toNeighbor[1]) + isAcute(toNeighbor[0], toNeighbor[2]) +
+                 isAcute(toNeighbor[1], toNeighbor[2]);
+    }
+    return acute;
+}
+
+// cellAcuteness() damping of a cell near the box: stronger in the corners
+// and for high scores.
+static int dampCellScore(const double* point, int score) {
+    double boundaryScore = 0.0;
+    int numBoundaries = 0;
+    for (int c = 0; c < 3; c++) {
+        if (point[c] < BOUNDARY_THRESHOLD) {
+            boundaryScore += (BOUNDARY_THRESHOLD - point[c]) / BOUNDARY_THRESHOLD;
+            numBoundaries++;
+        } else if (point[c] > 1 - BOUNDARY_THRESHOLD) {
+            boundaryScore += (point[c] - (1 - BOUNDARY_THRESHOLD)) / BOUNDARY_THRESHOLD;
+            numBoundaries++;
+        }
+    }
+    if (numBoundaries == 0) {
+        return score;
+    }
+    boundaryScore = boundaryScore / numBoundaries;
+    const double baseFactor = 0.7 + (0.3 * (1 - boundaryScore));
+    const double scoreFactor = 1.0 - (0.3 * std::min(score / 50.0, 1.0));
+    return roundScore(score * (baseFactor * scoreFactor));
+}
+
+void buildGeometryTopology(
+    const int* tets,
+    int numTets,
+    int numPoints,
+    GeometryTopology& topology
+) {
+    static const int TET_EDGES[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+    static const int TET_TRIANGLES[4][3] = {{0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3}};
+    GeometryScratch& g = g_geometryScratch;
+    const int n = std::max(numPoints, 0);
+    const int T = std::max(numTets, 0);
+    GeometryTopology& topo = topology;
+    topo.numPoints = n;
+    topo.numTets = T;
+
+    // One pass over the tets: the Delaunay edges and triangles numbered in
+    // first-seen order, like the JS maps.
+    topo.pointTetPtr.assign(size_t(n) + 1, 0);
+    g.edgeHead.assign(size_t(n), -1);
+    g.triangleHead.assign(size_t(n), -1);
+    g.edges.clear();
+    g.triangles.clear();
+    g.occurrenceEdge.resize(size_t(T) * 6);
+    for (int t = 0; t < T; t++) {
+        const int* tet = &tets[size_t(t) * 4];
+        for (int k = 0; k < 4; k++) {
+            topo.pointTetPtr[size_t(tet[k]) + 1]++;
+        }
+        for (int k = 0; k < 6; k++) {
+            const int a = tet[TET_EDGES[k][0]], b = tet[TET_EDGES[k][1]];
+            const int e = findOrAddEdge(g, std::min(a, b), std::max(a, b));
+            g.edges[e].rawCount++;
+            g.occurrenceEdge[size_t(t) * 6 + k] = e;
+        }
+        for (int k = 0; k < 4; k++) {
+            int v[3] = {tet[TET_TRIANGLES[k][0]], tet[TET_TRIANGLES[k][1]], tet[TET_TRIANGLES[k][2]]};
+            std::sort(v, v + 3);
+            addTriangle(g, v[0], v[1], v[2], t);
+        }
+    }
+
+    // Point -> tets and Delaunay edge -> tets, both in tet order.
+    for (int v = 0; v < n; v++) {
+        topo.pointTetPtr[v + 1] += topo.pointTetPtr[v];
+    }
+    topo.pointTets.resize(size_t(topo.pointTetPtr[n]));
+    g.cursor.assign(topo.pointTetPtr.begin(), topo.pointTetPtr.end() - 1);
+    for (int t = 0; t < T; t++) {
+        for (int k = 0; k < 4; k++) {
+            topo.pointTets[size_t(g.cursor[size_t(tets[size_t(t) * 4 + k])]++)] = t;
+        }
+    }
+    const int numEdges = int(g.edges.size());
+    g.edgeTetPtr.resize(size_t(numEdges) + 1);
+    g.edgeTetPtr[0] = 0;
+    for (int e = 0; e < numEdges; e++) {
+        g.edgeTetPtr[e + 1] = g.edgeTetPtr[e] + g.edges[e].rawCount;
+    }
+    g.edgeTets.resize(size_t(g.edgeTetPtr[numEdges]));
+    // Each tet once per edge, even a tet with a repeated vertex, as the JS
+    // faces take them.
+    g.edgeTetCount.assign(size_t(numEdges), 0);
+    for (int t = 0; t < T; t++) {
+        for (int k = 0; k < 6; k++) {
+            const int e = g.occurrenceEdge[size_t(t) * 6 + k];
+            int* list = &g.edgeTets[size_t(g.edgeTetPtr[e])];
+            int& count = g.edgeTetCount[e];
+            if (count == 0 || list[count - 1] != t) {
+                list[count++] = t;
+            }
+        }
+    }
+
+    // Faces: the Delaunay edges with 3+ tets, in first-seen order.
+    topo.faceEndpoints.clear();
+    topo.faceTetPtr.assign(1, 0);
+    topo.faceTets.clear();
+    for (int e = 0; e < numEdges; e++) {
+        if (g.edges[e].rawCount >= 2 && g.edgeTetCount[e] >= 3) {
+            topo.faceEndpoints.push_back(g.edges[e].a);
+            topo.faceEndpoints.push_back(g.edges[e].b);
+            const int* list = &g.edgeTets[size_t(g.edgeTetPtr[e])];
+            topo.faceTets.insert(topo.faceTets.end(), list, list + g.edgeTetCount[e]);
+            topo.faceTetPtr.push_back(int(topo.faceTets.size()));
+        }
+    }
+
+    // Voronoi edges: the triangles of exactly 2 tets, in first-seen order.
+    // Unique tets never share two triangles, so no pair is repeated.
+    topo.voronoiEdgeTets.clear();
+    for (const TriangleNode& triangle : g.triangles) {
+        if (triangle.count == 2) {
+            topo.voronoiEdgeTets.push_back(triangle.tets[0]);
+            topo.voronoiEdgeTets.push_back(triangle.tets[1]);
+        }
+    }
+    const int numVoronoiEdges = int(topo.voronoiEdgeTets.size() / 2);
+    topo.tetEdgePtr.assign(size_t(T) + 1, 0);
+    for (int k = 0; k < numVoronoiEdges * 2; k++) {
+        topo.tetEdgePtr[size_t(topo.voronoiEdgeTets[k]) + 1]++;
+    }
+    for (int t = 0; t < T; t++) {
+        topo.tetEdgePtr[t + 1] += topo.tetEdgePtr[t];
+    }
+    topo.tetEdges.resize(size_t(topo.tetEdgePtr[T]));
+    g.cursor.assign(topo.tetEdgePtr.begin(), topo.tetEdgePtr.end() - 1);
+    for (int k = 0; k < numVoronoiEdges * 2; k++) {
+        topo.tetEdges[size_t(g.cursor[size_t(topo.voronoiEdgeTets[k])]++)] = k / 2;
+    }
+}
+
+int geometryVertexScore(const double* points, const int* tet, bool isPeriodic) {
+    const int score = tetVertexScore(points, tet);
+    if (isPeriodic) {
+        return score;
+    }
+    for (int k = 0; k < 4; k++) {
+        if (isNearBox(&points[size_t(tet[k]) * 3])) {
+            return roundScore(score * 0.6);
+        }
+    }
+    return score;
+}
+
+int geometryFaceScore(
+    const double* points,
+    const double* barycenters,
+    const GeometryTopology& topology,
+    int f,
+    bool isPeriodic
+) {
+    const int begin = topology.faceTetPtr[f];
+    int score = faceScore(barycenters, &topology.faceTets[size_t(begin)],
+                          topology.faceTetPtr[f + 1] - begin, isPeriodic);
+    const int* ends = &topology.faceEndpoints[size_t(f) * 2];
+    if (!isPeriodic && (isNearBox(&points[size_t(ends[0]) * 3]) ||
+                        isNearBox(&points[size_t(ends[1]) * 3]))) {
+        score = roundScore(score * 0.6);
+    }
+    return score;
+}
+
+int geometryCellScore(
+    const double* points,
+    const double* barycenters,
+    const GeometryTopology& topology,
+    int v,
+    bool isPeriodic
+) {
+    const int begin = topology.pointTetPtr[v];
+    const int m = topology.pointTetPtr[v + 1] - begin;
+    int score = cellScore(barycenters, &topology.pointTets[size_t(begin)], m);
+    if (!isPeriodic && m >= 4) {
+        score = dampCellScore(&points[size_t(v) * 3], score);
+    }
+    return score;
+}
+
+int geometryEdgeScore(
+    const double* barycenters,
+    const GeometryTopology& topology,
+    int e,
+    bool isPeriodic
+) {
+    const int* ends = &topology.voronoiEdgeTets[size_t(e) * 2];
+    int acute = 0;
+    for (int side = 0; side < 2; side++) {
+        // Directions away from the shared barycenter
+        const int t = ends[side];
+        const double* at = &barycenters[size_t(t) * 3];
+        double dir[3];
+        difference(&barycenters[size_t(ends[1 - side]) * 3], at, dir);
+        for (int k = topology.tetEdgePtr[t]; k < topology.tetEdgePtr[t + 1]; k++) {
+            const int e2 = topology.tetEdges[k];
+            if (e2 == e) continue;
+            const int* ends2 = &topology.voronoiEdgeTets[size_t(e2) * 2];
+            double dir2[3];
+            difference(&barycenters[size_t(ends2[0] == t ? ends2[1] : ends2[0]) * 3], at, dir2);
+            acute += isAcute(dir, dir2);
+        }
+    }
+    if (!isPeriodic && (isNearBox(&barycenters[size_t(ends[0]) * 3]) ||
+                        isNearBox(&barycenters[size_t(ends[1]) * 3]))) {
+        acute = roundScore(acute * 0.6);
+    }
+    return acute;
+}
+
+void analyzeGeometryAcutenessInto(
+    const double* points,
+    int numPoints,
+    const int* tets,
+    int numTets,
+    bool isPeriodic,
+    GeometryAcutenessScores& scores,
+    const double* centers
+) {
+    GeometryScratch& g = g_geometryScratch;
+    const GeometryTopology& topo = g.topology;
+    buildGeometryTopology(tets, numTets, numPoints, g.topology);
+    const int T = topo.numTets;
+
+    // Barycenters (unless given) and vertex scores, by tet.
+    if (!centers) {
+        g.barycenters.resize(size_t(T) * 3);
+    }
+    scores.vertexScores.resize(size_t(T));
+    forEachSlice(T, [&](int begin, int end) {
+        for (int t = begin; t < end; t++) {
+            const int* tet = &tets[size_t(t) * 4];
+            if (!centers) {
+                geometryBarycenter(points, tet, isPeriodic, &g.barycenters[size_t(t) * 3]);
+            }
+            scores.vertexScores[t] = geometryVertexScore(points, tet, isPeriodic);
+        }
+    });
+    const double* barycenters = centers ? centers : g.barycenters.data();
+
+    scores.faceScores.resize(size_t(topo.numFaces()));
+    forEachSlice(topo.numFaces(), [&](int begin, int end) {
+        for (int f = begin; f < end; f++) {
+            scores.faceScores[f] = geometryFaceScore(points, barycenters, topo, f, isPeriodic);
+        }
+    });
+
+    // Cells, by point index.
+    scores.cellScores.resize(size_t(topo.numPoints));
+    forEachSlice(topo.numPoints, [&](int begin, int end) {
+        for (int v = begin; v < end; v++) {
+            scores.cellScores[v] = geometryCellScore(points, barycenters, topo, v, isPeriodic);
+        }
+    });
+
+    scores.edgeScores.resize(size_t(topo.numVoronoiEdges()));
+    forEachSlice(topo.numVoronoiEdges(), [&](int begin, int end) {
+        for (int e = begin; e < end; e++) {
+            scores.edgeScores[e] = geometryEdgeScore(barycenters, topo, e, isPeriodic);
+        }
+    });
+}
+
+// --- 2D kernels ---
+
+int polygonAcuteAngles2d(const double* xy, int count) {
+    int acute = 0;
+    for (int k = 0; k < count; k++) {
+        const double* prev = &xy[size_t((k + count - 1) % count) * 2];
+        const double* v = &xy[size_t(k) * 2];
+        const double* next = &xy[size_t((k + 1) % count) * 2];
+        const double dot = (prev[0] - v[0]) * (next[0] - v[0]) + (prev[1] - v[1]) * (next[1] - v[1]);
+        acute += dot > 0.0;
+    }
+    return acute;
+}
+
+int calculateCellAcuteness2dInto(
+    const double* vertices,
+    const int* cellVertexPtr,
+    int numCells,
+    std::vector<int>& scores
+) {
+    numCells = std::max(numCells, 0);
+    scores.resize(size_t(numCells));
+    forEachSlice(numCells, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            scores[i] = polygonAcuteAngles2d(&vertices[size_t(cellVertexPtr[i]) * 2],
+                                             cellVertexPtr[i + 1] - cellVertexPtr[i]);
+        }
+    });
+    return numCells;
+}
+
+int updateCellAcuteness2d(
+    const double* vertices,
+    const int* cellVertexPtr,
+    int numCells,
+    const std::vector<int>& changedCells,
+    std::vector<int>& scores
+) {
+    numCells = std::max(numCells, 0);
+    if (int(scores.size()) != numCells) {
+        scores.resize(size_t(numCells), 0);
+    }
+    int updated = 0;
+    for (int cellIdx : changedCells) {
+        if (cellIdx < 0 || cellIdx >= numCells) continue;
+        scores[cellIdx] = polygonAcuteAngles2d(&vertices[size_t(cellVertexPtr[cellIdx]) * 2],
+                                               cellVertexPtr[cellIdx + 1] - cellVertexPtr[cellIdx]);
+        updated++;
+    }
+    return updated;
+}
+
+void triangleAcutenessInto(
+    const double* points,
+    int numPoints,
+    const int* triangles,
+    int numTriangles,
+    bool isPeriodic,
+    std::vector<int>& scores
+) {
+    numTriangles = std::max(numTriangles, 0);
+    scores.resize(size_t(numTriangles));
+    forEachSlice(numTriangles, [&](int begin, int end) {
+        for (int t = begin; t < end; t++) {
+            const int* tri = &triangles[size_t(t) * 3];
+            double xy[6];
+            bool valid = true;
+            for (int k = 0; k < 3; k++) {
+                if (tri[k] < 0 || tri[k] >= numPoints) {
+                    valid = false;
+                    break;
+                }
+                for (int c = 0; c < 2; c++) {
+                    double x = points[size_t(tri[k]) * 2 + c];
+                    if (isPeriodic && k > 0) {
+                        x -= std::round(x - xy[c]);
+                    }
+                    xy[k * 2 + c] = x;
+                }
+            }
+            scores[t] = valid ? polygonAcuteAngles2d(xy, 3) : 0;
+        }
+    });
+}
@@ -0,0 +1,195 @@
+/**
+ * acuteness.h
+ *
+ * Cell acuteness kernels on flat float buffers. A cell is a run of xyz
+ * triplets in `vertices`; cellIndices[i]..cellIndices[i + 1] delimits cell i
+ * (in floats). Also the native version of the vertex / face / cell / edge
+ * analyses of GeometryAnalysis.js (analyzeGeometryAcutenessInto).
+ */
+
+#pragma once
+
+#include <vector>
+
+// Acuteness score of one cell, whose vertices are the floats
+// vertices[start, end) (3 floats per vertex). Shared by the full and the
+// incremental entry points so that both always agree.
+int cellAcutenessScore(
+    const std::vector<float>& vertices,
+    int start,
+    int end,
+    int maxNeighbors
+);
+
+// Optimized cell acuteness calculation, writing into `scores` in place.
+// Passing the same vector every frame keeps its storage, so steady-state
+// frames do not allocate. Returns the number of cells scored.
+int calculateCellAcutenessInto(
+    const std::vector<float>& vertices,  // Flat array of vertices
+    const std::vector<int>& cellIndices,  // Indices marking cell boundaries
+    std::vector<int>& scores,
+    int maxNeighbors
+);
+
+// Same as calculateCellAcutenessInto, returning a new vector.
+std::vector<int> calculateCellAcuteness(
+    const std::vector<float>& vertices,
+    const std::vector<int>& cellIndices,
+    int maxNeighbors = 6
+);
+
+// Batch processing for live updates - only recalculate changed cells.
+// `scores` is updated in place (pass the vector returned by a previous
+// calculateCellAcuteness call, or an empty one); it is resized to the
+// current cell count if needed. `changedCells` is typically
+// DelaunayContext::changed_cells(). Returns the number of cells recomputed.
+int updateCellAcuteness(
+    const std::vector<float>& vertices,
+    const std::vector<int>& cellIndices,
+    const std::vector<int>& changedCells,  // Indices of cells that changed
+    std::vector<int>& scores,              // Previous scores, updated in place
+    int maxNeighbors
+);
+
+// Scores of GeometryAnalysis.analyzeAcuteness(), with the same definitions
+// and in the same order as the JS analysis:
+//   vertexScores  one per tet: acute face angles at its 4 corners (0..12)
+//   faceScores    one per face of DelaunayComputation.getFaces(), i.e. per
+//                 Delaunay edge shared by 3+ tets in first-seen order: acute
+//                 interior angles of the polygon of the tets' barycenters
+//   cellScores    one per point: acute angles between each barycenter of its
+//                 cell and its 3 nearest ones
+//   edgeScores    one per DelaunayComputation.voronoiEdges entry (triangle
+//                 shared by exactly 2 tets, first-seen order): acute angles
+//                 with the other Voronoi edges at both ends
+// Non-periodic scores are damped near the faces of the box like the JS
+// ones.
+struct GeometryAcutenessScores {
+    std::vector<int> vertexScores;
+    std::vector<int> faceScores;
+    std::vector<int> cellScores;
+    std::vector<int> edgeScores;
+};
+
+// Computes the four analyses in one pass over the tets (barycenters, vertex
+// scores and the edge / triangle incidences), then one pass per face, cell
+// and Voronoi edge. points holds numPoints xyz triplets in the unit cube,
+// tets 4 point indices per tet, each in [0, numPoints). The Voronoi vertices
+// of the face, cell and edge scores are the tet barycenters, or the 3
+// coordinates per tet of `centers` if not null (e.g. the circumcenters of
+// compute_tet_centers(), wrapped into the box in periodic mode). The vectors
+// of `scores` are resized in place: passing the same struct every frame does
+// not allocate once they are sized.
+void analyzeGeometryAcutenessInto(
+    const double* points,
+    int numPoints,
+    const int* tets,
+    int numTets,
+    bool isPeriodic,
+    GeometryAcutenessScores& scores,
+    const double* centers = nullptr
+);
+
+// Incidences of the analyses above, from the tets alone, in the numbering
+// of GeometryAcutenessScores. Lets callers score single items (see
+// AnalysisCache) with the kernels of analyzeGeometryAcutenessInto().
+struct GeometryTopology {
+    int numPoints = 0;
+    int numTets = 0;
+    std::vector<int> pointTetPtr, pointTets;  // tets of each point, in tet order
+    std::vector<int> faceEndpoints;           // Delaunay edge (a, b), a < b, of each face
+    std::vector<int> faceTetPtr, faceTets;    // tets around each face, in tet order
+    std::vector<int> voronoiEdgeTets;         // the 2 tets of each Voronoi edge
+    std::vector<int> tetEdgePtr, tetEdges;    // Voronoi edges at each tet
+
+    int numFaces() const {
+        return int(faceEndpoints.size() / 2);
+    }
+
+    int numVoronoiEdges() const {
+        return int(voronoiEdgeTets.size() / 2);
+    }
+};
+
+// Fills `topology` (resized in place) for numTets tets of numPoints points.
+// Every tet index must be in [0, numPoints): callers validate foreign tets
+// first, as the analyzeGeometryAcuteness binding does.
+void buildGeometryTopology(
+    const int* tets,
+    int numTets,
+    int numPoints,
+    GeometryTopology& topology
+);
+
+// Barycenter of one tet, the Voronoi vertex of the analyses: in periodic
+// mode the other vertices are taken in the image of the first one and the
+// barycenter is wrapped back into the box.
+void geometryBarycenter(const double* points, const int* tet, bool isPeriodic, double* out);
+
+// Single scores of GeometryAcutenessScores: vertexScores[t] of tet `tet`,
+// faceScores[f], cellScores[v] and edgeScores[e]. barycenters holds those
+// of geometryBarycenter(), 3 per tet; only the tets of the item are read
+// (for a Voronoi edge, also those of the Voronoi edges at both ends).
+int geometryVertexScore(const double* points, const int* tet, bool isPeriodic);
+
+int geometryFaceScore(
+    const double* points,
+    const double* barycenters,
+    const GeometryTopology& topology,
+    int f,
+    bool isPeriodic
+);
+
+int geometryCellScore(
+    const double* points,
+    const double* barycenters,
+    const GeometryTopology& topology,
+    int v,
+    bool isPeriodic
+);
+
+int geometryEdgeScore(
+    const double* barycenters,
+    const GeometryTopology& topology,
+    int e,
+    bool isPeriodic
+);
+
+// --- 2D kernels (DelaunayContext2d) ---
+
+// Acute interior angles of a convex polygon of count xy vertices (0..3).
+int polygonAcuteAngles2d(const double* xy, int count);
+
+// Acuteness score of every 2D Voronoi cell: its acute interior angles.
+// Cell i is the xy vertices cellVertexPtr[i] to cellVertexPtr[i + 1] - 1 of
+// `vertices` (in vertices, not doubles), the layout of
+// DelaunayContext2d::voronoi_cells(). `scores` is resized in place.
+// Returns the number of cells scored.
+int calculateCellAcuteness2dInto(
+    const double* vertices,
+    const int* cellVertexPtr,
+    int numCells,
+    std::vector<int>& scores
+);
+
+// Same as calculateCellAcuteness2dInto, only for changedCells (typically
+// DelaunayContext2d::changed_cells()). Returns the number of cells recomputed.
+int updateCellAcuteness2d(
+    const double* vertices,
+    const int* cellVertexPtr,
+    int numCells,
+    const std::vector<int>& changedCells,
+    std::vector<int>& scores
+);
+
+// Acute corners of every Delaunay triangle (0..3, 3 for an acute triangle),
+// 3 point indices per triangle into numPoints xy pairs. In periodic mode
+// the corners are taken at the nearest images of the first vertex.
+void triangleAcutenessInto(
+    const double* points,
+    int numPoints,
+    const int* triangles,
+    int numTriangles,
+    bool isPeriodic,
+    std::vector<int>& scores
+);
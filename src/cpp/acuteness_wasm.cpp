@@ -1,154 +1,75 @@
 /**
  * acuteness_wasm.cpp
  * 
- * High-performance WASM implementation of acuteness calculations
+ * Embind bindings of the acuteness kernels (acuteness.cpp).
  * Designed for 1000+ points with live updates
  */
 
 #include <emscripten/bind.h>
+#include "acuteness.h"
+
 #include <vector>
-#include <cmath>
-#include <algorithm>
 
 using namespace emscripten;
 
-struct Vec3 {
-    float x, y, z;
-    
-    Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
-    
-    float dot(const Vec3& other) const {
-        return x * other.x + y * other.y + z * other.z;
-    }
-    
-    float lengthSquared() const {
-        return x * x + y * y + z * z;
-    }
-    
-    Vec3 operator-(const Vec3& other) const {
-        return Vec3(x - other.x, y - other.y, z - other.z);
-    }
-};
+namespace {
 
-// Fast angle calculation without expensive operations
-float calculateAngle(const Vec3& v1, const Vec3& v2) {
-    float dot = v1.dot(v2);
-    float len1Sq = v1.lengthSquared();
-    float len2Sq = v2.lengthSquared();
-    
-    if (len1Sq == 0 || len2Sq == 0) return 0;
-    
-    float cosTheta = dot / std::sqrt(len1Sq * len2Sq);
-    cosTheta = std::max(-1.0f, std::min(1.0f, cosTheta));
-    return std::acos(cosTheta);
-}
+// Inputs and scores of the last analyzeGeometryAcuteness() call, owned by
+// the module so that repeated calls do not reallocate.
+std::vector<double> g_geometryPoints;
+std::vector<int> g_geometryTets;
+std::vector<double> g_geometryCenters;
+GeometryAcutenessScores g_geometryScores;
 
-// Optimized cell acuteness calculation
-std::vector<int> calculateCellAcuteness(
-    const std::vector<float>& vertices,  // Flat array of vertices
-    const std::vector<int>& cellIndices,  // Indices marking cell boundaries
-    int maxNeighbors = 6
-) {
-    std::vector<int> scores;
-    const float HALF_PI = 1.5707963f;
-    
-    for (size_t i = 0; i < cellIndices.size() - 1; i++) {
-        int start = cellIndices[i];
-        int end = cellIndices[i + 1];
-        int cellSize = (end - start) / 3;  // 3 floats per vertex
-        
-        if (cellSize < 4) {
-            scores.push_back(0);
-            continue;
-        }
-        
-        int acuteAngles = 0;
-        
-        // For each vertex in the cell
-        for (int v = 0; v < cellSize; v++) {
-            int vIdx = start + v * 3;
-            Vec3 center(vertices[vIdx], vertices[vIdx + 1], vertices[vIdx + 2]);
-            
-            // Calculate distances to other vertices (squared for speed)
-            std::vector<std::pair<float, int>> distances;
-            for (int other = 0; other < cellSize; other++) {
-                if (other == v) continue;
-                
-                int oIdx = start + other * 3;
-                Vec3 otherVec(vertices[oIdx], vertices[oIdx + 1], vertices[oIdx + 2]);
-                Vec3 diff = otherVec - center;
-                float distSq = diff.lengthSquared();
-                distances.push_back({distSq, other});
-            }
-            
-            // Sort by distance and take nearest neighbors
-            std::partial_sort(distances.begin(), 
-                            distances.begin() + std::min(maxNeighbors, (int)distances.size()),
-                            distances.end());
-            
-            int numNeighbors = std::min(maxNeighbors, (int)distances.size());
-            
-            // Calculate angles between neighbor pairs
-            for (int j = 0; j < numNeighbors; j++) {
-                int idx1 = start + distances[j].second * 3;
-                Vec3 v1(vertices[idx1], vertices[idx1 + 1], vertices[idx1 + 2]);
-                Vec3 vec1 = v1 - center;
-                
-                for (int k = j + 1; k < numNeighbors; k++) {
-                    int idx2 = start + distances[k].second * 3;
-                    Vec3 v2(vertices[idx2], vertices[idx2 + 1], vertices[idx2 + 2]);
-                    Vec3 vec2 = v2 - center;
-                    
-                    float angle = calculateAngle(vec1, vec2);
-                    if (angle < HALF_PI) {
-                        acuteAngles++;
-                    }
-                }
-            }
-        }
-        
-        scores.push_back(acuteAngles / cellSize);  // Normalized score
-    }
-    
-    return scores;
+template <typename T>
+val arrayView(const std::vector<T>& values) {
+    return val(typed_memory_view(values.size(), values.data()));
 }
 
-// Batch processing for live updates - only recalculate changed cells
-std::vector<int> updateCellAcuteness(
-    const std::vector<float>& vertices,
-    const std::vector<int>& cellIndices,
-    const std::vector<int>& changedCells,  // Indices of cells that changed
-    std::vector<int>& previousScores       // Previous scores to update
-) {
-    const float HALF_PI = 1.5707963f;
-    
-    for (int cellIdx : changedCells) {
-        if (cellIdx >= cellIndices.size() - 1) continue;
-        
-        int start = cellIndices[cellIdx];
-        int end = cellIndices[cellIdx + 1];
-        int cellSize = (end - start) / 3;
-        
-        if (cellSize < 4) {
-            previousScores[cellIdx] = 0;
-            continue;
+// analyzeAcuteness() of GeometryAnalysis.js for points (Float64Array, xyz)
+// and tets (Int32Array, 4 per tet), with the Voronoi vertices in centers
+// (Float64Array, xyz per tet), or the tet barycenters if centers is null.
+// The returned Int32Array views are valid until the next call. Returns null
+// if centers does not hold one center per tet or a tet index is not a point.
+val analyzeGeometryAcuteness(const val& points, const val& tets, bool isPeriodic,
+                             const val& centers) {
+    g_geometryPoints.resize(points["length"].as<size_t>());
+    g_geometryTets.resize(tets["length"].as<size_t>());
+    val(typed_memory_view(g_geometryPoints.size(), g_geometryPoints.data())).call<void>("set", points);
+    val(typed_memory_view(g_geometryTets.size(), g_geometryTets.data())).call<void>("set", tets);
+    const int numPoints = int(g_geometryPoints.size() / 3);
+    const int numTets = int(g_geometryTets.size() / 4);
+    for (int v : g_geometryTets) {
+        if (v < 0 || v >= numPoints) return val::null();
+    }
+    const bool hasCenters = !centers.isNull() && !centers.isUndefined();
+    if (hasCenters) {
+        g_geometryCenters.resize(centers["length"].as<size_t>());
+        if (g_geometryCenters.size() != size_t(numTets) * 3) {
+            return val::null();
         }
-        
-        // Same calculation as above but only for changed cells
-        int acuteAngles = 0;
-        // ... (same logic as calculateCellAcuteness for single cell)
-        
-        previousScores[cellIdx] = acuteAngles / cellSize;
+        val(typed_memory_view(g_geometryCenters.size(), g_geometryCenters.data())).call<void>("set", centers);
     }
-    
-    return previousScores;
+    analyzeGeometryAcutenessInto(g_geometryPoints.data(), numPoints, g_geometryTets.data(),
+                                 numTets, isPeriodic, g_geometryScores,
+                                 hasCenters ? g_geometryCenters.data() : nullptr);
+    val result = val::object();
+    result.set("vertexScores", arrayView(g_geometryScores.vertexScores));
+    result.set("faceScores", arrayView(g_geometryScores.faceScores));
+    result.set("cellScores", arrayView(g_geometryScores.cellScores));
+    result.set("edgeScores", arrayView(g_geometryScores.edgeScores));
+    return result;
 }
 
+} // namespace
+
 // Bindings for JavaScript
 EMSCRIPTEN_BINDINGS(acuteness_module) {
     register_vector<float>("VectorFloat");
     register_vector<int>("VectorInt");
     
     function("calculateCellAcuteness", &calculateCellAcuteness);
+    function("calculateCellAcutenessInto", &calculateCellAcutenessInto);
     function("updateCellAcuteness", &updateCellAcuteness);
-} 
\ No newline at end of file
+    function("analyzeGeometryAcuteness", &analyzeGeometryAcuteness);
+}
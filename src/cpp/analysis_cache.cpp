@@ -0,0 +1,326 @@
+// analysis_cache.cpp
+//
+// Implementation of analysis_cache.h.
+
+#include "analysis_cache.h"
+#include <algorithm>
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define ANALYSIS_USE_GEO_THREADS
+#include "Delaunay_psm.h"
+#endif
+
+namespace {
+
+// Runs f(i) for every i of [0, count), on the PSM's thread pool when there
+// are enough items for the threads to pay off (as in acuteness.cpp).
+template <class F>
+void for_each_item(int count, const F& f) {
+#ifdef ANALYSIS_USE_GEO_THREADS
+    const int MIN_PARALLEL_ITEMS = 256;
+    if (count >= MIN_PARALLEL_ITEMS) {
+        GEO::initialize();
+        GEO::parallel_for_slice(0, GEO::index_t(count), [&](GEO::index_t begin, GEO::index_t end) {
+            for (GEO::index_t i = begin; i < end; ++i) {
+                f(int(i));
+            }
+        });
+        return;
+    }
+#endif
+    for (int i = 0; i < count; ++i) {
+        f(i);
+    }
+}
+
+template <class Vector>
+size_t capacity_bytes(const Vector& v) {
+    return v.capacity() * sizeof(typename Vector::value_type);
+}
+
+} // namespace
+
+AnalysisCache::AnalysisCache(const DelaunayContext& context) :
+    context_(&context),
+    synced_(false),
+    centers_(TET_BARYCENTER),
+    version_(0),
+    num_computed_(),
+    num_invalidated_(),
+    num_rebuilds_(0) {
+}
+
+bool AnalysisCache::sync() {
+    const DelaunayContext& context = *context_;
+    if (!context.has_triangulation()) {
+        synced_ = false;
+        return false;
+    }
+    const int version = context.update_version();
+    if (synced_ && version == version_) {
+        return true;
+    }
+    // One incremental update since the last sync keeps the topology.
+    if (synced_ && version == version_ + 1 && context.last_update_was_incremental() &&
+        context.tets().size() == size_t(topology_.numTets) * 4 &&
+        context.num_points() == topology_.numPoints) {
+        invalidate_moved_points();
+    } else {
+        rebuild();
+    }
+    version_ = version;
+    synced_ = true;
+    return true;
+}
+
+void AnalysisCache::rebuild() {
+    const DelaunayContext& context = *context_;
+    const int T = int(context.tets().size() / 4);
+    buildGeometryTopology(context.tets().data(), T, context.num_points(), topology_);
+    ++num_rebuilds_;
+
+    // Tet -> faces, the inverse of faceTets.
+    const int num_faces = topology_.numFaces();
+    tet_faces_ptr_.assign(size_t(T) + 1, 0);
+    for (int t : topology_.faceTets) {
+        ++tet_faces_ptr_[size_t(t) + 1];
+    }
+    for (int t = 0; t < T; ++t) {
+        tet_faces_ptr_[t + 1] += tet_faces_ptr_[t];
+    }
+    tet_faces_.resize(topology_.faceTets.size());
+    std::vector<int> cursor(tet_faces_ptr_.begin(), tet_faces_ptr_.end() - 1);
+    for (int f = 0; f < num_faces; ++f) {
+        for (int k = topology_.faceTetPtr[f]; k < topology_.faceTetPtr[f + 1]; ++k) {
+            tet_faces_[size_t(cursor[size_t(topology_.faceTets[k])]++)] = f;
+        }
+    }
+
+    barycenters_.resize(size_t(T) * 3);
+    barycenter_valid_.assign(size_t(T), 0);
+    for (int metric = 0; metric < ANALYSIS_NUM_METRICS; ++metric) {
+        const int n = num_items(metric);
+        for (uint8_t valid : valid_[metric]) {
+            num_invalidated_[metric] += valid;
+        }
+        scores_[metric].resize(size_t(n));
+        valid_[metric].assign(size_t(n), 0);
+    }
+}
+
+void AnalysisCache::invalidate_item(int metric, int item) {
+    uint8_t& valid = valid_[metric][size_t(item)];
+    num_invalidated_[metric] += valid;
+    valid = 0;
+}
+
+// Drops what depends on the tets of the moved points (see the header).
+void AnalysisCache::invalidate_moved_points() {
+    const GeometryTopology& topo = topology_;
+    const std::vector<int>& tets = context_->tets();
+    dirty_tets_.clear();
+    for (int v : context_->moved_points()) {
+        for (int k = topo.pointTetPtr[v]; k < topo.pointTetPtr[v + 1]; ++k) {
+            const int t = topo.pointTets[k];
+            if (barycenter_valid_[t] != 2) {
+                barycenter_valid_[t] = 2;  // marked; reset below
+                dirty_tets_.push_back(t);
+            }
+        }
+    }
+    for (int t : dirty_tets_) {
+        barycenter_valid_[t] = 0;
+        invalidate_item(ANALYSIS_VERTEX, t);
+        for (int k = 0; k < 4; ++k) {
+            invalidate_item(ANALYSIS_CELL, tets[size_t(t) * 4 + k]);
+        }
+        for (int k = tet_faces_ptr_[t]; k < tet_faces_ptr_[t + 1]; ++k) {
+            invalidate_item(ANALYSIS_FACE, tet_faces_[k]);
+        }
+        for (int k = topo.tetEdgePtr[t]; k < topo.tetEdgePtr[t + 1]; ++k) {
+            const int e = topo.tetEdges[k];
+            invalidate_item(ANALYSIS_EDGE, e);
+            const int* ends = &topo.voronoiEdgeTets[size_t(e) * 2];
+            const int other = ends[0] == t ? ends[1] : ends[0];
+            for (int j = topo.tetEdgePtr[other]; j < topo.tetEdgePtr[other + 1]; ++j) {
+                invalidate_item(ANALYSIS_EDGE, topo.tetEdges[j]);
+            }
+        }
+    }
+}
+
+int AnalysisCache::count(int metric) {
+    return sync() ? num_items(metric) : 0;
+}
+
+int AnalysisCache::num_items(int metric) const {
+    switch (metric) {
+    case ANALYSIS_VERTEX: return topology_.numTets;
+    case ANALYSIS_FACE: return topology_.numFaces();
+    case ANALYSIS_CELL: return topology_.numPoints;
+    case ANALYSIS_EDGE: return topology_.numVoronoiEdges();
+    default: return 0;
+    }
+}
+
+const double* AnalysisCache::barycenter(int t) {
+    if (!barycenter_valid_[t]) {
+        const DelaunayContext& context = *context_;
+        const int* tet = &context.tets()[size_t(t) * 4];
+        double* out = &barycenters_[size_t(t) * 3];
+        if (centers_ == TET_BARYCENTER) {
+            geometryBarycenter(context.points().data(), tet, context.is_periodic(), out);
+        } else {
+            const std::vector<int8_t>& translations = context.tet_translations();
+            const bool translated = translations.size() == context.tets().size() * 3;
+            compute_tet_centers(context.points().data(), tet, 1,
+                                translated ? &translations[size_t(t) * 12] : nullptr,
+                                context.is_periodic(), centers_, out);
+        }
+        barycenter_valid_[t] = 1;
+    }
+    return &barycenters_[size_t(t) * 3];
+}
+
+void AnalysisCache::fill_barycenters() {
+    const int T = topology_.numTets;
+    for_each_item(T, [&](int t) {
+        barycenter(t);
+    });
+}
+
+// Scores one item, with the barycenters it reads all valid.
+int AnalysisCache::compute_score(int metric, int item) {
+    const GeometryTopology& topo = topology_;
+    const double* points = context_->points().data();
+    const bool periodic = context_->is_periodic();
+    switch (metric) {
+    case ANALYSIS_VERTEX:
+        return geometryVertexScore(points, &context_->tets()[size_t(item) * 4], periodic);
+    case ANALYSIS_FACE:
+        return geometryFaceScore(points, barycenters_.data(), topo, item, periodic);
+    case ANALYSIS_CELL:
+        return geometryCellScore(points, barycenters_.data(), topo, item, periodic);
+    default:
+        return geometryEdgeScore(barycenters_.data(), topo, item, periodic);
+    }
+}
+
+const std::vector<int>* AnalysisCache::scores(int metric) {
+    if (!sync() || metric < 0 || metric >= ANALYSIS_NUM_METRICS) {
+        return nullptr;
+    }
+    std::vector<int>& scores = scores_[metric];
+    std::vector<uint8_t>& valid = valid_[metric];
+    std::vector<int>& missing = missing_;
+    missing.clear();
+    for (int i = 0; i < int(valid.size()); ++i) {
+        if (!valid[i]) {
+            missing.push_back(i);
+        }
+    }
+    if (missing.empty()) {
+        return &scores;
+    }
+    if (metric != ANALYSIS_VERTEX) {
+        fill_barycenters();
+    }
+    for_each_item(int(missing.size()), [&](int k) {
+        scores[size_t(missing[k])] = compute_score(metric, missing[k]);
+        valid[size_t(missing[k])] = 1;
+    });
+    num_computed_[metric] += (long long)missing.size();
+    return &scores;
+}
+
+bool AnalysisCache::scores_of(int metric, const int* items, int count, std::vector<int>& out) {
+    if (!sync() || metric < 0 || metric >= ANALYSIS_NUM_METRICS) {
+        return false;
+    }
+    const int n = num_items(metric);
+    for (int k = 0; k < count; ++k) {
+        if (items[k] < 0 || items[k] >= n) {
+            return false;
+        }
+    }
+    const GeometryTopology& topo = topology_;
+    out.resize(size_t(std::max(count, 0)));
+    for (int k = 0; k < count; ++k) {
+        const int item = items[k];
+        if (!valid_[metric][size_t(item)]) {
+            // The barycenters the item reads.
+            if (metric == ANALYSIS_FACE) {
+                for (int j = topo.faceTetPtr[item]; j < topo.faceTetPtr[item + 1]; ++j) {
+                    barycenter(topo.faceTets[j]);
+                }
+            } else if (metric == ANALYSIS_CELL) {
+                for (int j = topo.pointTetPtr[item]; j < topo.pointTetPtr[item + 1]; ++j) {
+                    barycenter(topo.pointTets[j]);
+                }
+            } else if (metric == ANALYSIS_EDGE) {
+                for (int side = 0; side < 2; ++side) {
+                    const int t = topo.voronoiEdgeTets[size_t(item) * 2 + side];
+                    for (int j = topo.tetEdgePtr[t]; j < topo.tetEdgePtr[t + 1]; ++j) {
+                        const int* ends = &topo.voronoiEdgeTets[size_t(topo.tetEdges[j]) * 2];
+                        barycenter(ends[0]);
+                        barycenter(ends[1]);
+                    }
+                }
+            }
+            scores_[metric][size_t(item)] = compute_score(metric, item);
+            valid_[metric][size_t(item)] = 1;
+            ++num_computed_[metric];
+        }
+        out[size_t(k)] = scores_[metric][size_t(item)];
+    }
+    return true;
+}
+
+long long AnalysisCache::num_computed(int metric) const {
+    return metric >= 0 && metric < ANALYSIS_NUM_METRICS ? num_computed_[metric] : 0;
+}
+
+long long AnalysisCache::num_invalidated(int metric) const {
+    return metric >= 0 && metric < ANALYSIS_NUM_METRICS ? num_invalidated_[metric] : 0;
+}
+
+void AnalysisCache::invalidate() {
+    synced_ = false;
+}
+
+void AnalysisCache::set_centers(TetCenter centers) {
+    if (centers != centers_) {
+        centers_ = centers;
+        synced_ = false;
+    }
+}
+
+size_t AnalysisCache::memory_bytes() const {
+    const GeometryTopology& topo = topology_;
+    size_t bytes = capacity_bytes(barycenters_) + capacity_bytes(barycenter_valid_);
+    for (const std::vector<int>* v : {&topo.pointTetPtr, &topo.pointTets, &topo.faceEndpoints,
+                                      &topo.faceTetPtr, &topo.faceTets, &topo.voronoiEdgeTets,
+                                      &topo.tetEdgePtr, &topo.tetEdges, &tet_faces_ptr_,
+                                      &tet_faces_, &dirty_tets_, &missing_}) {
+        bytes += capacity_bytes(*v);
+    }
+    for (int metric = 0; metric < ANALYSIS_NUM_METRICS; ++metric) {
+        bytes += capacity_bytes(scores_[metric]) + capacity_bytes(valid_[metric]);
+    }
+    return bytes;
+}
+
+void AnalysisCache::release() {
+    topology_ = GeometryTopology();
+    std::vector<int>().swap(tet_faces_ptr_);
+    std::vector<int>().swap(tet_faces_);
+    std::vector<double>().swap(barycenters_);
+    std::vector<uint8_t>().swap(barycenter_valid_);
+    for (int metric = 0; metric < ANALYSIS_NUM_METRICS; ++metric) {
+        std::vector<int>().swap(scores_[metric]);
+        std::vector<uint8_t>().swap(valid_[metric]);
+    }
+    std::vector<int>().swap(dirty_tets_);
+    std::vector<int>().swap(missing_);
+    synced_ = false;
+}
@@ -0,0 +1,110 @@
+// analysis_cache.h
+//
+// Lazy geometry analyses of a persistent DelaunayContext: the vertex / face /
+// cell / edge scores of analyzeGeometryAcutenessInto(), each computed only
+// when it is read and kept until the tets it depends on change.
+//
+// The cache follows the context's updates (update_version()). After an
+// incremental update it only drops the scores around the moved points: the
+// barycenters and vertex scores of their tets, the cells, faces and Voronoi
+// edges those tets bound, and the Voronoi edges at the tets next to them
+// (whose angles are taken against the moved barycenters). Any other update,
+// or an update it missed, drops everything along with the topology.
+//
+// The Voronoi vertices of the face, cell and edge scores are the tet
+// barycenters, or with set_centers(TET_CIRCUMCENTER) the circumcenters of
+// compute_tet_centers(), unwrapped with the context's tet_translations()
+// when it keeps them, as DelaunayComputation.js computes them.
+
+#pragma once
+
+#include "acuteness.h"
+#include "delaunay_core.h"
+#include "tet_centers.h"
+#include <cstdint>
+#include <vector>
+
+enum AnalysisMetric {
+    ANALYSIS_VERTEX = 0,  // one score per tet
+    ANALYSIS_FACE = 1,    // per face of GeometryTopology
+    ANALYSIS_CELL = 2,    // per point
+    ANALYSIS_EDGE = 3,    // per Voronoi edge
+    ANALYSIS_NUM_METRICS = 4
+};
+
+class AnalysisCache {
+public:
+    // The cache reads the context at every call and must not outlive it.
+    explicit AnalysisCache(const DelaunayContext& context);
+
+    // Catches up with the context's updates; every read below calls it.
+    // Returns false (and holds nothing) without a triangulation.
+    bool sync();
+
+    // Number of items of a metric, 0 for an unknown one or without a
+    // triangulation.
+    int count(int metric);
+
+    // Every score of a metric, computing those not yet valid; stays valid
+    // until the next call. Returns null without a triangulation or for an
+    // unknown metric.
+    const std::vector<int>* scores(int metric);
+
+    // The scores of the items `items[0..count)` of a metric into `out`,
+    // computing only those not yet valid. Returns false without a
+    // triangulation, for an unknown metric or an item out of range.
+    bool scores_of(int metric, const int* items, int count, std::vector<int>& out);
+
+    // Scores computed per metric since the cache was created, and items
+    // invalidated by the updates it followed, to check what the reads cost.
+    long long num_computed(int metric) const;
+    long long num_invalidated(int metric) const;
+
+    // Number of full rebuilds of the topology (== updates not followed
+    // incrementally).
+    int num_rebuilds() const {
+        return num_rebuilds_;
+    }
+
+    // The Voronoi vertices of the scores (TET_BARYCENTER by default).
+    // Changing them drops every score.
+    void set_centers(TetCenter centers);
+
+    TetCenter centers() const {
+        return centers_;
+    }
+
+    // Drops every score (and the topology), e.g. after the context's
+    // points were changed without an update.
+    void invalidate();
+
+    size_t memory_bytes() const;
+
+    // Frees the topology and the scores.
+    void release();
+
+private:
+    void rebuild();
+    void invalidate_moved_points();
+    void invalidate_item(int metric, int item);
+    int num_items(int metric) const;
+    const double* barycenter(int t);
+    int compute_score(int metric, int item);
+    void fill_barycenters();
+
+    const DelaunayContext* context_;
+    bool synced_;
+    TetCenter centers_;
+    int version_;  // context update_version() the cache follows
+    GeometryTopology topology_;
+    std::vector<int> tet_faces_ptr_, tet_faces_;  // faces around each tet
+    std::vector<double> barycenters_;
+    std::vector<uint8_t> barycenter_valid_;
+    std::vector<int> scores_[ANALYSIS_NUM_METRICS];
+    std::vector<uint8_t> valid_[ANALYSIS_NUM_METRICS];
+    std::vector<int> dirty_tets_;
+    std::vector<int> missing_;  // items scores() computes
+    long long num_computed_[ANALYSIS_NUM_METRICS];
+    long long num_invalidated_[ANALYSIS_NUM_METRICS];
+    int num_rebuilds_;
+};
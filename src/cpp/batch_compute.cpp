@@ -0,0 +1,100 @@
+// batch_compute.cpp
+//
+// Implementation of batch_compute.h.
+
+#include "batch_compute.h"
+#include "acuteness.h"
+#include <iostream>
+
+DelaunayBatch::DelaunayBatch(bool is_periodic) : is_periodic_(is_periodic) {
+}
+
+int DelaunayBatch::compute(const double* points, const int* point_offsets, int num_jobs,
+                           const BatchOptions& options) {
+    const int K = std::max(num_jobs, 0);
+    const int total_points = K > 0 ? point_offsets[K] : 0;
+    while (int(contexts_.size()) < K) {
+        contexts_.emplace_back(new DelaunayContext(is_periodic_));
+    }
+    tet_offsets_.assign(1, 0);
+    tets_.clear();
+    scores_.assign(options.scores ? size_t(std::max(total_points, 0)) : 0, 0);
+    job_ok_.assign(size_t(K), 0);
+    stats_.assign(size_t(K), DelaunayStats());
+
+    // With at least one job per thread, the jobs run concurrently, each on a
+    // single-threaded engine; a few large jobs run one after the other across
+    // the whole pool instead.
+    const GEO::index_t num_threads = GEO::Process::maximum_concurrent_threads();
+    const bool concurrent = num_threads > 1 && GEO::index_t(K) >= num_threads;
+    for (int j = 0; j < K; ++j) {
+        contexts_[size_t(j)]->set_single_threaded(concurrent);
+    }
+    if (concurrent) {
+        // Interleaved, so that sweeps over growing point counts balance.
+        GEO::parallel_for(0, GEO::index_t(K), [&](GEO::index_t j) {
+            ScoreScratch scratch;
+            run_job(int(j), points, point_offsets, options, scratch);
+        }, 1, true);
+    } else {
+        for (int j = 0; j < K; ++j) {
+            run_job(j, points, point_offsets, options, scratch_);
+        }
+    }
+
+    int num_ok = 0;
+    for (int j = 0; j < K; ++j) {
+        if (job_ok_[size_t(j)]) {
+            const std::vector<int>& tets = contexts_[size_t(j)]->tets();
+            tets_.insert(tets_.end(), tets.begin(), tets.end());
+            ++num_ok;
+        } else if (log_level() >= LOG_ERRORS) {
+            std::cerr << "DelaunayBatch: job " << j << " ("
+                      << point_offsets[j + 1] - point_offsets[j] << " points) failed." << std::endl;
+        }
+        tet_offsets_.push_back(int(tets_.size() / 4));
+    }
+    return num_ok;
+}
+
+void DelaunayBatch::run_job(int j, const double* points, const int* point_offsets,
+                            const BatchOptions& options, ScoreScratch& scratch) {
+    const int first = point_offsets[j];
+    const int n = point_offsets[j + 1] - first;
+    DelaunayContext& context = *contexts_[size_t(j)];
+    if (n < 4) {
+        return;
+    }
+    context.set_points(&points[size_t(first) * 3], n);
+    bool ok = options.incremental ? context.compute_incremental(options.max_displacement)
+                                  : context.compute();
+    stats_[size_t(j)] = context.stats();
+    if (ok && options.scores) {
+        ok = context.compute_voronoi_cells();
+        if (ok) {
+            // Voronoi cell vertices into the acuteness kernel's flat layout
+            const std::vector<int>& packed = context.voronoi_cells();
+            const std::vector<double>& vertices = context.voronoi_cell_vertices();
+            scratch.cell_vertices.assign(vertices.begin(), vertices.end());
+            scratch.cell_indices.resize(size_t(n) + 1);
+            for (int i = 0; i <= n; ++i) {
+                scratch.cell_indices[i] = packed[3 + i] * 3;
+            }
+            calculateCellAcutenessInto(scratch.cell_vertices, scratch.cell_indices,
+                                       scratch.job_scores, options.max_neighbors);
+            std::copy(scratch.job_scores.begin(), scratch.job_scores.begin() + n,
+                      scores_.begin() + first);
+        }
+    }
+    job_ok_[size_t(j)] = ok ? 1 : 0;
+}
+
+void DelaunayBatch::release() {
+    contexts_.clear();
+    std::vector<int>(1, 0).swap(tet_offsets_);
+    std::vector<int>().swap(tets_);
+    std::vector<int>().swap(scores_);
+    std::vector<uint8_t>().swap(job_ok_);
+    std::vector<DelaunayStats>().swap(stats_);
+    scratch_ = ScoreScratch();
+}
@@ -0,0 +1,108 @@
+// batch_compute.h
+//
+// Parameter sweeps: K point sets packed in one buffer, triangulated (and
+// their Voronoi cells scored) in one call, with packed results. Every job
+// keeps its own pooled DelaunayContext, so that repeated sweeps reuse the
+// tet stores of each configuration and can update them incrementally.
+//
+// With at least as many jobs as threads, the jobs run concurrently, one per
+// thread, each context inserting its points with a single thread (see
+// DelaunayContext::set_single_threaded()): the PSM's thread machinery is
+// process-wide and not reentrant, so each triangulation stays out of it.
+// Fewer, larger jobs run one after the other, each across the whole thread
+// pool (the PSM's parallel insertion, the parallel acuteness kernel).
+
+#pragma once
+
+#include "delaunay_core.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct BatchOptions {
+    bool scores = false;           // also score the Voronoi cells of every job
+    int max_neighbors = 6;         // for the scores, see calculateCellAcutenessInto()
+    bool incremental = false;      // compute_incremental() on each job's context
+    double max_displacement = 0.05;
+};
+
+class DelaunayBatch {
+public:
+    explicit DelaunayBatch(bool is_periodic);
+
+    bool is_periodic() const {
+        return is_periodic_;
+    }
+
+    // Triangulates num_jobs point sets. Job j holds the points
+    // point_offsets[j] to point_offsets[j + 1] - 1 of points (xyz each),
+    // with point_offsets[0] = 0 and non-decreasing offsets, and its context
+    // is context(j). Replaces the previous results. Returns the number of
+    // jobs that succeeded; a failed job (empty cells, fewer than 4 points)
+    // has no tets and zero scores.
+    int compute(const double* points, const int* point_offsets, int num_jobs,
+                const BatchOptions& options);
+
+    int num_jobs() const {
+        return int(job_ok_.size());
+    }
+
+    // Tets of job j: tets()[4 * tet_offsets()[j]] to
+    // tets()[4 * tet_offsets()[j + 1] - 1], with point indices local to the
+    // job (0 is its first point).
+    const std::vector<int>& tet_offsets() const {
+        return tet_offsets_;
+    }
+
+    const std::vector<int>& tets() const {
+        return tets_;
+    }
+
+    // One acuteness score per point, in the order of the input points (so
+    // job j's are at its point offsets). Empty unless BatchOptions::scores.
+    const std::vector<int>& scores() const {
+        return scores_;
+    }
+
+    // 1 per job that succeeded, else 0.
+    const std::vector<uint8_t>& job_ok() const {
+        return job_ok_;
+    }
+
+    // Counters and stage timings of job j.
+    const DelaunayStats& job_stats(int j) const {
+        return stats_[size_t(j)];
+    }
+
+    // The pooled context of job j, kept until release(). Requires
+    // j < num_jobs().
+    DelaunayContext& context(int j) {
+        return *contexts_[size_t(j)];
+    }
+
+    // Frees the pooled contexts and the results.
+    void release();
+
+private:
+    // Scoring scratch of a job.
+    struct ScoreScratch {
+        std::vector<float> cell_vertices;
+        std::vector<int> cell_indices;
+        std::vector<int> job_scores;
+    };
+
+    // Triangulates (and scores) job j into its context, scores() and
+    // job_ok()[j].
+    void run_job(int j, const double* points, const int* point_offsets,
+                 const BatchOptions& options, ScoreScratch& scratch);
+
+    bool is_periodic_;
+    std::vector<std::unique_ptr<DelaunayContext>> contexts_;
+    std::vector<int> tet_offsets_;
+    std::vector<int> tets_;
+    std::vector<int> scores_;
+    std::vector<uint8_t> job_ok_;
+    std::vector<DelaunayStats> stats_;
+    // Scoring scratch of the jobs run one after the other.
+    ScoreScratch scratch_;
+};
@@ -0,0 +1,746 @@
+// delaunay_2d.cpp
+//
+// Implementation of delaunay_2d.h.
+
+#include "delaunay_2d.h"
+#include "acuteness.h"
+#include "frame_arena.h"
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// Translation of copy shift s (0..8, 4 is the point itself), in periods.
+inline int shift_x(int s) {
+    return s / 3 - 1;
+}
+
+inline int shift_y(int s) {
+    return s % 3 - 1;
+}
+
+template <class Vector>
+size_t capacity_bytes(const Vector& v) {
+    return v.capacity() * sizeof(typename Vector::value_type);
+}
+
+} // namespace
+
+DelaunayContext2d::DelaunayContext2d(bool is_periodic) :
+    is_periodic_(is_periodic),
+    weighted_(false),
+    num_points_(0),
+    has_triangulation_(false),
+    last_update_incremental_(false),
+    delaunay_weighted_(false),
+    max_weight_(0.0),
+    margin_(1.0),
+    margin_points_(-1),
+    dimension_(2),
+    adjacency_valid_(false),
+    adjacency_version_(0),
+    update_version_(0),
+    voronoi_version_(-1),
+    cell_scores_version_(-1) {
+}
+
+double* DelaunayContext2d::points_buffer(int num_points) {
+    num_points_ = std::max(num_points, 0);
+    points_.resize(size_t(num_points_) * 2);
+    return points_.data();
+}
+
+void DelaunayContext2d::set_points(const double* coords, int num_points) {
+    double* buffer = points_buffer(num_points);
+    std::copy(coords, coords + size_t(num_points_) * 2, buffer);
+}
+
+double* DelaunayContext2d::weights_buffer(int num_points) {
+    weighted_ = true;
+    weights_.resize(size_t(std::max(num_points, 0)));
+    return weights_.data();
+}
+
+void DelaunayContext2d::set_weights(const double* weights, int num_points) {
+    double* buffer = weights_buffer(num_points);
+    std::copy(weights, weights + weights_.size(), buffer);
+}
+
+void DelaunayContext2d::clear_weights() {
+    weighted_ = false;
+    std::vector<double>().swap(weights_);
+}
+
+bool DelaunayContext2d::compute() {
+    frame_arena().reset();
+    ++update_version_;
+    last_update_incremental_ = false;
+    adjacency_valid_ = false;
+    has_triangulation_ = false;
+    moved_.clear();
+    changed_cells_.clear();
+    triangles_.clear();
+    stats_ = DelaunayStats();
+    if (weighted_ && weights_.size() != size_t(num_points_)) {
+        if (log_level() >= LOG_ERRORS) {
+            std::cerr << "DelaunayContext2d: " << weights_.size() << " weights for "
+                      << num_points_ << " points." << std::endl;
+        }
+        return false;
+    }
+    if (num_points_ < 3) {
+        return false;
+    }
+    GEO::Stopwatch total_watch("total", false);
+    if (!triangulate()) {
+        return false;
+    }
+    has_triangulation_ = true;
+    const double output_start = total_watch.elapsed_time();
+    stats_.weighted = weighted_;
+    reference_points_.assign(points_.begin(), points_.end());
+    reference_weights_.assign(weights_.begin(), weights_.end());
+    build_vertex_to_triangles();
+    changed_cells_.resize(size_t(num_points_));
+    for (int v = 0; v < num_points_; ++v) {
+        changed_cells_[v] = v;
+    }
+    stats_.output = total_watch.elapsed_time() - output_start;
+    stats_.total = total_watch.elapsed_time();
+    sample_memory(stats_);
+    stats_.retained_bytes = double(memory_bytes());
+    return true;
+}
+
+// Builds the extended point set, triangulates it and selects the unique
+// triangles, growing the periodic margin until the selection succeeds.
+bool DelaunayContext2d::triangulate() {
+    initialize_geogram();
+    GEO::Stopwatch watch("triangulate", false);
+    if (!delaunay_ || delaunay_weighted_ != weighted_) {
+        if (weighted_) {
+            delaunay_ = new GEO::RegularWeightedDelaunay2d(3);
+        } else {
+            delaunay_ = new GEO::Delaunay2d(2);
+        }
+        delaunay_weighted_ = weighted_;
+    }
+    dimension_ = weighted_ ? 3 : 2;
+    max_weight_ = 0.0;
+    if (weighted_) {
+        max_weight_ = *std::max_element(weights_.begin(), weights_.end());
+    }
+    if (is_periodic_) {
+        for (double& x : points_) {
+            x -= std::floor(x);
+            if (x >= 1.0) {
+                x = 0.0;
+            }
+        }
+        if (margin_points_ != num_points_) {
+            margin_ = std::min(1.0, 2.5 / std::sqrt(double(num_points_)));
+            margin_points_ = num_points_;
+        }
+    }
+
+    for (;;) {
+        double stage_start = watch.elapsed_time();
+        build_copies();
+        stats_.marshal += watch.elapsed_time() - stage_start;
+
+        stage_start = watch.elapsed_time();
+        const GEO::index_t nb_vertices = GEO::index_t(extended_points_.size()) / dimension_;
+        try {
+            delaunay_->set_vertices(nb_vertices, extended_points_.data());
+        } catch (const std::exception& e) {
+            if (log_level() >= LOG_ERRORS) {
+                std::cerr << "Exception during compute: " << e.what() << std::endl;
+            }
+            return false;
+        } catch (...) {
+            if (log_level() >= LOG_ERRORS) {
+                std::cerr << "Unknown exception during compute." << std::endl;
+            }
+            return false;
+        }
+        stats_.insertion += watch.elapsed_time() - stage_start;
+
+        stage_start = watch.elapsed_time();
+        bool grow_margin = false;
+        const bool ok = select_triangles(grow_margin);
+        stats_.dedup += watch.elapsed_time() - stage_start;
+        stats_.num_raw_tets = int(delaunay_->nb_cells());
+        stats_.num_unique_tets = int(triangles_.size() / 3);
+        if (ok) {
+            break;
+        }
+        if (!grow_margin || margin_ >= 1.0) {
+            if (log_level() >= LOG_ERRORS) {
+                std::cerr << "DelaunayContext2d: no valid triangulation of " << num_points_
+                          << " points" << (grow_margin ? " (too few for the periodic copies)."
+                                                       : " (empty cells?).")
+                          << std::endl;
+            }
+            return false;
+        }
+        margin_ = std::min(2.0 * margin_, 1.0);
+    }
+
+    if (log_level() >= LOG_DEBUG) {
+        std::cout << "Delaunay 2d: " << num_points_ << " points, "
+                  << extended_points_.size() / dimension_ - size_t(num_points_) << " copies, "
+                  << stats_.num_unique_tets << " triangles." << std::endl;
+    }
+    return true;
+}
+
+// Translations (bits 0..8, see shift_x()) of the copies of point p: those
+// that fall within the margin of the square.
+int DelaunayContext2d::copy_mask(const double* p) const {
+    if (!is_periodic_) {
+        return 0;
+    }
+    int mask = 0;
+    for (int s = 0; s < 9; ++s) {
+        if (s == 4) {
+            continue;
+        }
+        const double x = p[0] + shift_x(s);
+        const double y = p[1] + shift_y(s);
+        if (x >= -margin_ && x <= 1.0 + margin_ && y >= -margin_ && y <= 1.0 + margin_) {
+            mask |= 1 << s;
+        }
+    }
+    return mask;
+}
+
+void DelaunayContext2d::build_copies() {
+    const int n = num_points_;
+    copy_masks_.resize(size_t(n));
+    copy_first_.resize(size_t(n) + 1);
+    copy_source_.clear();
+    copy_shift_.clear();
+    copy_first_[0] = 0;
+    for (int v = 0; v < n; ++v) {
+        const int mask = copy_mask(&points_[size_t(v) * 2]);
+        copy_masks_[v] = uint16_t(mask);
+        for (int s = 0; s < 9; ++s) {
+            if (mask & (1 << s)) {
+                copy_source_.push_back(v);
+                copy_shift_.push_back(int8_t(s));
+            }
+        }
+        copy_first_[v + 1] = int(copy_source_.size());
+    }
+    extended_points_.resize((size_t(n) + copy_source_.size()) * dimension_);
+    for (int v = 0; v < n; ++v) {
+        update_copies(v);
+    }
+}
+
+// Writes the extended coordinates of point v and of its copies.
+void DelaunayContext2d::update_copies(int v) {
+    const double* p = &points_[size_t(v) * 2];
+    const double lift = weighted_ ? std::sqrt(std::max(max_weight_ - weights_[v], 0.0)) : 0.0;
+    double* q = &extended_points_[size_t(v) * dimension_];
+    q[0] = p[0];
+    q[1] = p[1];
+    if (weighted_) {
+        q[2] = lift;
+    }
+    for (int k = copy_first_[v]; k < copy_first_[v + 1]; ++k) {
+        q = &extended_points_[(size_t(num_points_) + size_t(k)) * dimension_];
+        q[0] = p[0] + shift_x(copy_shift_[k]);
+        q[1] = p[1] + shift_y(copy_shift_[k]);
+        if (weighted_) {
+            q[2] = lift;
+        }
+    }
+}
+
+int DelaunayContext2d::real_vertex(GEO::index_t v) const {
+    return v < GEO::index_t(num_points_) ? int(v) : copy_source_[v - GEO::index_t(num_points_)];
+}
+
+// Periodic mode: true when every point that may conflict with triangle t
+// (the disk of its power circle, widened by the largest weight) lies within
+// the copies, so that t is a triangle of the periodic triangulation.
+bool DelaunayContext2d::circle_within_copies(GEO::index_t t) const {
+    const double* p[3];
+    double w[3];
+    for (GEO::index_t lv = 0; lv < 3; ++lv) {
+        const GEO::index_t v = delaunay_->cell_vertex(t, lv);
+        p[lv] = &extended_points_[size_t(v) * dimension_];
+        w[lv] = weighted_ ? weights_[real_vertex(v)] : 0.0;
+    }
+    // Power center relative to p0.
+    const double d1x = p[1][0] - p[0][0], d1y = p[1][1] - p[0][1];
+    const double d2x = p[2][0] - p[0][0], d2y = p[2][1] - p[0][1];
+    const double r1 = d1x * d1x + d1y * d1y - (w[1] - w[0]);
+    const double r2 = d2x * d2x + d2y * d2y - (w[2] - w[0]);
+    const double det = 2.0 * (d1x * d2y - d1y * d2x);
+    if (!(std::fabs(det) > 0.0)) {
+        return false;
+    }
+    const double cx = (r1 * d2y - r2 * d1y) / det;
+    const double cy = (d1x * r2 - d2x * r1) / det;
+    const double power = cx * cx + cy * cy - w[0];
+    const double radius = std::sqrt(std::max(power + max_weight_, 0.0)) * (1.0 + 1e-9) + 1e-12;
+    const double x = p[0][0] + cx, y = p[0][1] + cy;
+    return x - radius >= -margin_ && x + radius <= 1.0 + margin_ &&
+           y - radius >= -margin_ && y + radius <= 1.0 + margin_;
+}
+
+// Keeps the triangles around the real points, each once: in the frame of
+// its vertex of lowest point index. Fails when a real point has no
+// triangle, or (setting grow_margin) when the copies do not cover the
+// circle of a triangle around a real point.
+bool DelaunayContext2d::select_triangles(bool& grow_margin) {
+    const GEO::index_t n = GEO::index_t(num_points_);
+    const GEO::index_t nb_cells = delaunay_->nb_cells();
+    char* in_star = frame_arena().allocate_array<char>(n);
+    std::fill(in_star, in_star + n, 0);
+    triangles_.clear();
+    triangles_.reserve(size_t(n) * 6);
+    for (GEO::index_t t = 0; t < nb_cells; ++t) {
+        GEO::index_t v[3];
+        int real[3];
+        bool has_real = false;
+        for (GEO::index_t lv = 0; lv < 3; ++lv) {
+            v[lv] = delaunay_->cell_vertex(t, lv);
+            real[lv] = real_vertex(v[lv]);
+            if (v[lv] < n) {
+                has_real = true;
+                in_star[v[lv]] = 1;
+            }
+        }
+        if (!has_real) {
+            continue;
+        }
+        if (is_periodic_) {
+            if (real[0] == real[1] || real[1] == real[2] || real[2] == real[0] ||
+                !circle_within_copies(t)) {
+                grow_margin = true;
+                return false;
+            }
+            const GEO::index_t first =
+                real[0] < real[1] ? (real[0] < real[2] ? 0 : 2) : (real[1] < real[2] ? 1 : 2);
+            if (v[first] >= n) {
+                continue;
+            }
+        }
+        triangles_.insert(triangles_.end(), {real[0], real[1], real[2]});
+    }
+    return std::find(in_star, in_star + n, 0) == in_star + n;
+}
+
+// Builds the (point -> PSM triangles) incidence in CSR form, over the
+// triangles around the real instance of each point.
+void DelaunayContext2d::build_vertex_to_triangles() {
+    const GEO::index_t n = GEO::index_t(num_points_);
+    const GEO::index_t nb_cells = delaunay_->nb_cells();
+    vertex_triangles_rowptr_.assign(size_t(n) + 1, 0);
+    for (GEO::index_t t = 0; t < nb_cells; ++t) {
+        for (GEO::index_t lv = 0; lv < 3; ++lv) {
+            GEO::index_t v = delaunay_->cell_vertex(t, lv);
+            if (v < n) {
+                ++vertex_triangles_rowptr_[v + 1];
+            }
+        }
+    }
+    for (GEO::index_t v = 0; v < n; ++v) {
+        vertex_triangles_rowptr_[v + 1] += vertex_triangles_rowptr_[v];
+    }
+    vertex_triangles_.resize(vertex_triangles_rowptr_[n]);
+    int* cursor = frame_arena().allocate_array<int>(n);
+    std::copy(vertex_triangles_rowptr_.begin(), vertex_triangles_rowptr_.end() - 1, cursor);
+    for (GEO::index_t t = 0; t < nb_cells; ++t) {
+        for (GEO::index_t lv = 0; lv < 3; ++lv) {
+            GEO::index_t v = delaunay_->cell_vertex(t, lv);
+            if (v < n) {
+                vertex_triangles_[cursor[v]++] = int(t);
+            }
+        }
+    }
+}
+
+bool DelaunayContext2d::compute_incremental(double max_displacement) {
+    frame_arena().reset();
+    GEO::Stopwatch certify_watch("certify", false);
+    if (!has_triangulation_ || delaunay_weighted_ != weighted_ ||
+        reference_points_.size() != points_.size() ||
+        reference_weights_.size() != weights_.size() ||
+        !collect_moved_points(max_displacement) || !certify_moved_points()) {
+        const double certify = certify_watch.elapsed_time();
+        bool ok = compute();
+        stats_.certify = certify;
+        stats_.total += certify;
+        return ok;
+    }
+    for (int v : moved_) {
+        reference_points_[size_t(v) * 2] = points_[size_t(v) * 2];
+        reference_points_[size_t(v) * 2 + 1] = points_[size_t(v) * 2 + 1];
+        if (weighted_) {
+            reference_weights_[v] = weights_[v];
+        }
+    }
+    last_update_incremental_ = true;
+    ++update_version_;
+    const double certify = certify_watch.elapsed_time();
+    collect_changed_cells();
+
+    // Same triangles as before; only the certification and output stages ran.
+    const int num_raw_tets = stats_.num_raw_tets;
+    const int num_unique_tets = stats_.num_unique_tets;
+    stats_ = DelaunayStats();
+    stats_.incremental = true;
+    stats_.weighted = weighted_;
+    stats_.certify = certify;
+    stats_.output = certify_watch.elapsed_time() - certify;
+    stats_.total = certify_watch.elapsed_time();
+    stats_.num_raw_tets = num_raw_tets;
+    stats_.num_unique_tets = num_unique_tets;
+    sample_memory(stats_);
+    stats_.retained_bytes = double(memory_bytes());
+    return true;
+}
+
+// Fills moved_ with the points that differ from reference_points_, or
+// whose weight differs from reference_weights_, and moves their extended
+// coordinates. Returns false if one of them requires a full recompute.
+bool DelaunayContext2d::collect_moved_points(double max_displacement) {
+    moved_.clear();
+    const double max_d2 = max_displacement * max_displacement;
+    for (int v = 0; v < num_points_; ++v) {
+        const double* p = &points_[size_t(v) * 2];
+        const double* q = &reference_points_[size_t(v) * 2];
+        if (p[0] == q[0] && p[1] == q[1]) {
+            if (weighted_ && weights_[v] != reference_weights_[v]) {
+                if (weights_[v] > max_weight_) {
+                    return false;
+                }
+                moved_.push_back(v);
+                update_copies(v);
+            }
+            continue;
+        }
+        if (p[0] < 0.0 || p[0] >= 1.0 || p[1] < 0.0 || p[1] >= 1.0) {
+            return false;
+        }
+        const double d2 = (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]);
+        if (d2 > max_d2 || copy_mask(p) != copy_masks_[v] ||
+            (weighted_ && weights_[v] > max_weight_)) {
+            return false;
+        }
+        moved_.push_back(v);
+        update_copies(v);
+    }
+    return true;
+}
+
+// Checks the certificates of every triangle around a moved point.
+bool DelaunayContext2d::certify_moved_points() const {
+    for (int v : moved_) {
+        for (int i = vertex_triangles_rowptr_[v]; i < vertex_triangles_rowptr_[v + 1]; ++i) {
+            if (!certify_triangle(GEO::index_t(vertex_triangles_[i]))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+double DelaunayContext2d::lifted_height(GEO::index_t v) const {
+    const double* p = &extended_points_[size_t(v) * dimension_];
+    return p[0] * p[0] + p[1] * p[1] - (weighted_ ? weights_[real_vertex(v)] : 0.0);
+}
+
+bool DelaunayContext2d::certify_triangle(GEO::index_t t) const {
+    const GEO::Delaunay2d& D = *delaunay_;
+    const double* p[4];
+    double h[4];
+    for (GEO::index_t lv = 0; lv < 3; ++lv) {
+        const GEO::index_t v = D.cell_vertex(t, lv);
+        p[lv] = &extended_points_[size_t(v) * dimension_];
+        h[lv] = lifted_height(v);
+    }
+    if (GEO::PCK::orient_2d(p[0], p[1], p[2]) <= 0) {
+        return false;
+    }
+    if (is_periodic_ && !circle_within_copies(t)) {
+        return false;
+    }
+    for (GEO::index_t le = 0; le < 3; ++le) {
+        const GEO::index_t neighbor = D.cell_adjacent(t, le);
+        // Convex hull edge: not certified. In periodic mode the neighbor
+        // must also be a triangle of the periodic triangulation, for its
+        // opposite vertex to be the one across the edge.
+        if (neighbor == GEO::NO_INDEX || (is_periodic_ && !circle_within_copies(neighbor))) {
+            return false;
+        }
+        const GEO::index_t opposite = D.cell_vertex(neighbor, D.adjacent_index(neighbor, t));
+        p[3] = &extended_points_[size_t(opposite) * dimension_];
+        h[3] = lifted_height(opposite);
+        const GEO::Sign conflict =
+            weighted_ ? GEO::PCK::orient_2dlifted_SOS(p[0], p[1], p[2], p[3],
+                                                      h[0], h[1], h[2], h[3])
+                      : GEO::PCK::in_circle_2d_SOS(p[0], p[1], p[2], p[3]);
+        if (conflict > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The Voronoi vertices of a cell are the circumcenters of the triangles
+// around it, so a cell changes exactly when one of them has a moved
+// vertex: the moved points and their Delaunay neighbors.
+void DelaunayContext2d::collect_changed_cells() {
+    const int n = num_points_;
+    char* changed_mark = frame_arena().allocate_array<char>(size_t(n));
+    std::fill(changed_mark, changed_mark + n, 0);
+    changed_cells_.clear();
+    for (int v : moved_) {
+        for (int k = vertex_triangles_rowptr_[v]; k < vertex_triangles_rowptr_[v + 1]; ++k) {
+            for (GEO::index_t lv = 0; lv < 3; ++lv) {
+                const int w =
+                    real_vertex(delaunay_->cell_vertex(GEO::index_t(vertex_triangles_[k]), lv));
+                if (!changed_mark[w]) {
+                    changed_mark[w] = 1;
+                    changed_cells_.push_back(w);
+                }
+            }
+        }
+    }
+    std::sort(changed_cells_.begin(), changed_cells_.end());
+}
+
+bool DelaunayContext2d::neighbors(int v, std::vector<int>& neighbors,
+                                  std::vector<double>* positions) const {
+    neighbors.clear();
+    if (positions) {
+        positions->clear();
+    }
+    if (!has_triangulation_ || v < 0 || v >= num_points_) {
+        return false;
+    }
+    for (int k = vertex_triangles_rowptr_[v]; k < vertex_triangles_rowptr_[v + 1]; ++k) {
+        for (GEO::index_t lv = 0; lv < 3; ++lv) {
+            const GEO::index_t w = delaunay_->cell_vertex(GEO::index_t(vertex_triangles_[k]), lv);
+            // Skips v itself and its own periodic copies.
+            const int real = real_vertex(w);
+            if (real == v ||
+                std::find(neighbors.begin(), neighbors.end(), real) != neighbors.end()) {
+                continue;
+            }
+            neighbors.push_back(real);
+            if (positions) {
+                const double* p = &extended_points_[size_t(w) * dimension_];
+                positions->insert(positions->end(), {p[0], p[1]});
+            }
+        }
+    }
+    return true;
+}
+
+bool DelaunayContext2d::compute_adjacency() {
+    if (!has_triangulation_) {
+        return false;
+    }
+    if (adjacency_valid_) {
+        return true;
+    }
+    frame_arena().reset();
+    const int n = num_points_;
+    // last_seen[w] == v once w is a neighbor of v: one pass per star.
+    int* last_seen = frame_arena().allocate_array<int>(size_t(n));
+    std::fill(last_seen, last_seen + n, -1);
+    adjacency_rowptr_.resize(size_t(n) + 1);
+    adjacency_.clear();
+    adjacency_rowptr_[0] = 0;
+    for (int v = 0; v < n; ++v) {
+        last_seen[v] = v;
+        for (int k = vertex_triangles_rowptr_[v]; k < vertex_triangles_rowptr_[v + 1]; ++k) {
+            for (GEO::index_t lv = 0; lv < 3; ++lv) {
+                const int real =
+                    real_vertex(delaunay_->cell_vertex(GEO::index_t(vertex_triangles_[k]), lv));
+                if (last_seen[real] != v) {
+                    last_seen[real] = v;
+                    adjacency_.push_back(real);
+                }
+            }
+        }
+        adjacency_rowptr_[v + 1] = int(adjacency_.size());
+        std::sort(adjacency_.begin() + adjacency_rowptr_[v], adjacency_.end());
+    }
+    adjacency_valid_ = true;
+    ++adjacency_version_;
+    return true;
+}
+
+bool DelaunayContext2d::compute_voronoi_cells() {
+    if (!has_triangulation_) {
+        return false;
+    }
+    const int n = num_points_;
+    voronoi_vertices_.clear();
+    voronoi_vertex_ptr_.assign(1, 0);
+    voronoi_edge_neighbor_.clear();
+    for (int i = 0; i < n; ++i) {
+        build_voronoi_cell(i);
+        voronoi_vertices_.insert(voronoi_vertices_.end(), polygon_.begin(), polygon_.end());
+        voronoi_edge_neighbor_.insert(voronoi_edge_neighbor_.end(), polygon_edges_.begin(),
+                                      polygon_edges_.end());
+        voronoi_vertex_ptr_.push_back(int(voronoi_edge_neighbor_.size()));
+    }
+
+    voronoi_cells_.clear();
+    voronoi_cells_.reserve(2 + voronoi_vertex_ptr_.size() + voronoi_edge_neighbor_.size());
+    voronoi_cells_.push_back(n);
+    voronoi_cells_.push_back(int(voronoi_edge_neighbor_.size()));
+    voronoi_cells_.insert(voronoi_cells_.end(), voronoi_vertex_ptr_.begin(),
+                          voronoi_vertex_ptr_.end());
+    voronoi_cells_.insert(voronoi_cells_.end(), voronoi_edge_neighbor_.begin(),
+                          voronoi_edge_neighbor_.end());
+    voronoi_version_ = update_version_;
+    return true;
+}
+
+bool DelaunayContext2d::compute_cell_acuteness(bool changed_only) {
+    if (!has_triangulation_ || voronoi_version_ != update_version_) {
+        return false;
+    }
+    if (cell_scores_version_ == update_version_) {
+        return true;
+    }
+    const int n = voronoi_cells_[0];
+    // changed_cells() only covers the last update
+    if (changed_only && cell_scores_version_ == update_version_ - 1 &&
+        int(cell_scores_.size()) == n) {
+        updateCellAcuteness2d(voronoi_vertices_.data(), &voronoi_cells_[2], n, changed_cells_,
+                              cell_scores_);
+    } else {
+        calculateCellAcuteness2dInto(voronoi_vertices_.data(), &voronoi_cells_[2], n, cell_scores_);
+    }
+    cell_scores_version_ = update_version_;
+    return true;
+}
+
+// Loads the Voronoi cell of point i into polygon_ / polygon_edges_: a box
+// (the unit square, or in periodic mode the square of side 2 around the
+// point) clipped by the bisector of each Delaunay neighbor, in power
+// distance.
+void DelaunayContext2d::build_voronoi_cell(int i) {
+    const double* pi = &extended_points_[size_t(i) * dimension_];
+    const double wi = weighted_ ? weights_[i] : 0.0;
+    double x0 = 0.0, y0 = 0.0, x1 = 1.0, y1 = 1.0;
+    if (is_periodic_) {
+        x0 = pi[0] - 1.0;
+        y0 = pi[1] - 1.0;
+        x1 = pi[0] + 1.0;
+        y1 = pi[1] + 1.0;
+    }
+    polygon_.assign({x0, y0, x1, y0, x1, y1, x0, y1});
+    polygon_edges_.assign(4, -1);
+
+    // Each neighbor instance once; distinct copies of a point are distinct
+    // bisectors.
+    cell_neighbors_.clear();
+    for (int k = vertex_triangles_rowptr_[i]; k < vertex_triangles_rowptr_[i + 1]; ++k) {
+        for (GEO::index_t lv = 0; lv < 3; ++lv) {
+            const int j = int(delaunay_->cell_vertex(GEO::index_t(vertex_triangles_[k]), lv));
+            if (j != i && std::find(cell_neighbors_.begin(), cell_neighbors_.end(), j) ==
+                              cell_neighbors_.end()) {
+                cell_neighbors_.push_back(j);
+            }
+        }
+    }
+
+    for (int j : cell_neighbors_) {
+        const int label = real_vertex(GEO::index_t(j));
+        const double* pj = &extended_points_[size_t(j) * dimension_];
+        const double wj = weighted_ ? weights_[label] : 0.0;
+        // Inside where a.x + b.y <= c.
+        const double a = 2.0 * (pj[0] - pi[0]);
+        const double b = 2.0 * (pj[1] - pi[1]);
+        const double c = pj[0] * pj[0] + pj[1] * pj[1] - pi[0] * pi[0] - pi[1] * pi[1] - wj + wi;
+        const size_t count = polygon_edges_.size();
+        clipped_.clear();
+        clipped_edges_.clear();
+        for (size_t k = 0; k < count; ++k) {
+            const size_t l = (k + 1) % count;
+            const double ax = polygon_[2 * k], ay = polygon_[2 * k + 1];
+            const double bx = polygon_[2 * l], by = polygon_[2 * l + 1];
+            const double da = a * ax + b * ay - c;
+            const double db = a * bx + b * by - c;
+            if (da <= 0.0) {
+                clipped_.insert(clipped_.end(), {ax, ay});
+                clipped_edges_.push_back(polygon_edges_[k]);
+            }
+            if ((da <= 0.0) != (db <= 0.0)) {
+                const double s = da / (da - db);
+                clipped_.insert(clipped_.end(), {ax + s * (bx - ax), ay + s * (by - ay)});
+                clipped_edges_.push_back(da <= 0.0 ? label : polygon_edges_[k]);
+            }
+        }
+        polygon_.swap(clipped_);
+        polygon_edges_.swap(clipped_edges_);
+    }
+}
+
+size_t DelaunayContext2d::memory_bytes() const {
+    size_t bytes = delaunay_ ? delaunay_->memory_bytes() : 0;
+    for (const std::vector<double>* v : {&points_, &reference_points_, &weights_,
+                                         &reference_weights_, &extended_points_, &polygon_,
+                                         &clipped_, &voronoi_vertices_}) {
+        bytes += capacity_bytes(*v);
+    }
+    for (const std::vector<int>* v : {&copy_source_, &copy_first_, &triangles_,
+                                      &vertex_triangles_rowptr_, &vertex_triangles_, &moved_,
+                                      &changed_cells_, &adjacency_rowptr_, &adjacency_,
+                                      &cell_neighbors_, &polygon_edges_, &clipped_edges_,
+                                      &voronoi_cells_, &voronoi_vertex_ptr_,
+                                      &voronoi_edge_neighbor_, &cell_scores_}) {
+        bytes += capacity_bytes(*v);
+    }
+    return bytes + capacity_bytes(copy_shift_) + capacity_bytes(copy_masks_);
+}
+
+void DelaunayContext2d::destroy() {
+    delaunay_.reset();
+    std::vector<double>().swap(points_);
+    std::vector<double>().swap(reference_points_);
+    std::vector<double>().swap(weights_);
+    std::vector<double>().swap(reference_weights_);
+    weighted_ = false;
+    std::vector<double>().swap(extended_points_);
+    std::vector<int>().swap(copy_source_);
+    std::vector<int8_t>().swap(copy_shift_);
+    std::vector<uint16_t>().swap(copy_masks_);
+    std::vector<int>().swap(copy_first_);
+    margin_points_ = -1;
+    std::vector<int>().swap(triangles_);
+    std::vector<int>().swap(vertex_triangles_rowptr_);
+    std::vector<int>().swap(vertex_triangles_);
+    std::vector<int>().swap(moved_);
+    std::vector<int>().swap(changed_cells_);
+    std::vector<int>().swap(adjacency_rowptr_);
+    std::vector<int>().swap(adjacency_);
+    adjacency_valid_ = false;
+    std::vector<int>().swap(cell_neighbors_);
+    std::vector<double>().swap(polygon_);
+    std::vector<int>().swap(polygon_edges_);
+    std::vector<double>().swap(clipped_);
+    std::vector<int>().swap(clipped_edges_);
+    std::vector<int>().swap(voronoi_cells_);
+    std::vector<double>().swap(voronoi_vertices_);
+    std::vector<int>().swap(voronoi_vertex_ptr_);
+    std::vector<int>().swap(voronoi_edge_neighbor_);
+    std::vector<int>().swap(cell_scores_);
+    voronoi_version_ = -1;
+    cell_scores_version_ = -1;
+    ++update_version_;
+    num_points_ = 0;
+    has_triangulation_ = false;
+    last_update_incremental_ = false;
+}
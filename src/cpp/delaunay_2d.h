@@ -0,0 +1,239 @@
+// delaunay_2d.h
+//
+// Periodic / non-periodic Delaunay triangulation and Voronoi cells of points
+// in the unit square, for 2D cross-section studies: the plane counterpart of
+// DelaunayContext, at a fraction of the cost of the 3D periodic engine. Built
+// on the PSM's Delaunay2d ("BDEL2d"), or RegularWeightedDelaunay2d
+// ("BPOW2d") for weighted points.
+//
+// The PSM has no periodic 2D triangulation, so the periodic mode
+// triangulates the points together with the copies, translated by one
+// period, of those within a margin of the sides of the square. A triangle is
+// kept (once, in the frame of its lowest point index) when the disk of the
+// points it conflicts with lies within the copies, so that the result is the
+// periodic triangulation; the margin grows until every triangle around a
+// real point passes, and is kept for the next frames.
+
+#pragma once
+
+#include "delaunay_core.h"
+#include <cstdint>
+#include <vector>
+
+class DelaunayContext2d {
+public:
+    explicit DelaunayContext2d(bool is_periodic);
+
+    bool is_periodic() const {
+        return is_periodic_;
+    }
+
+    int num_points() const {
+        return num_points_;
+    }
+
+    // The context's coordinate buffer, sized for num_points xy pairs, to be
+    // filled in place before compute().
+    double* points_buffer(int num_points);
+
+    // Copies num_points xy pairs into the context.
+    void set_points(const double* coords, int num_points);
+
+    // The current points, 2 coordinates per point. In periodic mode compute()
+    // wraps them into [0,1) in place.
+    const std::vector<double>& points() const {
+        return points_;
+    }
+
+    // Weighted mode, as DelaunayContext: with one weight per point, the
+    // regular triangulation and power cells for the power distance
+    // |x - p_i|^2 - w_i. compute() fails if a point's cell is empty.
+    double* weights_buffer(int num_points);
+
+    void set_weights(const double* weights, int num_points);
+
+    void clear_weights();
+
+    bool is_weighted() const {
+        return weighted_;
+    }
+
+    // Triangulates the current points. The unique triangles (3 indices per
+    // triangle, counterclockwise in the frame of their first vertex) are
+    // then in triangles() until the next call. Returns false on failure.
+    bool compute();
+
+    // Kinetic update for small displacements, as
+    // DelaunayContext::compute_incremental(): the triangles around the moved
+    // points are re-certified (positive orientation, no neighbor's opposite
+    // vertex in their circle, and in periodic mode their circles still within
+    // the copies), and kept if all hold. Falls back to compute() when a
+    // certificate fails, the point count changed, a point moved further than
+    // max_displacement, left [0,1) or gained or lost a copy, or a moved point
+    // touches the convex hull.
+    bool compute_incremental(double max_displacement);
+
+    const std::vector<int>& triangles() const {
+        return triangles_;
+    }
+
+    bool has_triangulation() const {
+        return has_triangulation_;
+    }
+
+    bool last_update_was_incremental() const {
+        return last_update_incremental_;
+    }
+
+    // Cells whose Voronoi cell may differ since the previous update: every
+    // cell after a full compute(), the moved points and their Delaunay
+    // neighbors after an incremental one.
+    const std::vector<int>& changed_cells() const {
+        return changed_cells_;
+    }
+
+    int last_moved_count() const {
+        return int(moved_.size());
+    }
+
+    // Incremented by every compute() (including the fallback of
+    // compute_incremental()), successful incremental update and destroy(),
+    // as DelaunayContext::update_version().
+    int update_version() const {
+        return update_version_;
+    }
+
+    // Delaunay neighbors of point v, each once. If positions is not null,
+    // it receives the xy coordinates of every neighbor as seen from v
+    // (across the sides of the square in periodic mode). Returns false
+    // without a triangulation.
+    bool neighbors(int v, std::vector<int>& neighbors,
+                   std::vector<double>* positions = nullptr) const;
+
+    // Delaunay graph in CSR form, as DelaunayContext::compute_adjacency():
+    // sorted, each neighbor once, kept through incremental updates.
+    bool compute_adjacency();
+
+    const std::vector<int>& adjacency_rowptr() const {
+        return adjacency_rowptr_;
+    }
+
+    const std::vector<int>& adjacency() const {
+        return adjacency_;
+    }
+
+    int adjacency_version() const {
+        return adjacency_version_;
+    }
+
+    // Voronoi (power) cell of every point, as convex polygons packed in
+    // voronoi_cells():
+    //   [0] num_cells (n)  [1] num_vertices (V)
+    //   cell_vertex_ptr[n + 1]  range of each cell in the vertex array
+    //   edge_neighbor[V]        point across the edge from each vertex to
+    //                           the next one of its cell, -1 for the box
+    // The xy coordinates of the V vertices, counterclockwise in each cell,
+    // are in voronoi_cell_vertices(). Periodic cells are not clipped, so a
+    // cell may cross the sides of the square; non-periodic ones are clipped
+    // by the unit square. Returns false without a triangulation.
+    bool compute_voronoi_cells();
+
+    const std::vector<int>& voronoi_cells() const {
+        return voronoi_cells_;
+    }
+
+    const std::vector<double>& voronoi_cell_vertices() const {
+        return voronoi_vertices_;
+    }
+
+    // Acute interior angles of each cell of compute_voronoi_cells() into
+    // cell_scores() (calculateCellAcuteness2dInto()). With changed_only, and
+    // scores kept from the update just before the cells', only the
+    // changed_cells() are rescored; otherwise every cell is. Returns false
+    // unless the cells are those of the current update.
+    bool compute_cell_acuteness(bool changed_only);
+
+    const std::vector<int>& cell_scores() const {
+        return cell_scores_;
+    }
+
+    // Counters and stage timings of the last update. The tet counters count
+    // triangles: num_raw_tets those of the PSM (copies included),
+    // num_unique_tets those of triangles(). marshal covers the wrapping and
+    // the copies, dedup the selection of the unique triangles.
+    const DelaunayStats& stats() const {
+        return stats_;
+    }
+
+    // Bytes held by the context, PSM stores included.
+    size_t memory_bytes() const;
+
+    // Releases the triangulation and every buffer.
+    void destroy();
+
+private:
+    bool triangulate();
+    bool select_triangles(bool& grow_margin);
+    void build_copies();
+    int copy_mask(const double* p) const;
+    void update_copies(int v);
+    int real_vertex(GEO::index_t v) const;
+    bool circle_within_copies(GEO::index_t t) const;
+    double lifted_height(GEO::index_t v) const;
+    bool certify_moved_points() const;
+    bool certify_triangle(GEO::index_t t) const;
+    bool collect_moved_points(double max_displacement);
+    void build_vertex_to_triangles();
+    void collect_changed_cells();
+    void build_voronoi_cell(int i);
+
+    bool is_periodic_;
+    bool weighted_;
+    int num_points_;
+    bool has_triangulation_;
+    bool last_update_incremental_;
+    GEO::SmartPointer<GEO::Delaunay2d> delaunay_;
+    bool delaunay_weighted_;
+    std::vector<double> points_;
+    std::vector<double> reference_points_;
+    std::vector<double> weights_;
+    std::vector<double> reference_weights_;
+    double max_weight_;
+
+    // Extended point set: the n points, then the copies (source point and
+    // translation in periods), xy or, weighted, xy and the lifting the PSM
+    // expects. copy_masks_ has the translations of the copies of each point.
+    double margin_;
+    int margin_points_;  // point count margin_ was found for
+    int dimension_;
+    std::vector<double> extended_points_;
+    std::vector<int> copy_source_;
+    std::vector<int8_t> copy_shift_;
+    std::vector<uint16_t> copy_masks_;
+    std::vector<int> copy_first_;  // first copy of each point, CSR
+
+    std::vector<int> triangles_;
+    std::vector<int> vertex_triangles_rowptr_;
+    std::vector<int> vertex_triangles_;
+    std::vector<int> moved_;
+    std::vector<int> changed_cells_;
+    std::vector<int> adjacency_rowptr_;
+    std::vector<int> adjacency_;
+    bool adjacency_valid_;
+    int adjacency_version_;
+    int update_version_;
+    DelaunayStats stats_;
+
+    std::vector<int> cell_neighbors_;  // star of the cell being clipped
+    std::vector<double> polygon_;      // xy of the cell being clipped
+    std::vector<int> polygon_edges_;   // neighbor across each of its edges
+    std::vector<double> clipped_;
+    std::vector<int> clipped_edges_;
+    std::vector<int> voronoi_cells_;
+    std::vector<double> voronoi_vertices_;
+    std::vector<int> voronoi_vertex_ptr_;
+    std::vector<int> voronoi_edge_neighbor_;
+    int voronoi_version_;      // update_version_ of voronoi_cells_, or -1
+    std::vector<int> cell_scores_;
+    int cell_scores_version_;  // update_version_ of the cells scored, or -1
+};
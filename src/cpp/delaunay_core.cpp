@@ -0,0 +1,1066 @@
+// delaunay_core.cpp
+//
+// Implementation of delaunay_core.h.
+
+#include "delaunay_core.h"
+#include "frame_arena.h"
+#include <iostream>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/heap.h>
+#endif
+
+#ifndef VORONOI_LOG_LEVEL
+#define VORONOI_LOG_LEVEL LOG_ERRORS
+#endif
+
+// Global initialization flag
+static bool g_geogram_initialized = false;
+
+static int g_log_level = VORONOI_LOG_LEVEL;
+
+void set_log_level(int level) {
+    g_log_level = std::max(int(LOG_QUIET), std::min(level, int(LOG_DEBUG)));
+    if (g_geogram_initialized) {
+        GEO::Logger::instance()->set_quiet(g_log_level < LOG_INFO);
+    }
+}
+
+int log_level() {
+    return g_log_level;
+}
+
+// Initialize Geogram once
+void initialize_geogram() {
+    if (!g_geogram_initialized) {
+        // Initialize Geogram using the PSM's initialize function
+        GEO::initialize();
+        g_geogram_initialized = true;
+        GEO::Logger::instance()->set_quiet(g_log_level < LOG_INFO);
+        if (g_log_level >= LOG_INFO) {
+            std::cout << "Geogram initialized." << std::endl;
+        }
+    }
+}
+
+void sample_memory(DelaunayStats& stats) {
+#ifdef __EMSCRIPTEN__
+    // WASM memory only grows, so the current size is also the peak.
+    stats.heap_bytes = double(emscripten_get_heap_size());
+    stats.peak_memory_bytes = stats.heap_bytes;
+#else
+    stats.heap_bytes = double(GEO::Process::used_memory());
+    stats.peak_memory_bytes = double(GEO::Process::max_used_memory());
+#endif
+}
+
+// Creates a PeriodicDelaunay3d configured the way every entry point uses it.
+std::unique_ptr<GEO::PeriodicDelaunay3d> create_delaunay(bool is_periodic) {
+    initialize_geogram();
+
+    std::unique_ptr<GEO::PeriodicDelaunay3d> delaunay;
+
+    if (is_periodic) {
+        delaunay = std::make_unique<GEO::PeriodicDelaunay3d>(GEO::vec3(1.0, 1.0, 1.0));
+    } else {
+        delaunay = std::make_unique<GEO::PeriodicDelaunay3d>(false);
+    }
+
+    delaunay->set_stores_cicl(false);
+    return delaunay;
+}
+
+namespace {
+
+// Appends the tets of a triangulation to tets_out, specialized at compile
+// time on the periodicity and on the translation output, so that the loop
+// over the tet vertices has no branch. In periodic mode vertex pv is the
+// copy pv / n (the PSM's instance) of real vertex pv % n: the real indices
+// are deduplicated, and the lattice translation of each instance, relative
+// to the first vertex of the tet, goes to translations if enabled. Returns
+// the number of out-of-range indices, replaced by 0.
+template <bool PERIODIC, bool TRANSLATIONS, class TetVector>
+int extract_tets(const GEO::PeriodicDelaunay3d& delaunay, int num_tets, int num_points,
+                 TetDeduplicator& dedup, TetVector& tets_out, std::vector<int8_t>* translations) {
+    const GEO::index_t* cell_to_v = delaunay.cell_to_v();
+    const size_t offset = tets_out.size();
+    if (!PERIODIC) {
+        tets_out.resize(offset + size_t(num_tets) * 4);
+        std::copy(cell_to_v, cell_to_v + size_t(num_tets) * 4, tets_out.begin() + offset);
+        if (TRANSLATIONS) {
+            translations->resize(translations->size() + size_t(num_tets) * 12, 0);
+        }
+        return 0;
+    }
+
+    const GEO::index_t n = GEO::index_t(num_points);
+    // pv / n without an integer division: (pv + 0.5) / n is at least 0.5 / n
+    // away from an integer, far more than the rounding error of the product.
+    const double inv_n = 1.0 / double(std::max(num_points, 1));
+    dedup.reset(num_tets);
+    tets_out.reserve(offset + size_t(num_tets) * 4);
+    if (TRANSLATIONS) {
+        translations->reserve(translations->size() + size_t(num_tets) * 12);
+    }
+    int invalid_count = 0;
+    for (int t = 0; t < num_tets; ++t) {
+        int tet[4];
+        GEO::index_t instance[4];
+        for (int v = 0; v < 4; ++v) {
+            const GEO::index_t pv = cell_to_v[size_t(t) * 4 + v];
+            // Real vertices are the vast majority: the test is well predicted.
+            const GEO::index_t copy = pv < n ? 0 : GEO::index_t((double(pv) + 0.5) * inv_n);
+            const bool valid = copy < 27;
+            invalid_count += int(!valid);
+            tet[v] = valid ? int(pv - copy * n) : 0;
+            instance[v] = valid ? copy : 0;
+        }
+        if (dedup.insert(make_tet_key(tet))) {
+            tets_out.insert(tets_out.end(), tet, tet + 4);
+            if (TRANSLATIONS) {
+                const int* origin = GEO::Periodic::translation[instance[0]];
+                for (int v = 0; v < 4; ++v) {
+                    const int* shift = GEO::Periodic::translation[instance[v]];
+                    for (int c = 0; c < 3; ++c) {
+                        translations->push_back(int8_t(shift[c] - origin[c]));
+                    }
+                }
+            }
+        }
+    }
+    return invalid_count;
+}
+
+} // namespace
+
+template <class TetVector>
+bool compute_unique_tets(GEO::PeriodicDelaunay3d& delaunay,
+                         double* coords, int num_points, bool is_periodic,
+                         TetDeduplicator& dedup, TetVector& tets_out,
+                         DelaunayStats* stats, std::vector<int8_t>* translations) {
+    // --- 1. Initialize ---
+    initialize_geogram();
+    GEO::Stopwatch total_watch("total", false);
+    GEO::Stopwatch stage_watch("stage", false);
+    DelaunayStats local_stats;
+    DelaunayStats& S = stats ? *stats : local_stats;
+    S = DelaunayStats();
+
+    // --- 2. Normalize points ---
+    // Periodic coordinates must be in [0,1); a bounded triangulation takes
+    // them as they are.
+    if (is_periodic) {
+        for (int i = 0; i < num_points * 3; i++) {
+            double& coord = coords[i];
+            while (coord < 0.0) coord += 1.0;
+            while (coord >= 1.0) coord -= 1.0;
+        }
+    }
+    S.marshal = stage_watch.elapsed_time();
+
+    // --- 3. Set vertices ---
+    double stage_start = stage_watch.elapsed_time();
+    delaunay.set_vertices(num_points, coords);
+    S.reorder = stage_watch.elapsed_time() - stage_start;
+
+    // --- 4. Compute ---
+    stage_start = stage_watch.elapsed_time();
+    try {
+        delaunay.compute();
+    } catch (const std::exception& e) {
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "Exception during compute: " << e.what() << std::endl;
+        }
+        return false;
+    } catch (...) {
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "Unknown exception during compute." << std::endl;
+        }
+        return false;
+    }
+    const double compute_time = stage_watch.elapsed_time() - stage_start;
+    if (delaunay.has_empty_cells()) {
+        // Only possible with weights: the PSM stops before compressing.
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "Weighted triangulation of " << num_points
+                      << " points has empty power cells." << std::endl;
+        }
+        return false;
+    }
+    const GEO::PeriodicDelaunay3d::Stats& psm_stats = delaunay.stats();
+    S.insertion = psm_stats.phase_0_t_;
+    S.periodic_phase_1 = psm_stats.phase_I_t_;
+    S.periodic_phase_2 = psm_stats.phase_II_t_;
+    S.compress = std::max(0.0, compute_time - psm_stats.phase_0_t_ -
+                                   psm_stats.phase_I_t_ - psm_stats.phase_II_t_);
+    S.nb_reallocations = int(delaunay.nb_reallocations());
+
+    // --- 5. Get results ---
+    int num_tets = delaunay.nb_cells();
+    S.num_raw_tets = num_tets;
+
+    if (g_log_level >= LOG_DEBUG) {
+        std::cout << "Delaunay: " << num_points << " points, periodic " << is_periodic
+                  << ", " << delaunay.nb_vertices() << " vertices, "
+                  << num_tets << " tetrahedra." << std::endl;
+    }
+    if (num_tets == 0 && num_points >= 4 && g_log_level >= LOG_ERRORS) {
+        std::cerr << "No tetrahedra generated from " << num_points
+                  << " points (degenerate point configuration?)" << std::endl;
+    }
+
+    stage_start = stage_watch.elapsed_time();
+    if (!is_periodic) {
+        // Without periodic copies every tet is unique and needs no remapping.
+        if (translations) {
+            extract_tets<false, true>(delaunay, num_tets, num_points, dedup, tets_out, translations);
+        } else {
+            extract_tets<false, false>(delaunay, num_tets, num_points, dedup, tets_out, translations);
+        }
+        S.output = stage_watch.elapsed_time() - stage_start;
+        S.num_unique_tets = num_tets;
+        S.total = total_watch.elapsed_time();
+        sample_memory(S);
+        return true;
+    }
+
+    const int invalid_count = translations ?
+        extract_tets<true, true>(delaunay, num_tets, num_points, dedup, tets_out, translations) :
+        extract_tets<true, false>(delaunay, num_tets, num_points, dedup, tets_out, translations);
+    S.dedup = stage_watch.elapsed_time() - stage_start;
+    S.num_unique_tets = int(dedup.size());
+
+    if (invalid_count > 0 && g_log_level >= LOG_ERRORS) {
+        std::cerr << invalid_count << " invalid vertex indices replaced by 0." << std::endl;
+    }
+    if (g_log_level >= LOG_DEBUG) {
+        std::cout << "Delaunay: " << S.num_unique_tets << " unique tetrahedra, "
+                  << num_tets - S.num_unique_tets << " duplicates." << std::endl;
+    }
+
+    S.total = total_watch.elapsed_time();
+    sample_memory(S);
+    return true;
+}
+
+template bool compute_unique_tets(GEO::PeriodicDelaunay3d&, double*, int, bool,
+                                  TetDeduplicator&, std::vector<int>&, DelaunayStats*,
+                                  std::vector<int8_t>*);
+template bool compute_unique_tets(GEO::PeriodicDelaunay3d&, double*, int, bool,
+                                  TetDeduplicator&, FrameVector<int>&, DelaunayStats*,
+                                  std::vector<int8_t>*);
+
+template <class TetVector>
+bool compute_bounded_tets(const double* coords, int num_points, TetVector& tets_out,
+                          DelaunayStats* stats) {
+    initialize_geogram();
+    GEO::Stopwatch total_watch("total", false);
+    DelaunayStats local_stats;
+    DelaunayStats& S = stats ? *stats : local_stats;
+    S = DelaunayStats();
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+    const char* backend = "PDEL";
+#else
+    const char* backend = "BDEL";
+#endif
+    GEO::Delaunay_var delaunay = GEO::Delaunay::create(3, backend);
+    if (delaunay.is_null()) {
+        delaunay = GEO::Delaunay::create(3, "BDEL");
+    }
+    if (delaunay.is_null()) {
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "Cannot create the " << backend << " Delaunay backend." << std::endl;
+        }
+        return false;
+    }
+    S.marshal = total_watch.elapsed_time();
+
+    // set_vertices() triangulates, BRIO reordering included.
+    double stage_start = total_watch.elapsed_time();
+    try {
+        delaunay->set_vertices(GEO::index_t(std::max(num_points, 0)), coords);
+    } catch (const std::exception& e) {
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "Exception during compute: " << e.what() << std::endl;
+        }
+        return false;
+    } catch (...) {
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "Unknown exception during compute." << std::endl;
+        }
+        return false;
+    }
+    S.insertion = total_watch.elapsed_time() - stage_start;
+
+    stage_start = total_watch.elapsed_time();
+    const int num_tets = int(delaunay->nb_cells());
+    const GEO::index_t* cell_to_v = delaunay->cell_to_v();
+    const size_t offset = tets_out.size();
+    tets_out.resize(offset + size_t(num_tets) * 4);
+    std::copy(cell_to_v, cell_to_v + size_t(num_tets) * 4, tets_out.begin() + offset);
+    S.output = total_watch.elapsed_time() - stage_start;
+    S.num_raw_tets = num_tets;
+    S.num_unique_tets = num_tets;
+
+    if (g_log_level >= LOG_DEBUG) {
+        std::cout << "Delaunay (" << backend << "): " << num_points << " points, "
+                  << num_tets << " tetrahedra." << std::endl;
+    }
+    if (num_tets == 0 && num_points >= 4 && g_log_level >= LOG_ERRORS) {
+        std::cerr << "No tetrahedra generated from " << num_points
+                  << " points (degenerate point configuration?)" << std::endl;
+    }
+
+    S.total = total_watch.elapsed_time();
+    sample_memory(S);
+    return true;
+}
+
+template bool compute_bounded_tets(const double*, int, std::vector<int>&, DelaunayStats*);
+template bool compute_bounded_tets(const double*, int, FrameVector<int>&, DelaunayStats*);
+
+DelaunayContext::DelaunayContext(bool is_periodic) :
+    is_periodic_(is_periodic),
+    weighted_(false),
+    num_points_(0),
+    has_triangulation_(false),
+    last_update_incremental_(false),
+    keep_translations_(false),
+    single_threaded_(false),
+    low_memory_(false),
+    kept_queries_(KEEP_ALL_QUERIES),
+    stores_released_(false),
+    adjacency_valid_(false),
+    adjacency_version_(0),
+    update_version_(0) {
+    delaunay_ = create_delaunay(is_periodic_);
+}
+
+double* DelaunayContext::points_buffer(int num_points) {
+    num_points_ = std::max(num_points, 0);
+    points_.resize(size_t(num_points_) * 3);
+    return points_.data();
+}
+
+void DelaunayContext::set_points(const double* coords, int num_points) {
+    double* buffer = points_buffer(num_points);
+    std::copy(coords, coords + size_t(num_points_) * 3, buffer);
+}
+
+double* DelaunayContext::weights_buffer(int num_points) {
+    weighted_ = true;
+    weights_.resize(size_t(std::max(num_points, 0)));
+    return weights_.data();
+}
+
+void DelaunayContext::set_weights(const double* weights, int num_points) {
+    double* buffer = weights_buffer(num_points);
+    std::copy(weights, weights + weights_.size(), buffer);
+}
+
+void DelaunayContext::clear_weights() {
+    weighted_ = false;
+    std::vector<double>().swap(weights_);
+}
+
+bool DelaunayContext::compute() {
+    frame_arena().reset();
+    ++update_version_;
+    last_update_incremental_ = false;
+    adjacency_valid_ = false;
+    stores_released_ = false;
+    moved_.clear();
+    changed_cells_.clear();
+    if (!delaunay_) {
+        delaunay_ = create_delaunay(is_periodic_);
+    }
+    tets_.clear();
+    translations_.clear();
+    if (weighted_ && weights_.size() != size_t(num_points_)) {
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "DelaunayContext: " << weights_.size() << " weights for "
+                      << num_points_ << " points." << std::endl;
+        }
+        has_triangulation_ = false;
+        return false;
+    }
+    delaunay_->set_max_threads(single_threaded_ ? 1 : 0);
+    // The PSM reads the weights in place, like the coordinates.
+    delaunay_->set_weights(weighted_ ? weights_.data() : nullptr);
+    // Points laid out by sort_points_spatially() are inserted as they are.
+    const bool presorted = points_spatially_sorted();
+    delaunay_->set_reorder(!presorted);
+    if (presorted) {
+        delaunay_->set_BRIO_levels(spatial_levels_);
+    }
+    has_triangulation_ = compute_unique_tets(*delaunay_, points_.data(), num_points_,
+                                             is_periodic_, dedup_, tets_, &stats_,
+                                             keep_translations_ ? &translations_ : nullptr);
+    if (!has_triangulation_) {
+        return false;
+    }
+    GEO::Stopwatch output_watch("output", false);
+    stats_.weighted = weighted_;
+    reference_points_.assign(points_.begin(), points_.end());
+    reference_weights_.assign(weights_.begin(), weights_.end());
+    build_vertex_to_tets();
+    // New combinatorics: every cell may have changed.
+    changed_cells_.resize(size_t(num_points_));
+    for (int v = 0; v < num_points_; ++v) {
+        changed_cells_[v] = v;
+    }
+    if (low_memory_) {
+        release_stores();
+    }
+    stats_.output = output_watch.elapsed_time();
+    stats_.total += stats_.output;
+    stats_.retained_bytes = double(memory_bytes());
+    return true;
+}
+
+bool DelaunayContext::compute_incremental(double max_displacement) {
+    frame_arena().reset();
+    GEO::Stopwatch certify_watch("certify", false);
+    if (has_triangulation_ && weighted_ && delaunay_) {
+        delaunay_->set_weights(weights_.data());
+    }
+    if (!has_triangulation_ || !keeps(KEEP_INCREMENTAL) ||
+        reference_points_.size() != points_.size() ||
+        reference_weights_.size() != weights_.size() ||
+        (keep_translations_ && translations_.size() != tets_.size() * 3) ||
+        !collect_moved_points(max_displacement) || !certify_moved_points()) {
+        const double certify = certify_watch.elapsed_time();
+        bool ok = compute();
+        stats_.certify = certify;
+        stats_.total += certify;
+        return ok;
+    }
+    for (int v : moved_) {
+        std::copy(&points_[size_t(v) * 3], &points_[size_t(v) * 3] + 3,
+                  &reference_points_[size_t(v) * 3]);
+        if (weighted_) {
+            reference_weights_[v] = weights_[v];
+        }
+    }
+    last_update_incremental_ = true;
+    ++update_version_;
+    stats_.certify = certify_watch.elapsed_time();
+    collect_changed_cells();
+
+    // Same tets as before; only the certification and output stages ran.
+    const int num_raw_tets = stats_.num_raw_tets;
+    const int num_unique_tets = stats_.num_unique_tets;
+    const double certify = stats_.certify;
+    stats_ = DelaunayStats();
+    stats_.incremental = true;
+    stats_.weighted = weighted_;
+    stats_.certify = certify;
+    stats_.output = certify_watch.elapsed_time() - certify;
+    stats_.total = certify_watch.elapsed_time();
+    stats_.num_raw_tets = num_raw_tets;
+    stats_.num_unique_tets = num_unique_tets;
+    stats_.nb_reallocations = int(delaunay_->nb_reallocations());
+    sample_memory(stats_);
+    stats_.retained_bytes = double(memory_bytes());
+    return true;
+}
+
+bool DelaunayContext::sort_points_spatially() {
+    if (num_points_ < 4) {
+        return false;
+    }
+    frame_arena().reset();
+    if (!delaunay_) {
+        delaunay_ = create_delaunay(is_periodic_);
+    }
+    // set_vertices() only computes the BRIO order; nothing is inserted yet.
+    delaunay_->set_reorder(true);
+    delaunay_->set_vertices(GEO::index_t(num_points_), points_.data());
+    const GEO::index_t* order = delaunay_->insertion_order();
+    spatial_order_.assign(order, order + num_points_);
+    spatial_levels_ = delaunay_->BRIO_levels();
+
+    const size_t size = size_t(num_points_) * 3;
+    double* sorted = frame_arena().allocate_array<double>(size);
+    for (int k = 0; k < num_points_; ++k) {
+        std::copy(&points_[size_t(spatial_order_[k]) * 3],
+                  &points_[size_t(spatial_order_[k]) * 3] + 3, sorted + size_t(k) * 3);
+    }
+    std::copy(sorted, sorted + size, points_.begin());
+    if (weights_.size() == size_t(num_points_)) {
+        double* sorted_weights = frame_arena().allocate_array<double>(weights_.size());
+        for (int k = 0; k < num_points_; ++k) {
+            sorted_weights[k] = weights_[spatial_order_[k]];
+        }
+        std::copy(sorted_weights, sorted_weights + weights_.size(), weights_.begin());
+    }
+
+    has_triangulation_ = false;
+    last_update_incremental_ = false;
+    adjacency_valid_ = false;
+    ++update_version_;
+    tets_.clear();
+    translations_.clear();
+    moved_.clear();
+    changed_cells_.clear();
+    return true;
+}
+
+bool DelaunayContext::compute_voronoi_cells() {
+    return compute_voronoi_cells(0, num_points_);
+}
+
+bool DelaunayContext::compute_voronoi_cells(int first, int count) {
+    if (!has_triangulation_ || first < 0 || count < 0 || first > num_points_ - count) {
+        return false;
+    }
+    if (!keeps(KEEP_VORONOI_CELLS)) {
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "DelaunayContext: the low-memory mode dropped the stores of "
+                         "the Voronoi cells (KEEP_VORONOI_CELLS)." << std::endl;
+        }
+        return false;
+    }
+    frame_arena().reset();
+    const int n = count;
+    voronoi_vertices_.clear();
+    voronoi_vertex_ptr_.assign(1, 0);
+    voronoi_cell_face_ptr_.assign(1, 0);
+    voronoi_face_ptr_.assign(1, 0);
+    voronoi_face_neighbor_.clear();
+    voronoi_face_vertices_.clear();
+
+    for (int i = first; i < first + n; ++i) {
+        build_voronoi_cell(GEO::index_t(i));
+        append_voronoi_cell();
+        voronoi_vertex_ptr_.push_back(int(voronoi_vertices_.size() / 3));
+        voronoi_cell_face_ptr_.push_back(int(voronoi_face_neighbor_.size()));
+    }
+
+    const int num_faces = int(voronoi_face_neighbor_.size());
+    voronoi_cells_.clear();
+    voronoi_cells_.reserve(3 + 2 * size_t(n + 1) + 2 * size_t(num_faces) + 1 +
+                           voronoi_face_vertices_.size());
+    voronoi_cells_.push_back(n);
+    voronoi_cells_.push_back(num_faces);
+    voronoi_cells_.push_back(int(voronoi_vertices_.size() / 3));
+    for (const std::vector<int>* section : {&voronoi_vertex_ptr_, &voronoi_cell_face_ptr_,
+                                            &voronoi_face_ptr_, &voronoi_face_neighbor_,
+                                            &voronoi_face_vertices_}) {
+        voronoi_cells_.insert(voronoi_cells_.end(), section->begin(), section->end());
+    }
+    return true;
+}
+
+int DelaunayContext::copy_tets(int first, int count, int* out) const {
+    const int num_tets = int(tets_.size() / 4);
+    if (first < 0 || count <= 0 || first >= num_tets) {
+        return 0;
+    }
+    count = std::min(count, num_tets - first);
+    std::copy(tets_.begin() + size_t(first) * 4, tets_.begin() + size_t(first + count) * 4, out);
+    return count;
+}
+
+void DelaunayContext::destroy() {
+    delaunay_.reset();
+    std::vector<double>().swap(points_);
+    std::vector<double>().swap(reference_points_);
+    std::vector<double>().swap(weights_);
+    std::vector<double>().swap(reference_weights_);
+    weighted_ = false;
+    std::vector<int>().swap(tets_);
+    std::vector<int8_t>().swap(translations_);
+    std::vector<int>().swap(vertex_tets_rowptr_);
+    std::vector<int>().swap(vertex_tets_);
+    std::vector<int>().swap(moved_);
+    std::vector<int>().swap(changed_cells_);
+    std::vector<int>().swap(adjacency_rowptr_);
+    std::vector<int>().swap(adjacency_);
+    adjacency_valid_ = false;
+    std::vector<int>().swap(spatial_order_);
+    spatial_levels_.clear();
+    std::vector<int>().swap(voronoi_cells_);
+    std::vector<double>().swap(voronoi_vertices_);
+    std::vector<int>().swap(voronoi_vertex_ptr_);
+    std::vector<int>().swap(voronoi_cell_face_ptr_);
+    std::vector<int>().swap(voronoi_face_ptr_);
+    std::vector<int>().swap(voronoi_face_neighbor_);
+    std::vector<int>().swap(voronoi_face_vertices_);
+    std::vector<int>().swap(voronoi_triangle_vertex_);
+    dedup_ = TetDeduplicator();
+    stores_released_ = false;
+    num_points_ = 0;
+    has_triangulation_ = false;
+    last_update_incremental_ = false;
+    ++update_version_;
+}
+
+namespace {
+
+template <class Vector>
+size_t capacity_bytes(const Vector& v) {
+    return v.capacity() * sizeof(typename Vector::value_type);
+}
+
+} // namespace
+
+size_t DelaunayContext::memory_bytes() const {
+    size_t bytes = dedup_.memory_bytes() + (delaunay_ ? delaunay_->memory_bytes() : 0);
+    for (const std::vector<double>* v : {&points_, &reference_points_, &weights_,
+                                         &reference_weights_, &voronoi_vertices_}) {
+        bytes += capacity_bytes(*v);
+    }
+    for (const std::vector<int>* v : {&tets_, &vertex_tets_rowptr_, &vertex_tets_, &moved_,
+                                      &changed_cells_, &adjacency_rowptr_, &adjacency_,
+                                      &spatial_order_, &voronoi_cells_, &voronoi_vertex_ptr_,
+                                      &voronoi_cell_face_ptr_, &voronoi_face_ptr_,
+                                      &voronoi_face_neighbor_, &voronoi_face_vertices_,
+                                      &voronoi_triangle_vertex_}) {
+        bytes += capacity_bytes(*v);
+    }
+    return bytes + capacity_bytes(translations_) + capacity_bytes(spatial_levels_);
+}
+
+// true unless the low-memory mode released the stores of query at the
+// last compute().
+bool DelaunayContext::keeps(unsigned query) const {
+    return !stores_released_ || (kept_queries_ & query) != 0;
+}
+
+// Low-memory mode: frees the construction buffers, and the stores that
+// none of the kept queries reads. Every query reads the tets of the PSM;
+// the kinetic update also walks the tet adjacency, and so do the periodic
+// Voronoi cells (get_incident_tets()), while the non-periodic ones, the
+// neighbors and the kinetic update read the vertex -> tets incidence.
+void DelaunayContext::release_stores() {
+    stores_released_ = true;
+    dedup_ = TetDeduplicator();
+    const unsigned kept = kept_queries_;
+    if (kept == KEEP_TETS_ONLY) {
+        delaunay_.reset();
+    } else {
+        delaunay_->release_construction_buffers(
+            (kept & KEEP_INCREMENTAL) || (is_periodic_ && (kept & KEEP_VORONOI_CELLS)));
+    }
+    if (!(kept & (KEEP_NEIGHBORS | KEEP_INCREMENTAL)) &&
+        !(!is_periodic_ && (kept & KEEP_VORONOI_CELLS))) {
+        std::vector<int>().swap(vertex_tets_rowptr_);
+        std::vector<int>().swap(vertex_tets_);
+    }
+    if (!(kept & KEEP_INCREMENTAL)) {
+        std::vector<double>().swap(reference_points_);
+        std::vector<double>().swap(reference_weights_);
+        std::vector<int>().swap(moved_);
+    }
+}
+
+// Builds the (vertex -> PSM cells) incidence in CSR form. In periodic
+// mode only the tets incident to the real instance of a vertex are kept:
+// its star is complete, and every tet around one of its periodic copies
+// is a translate of one of them.
+void DelaunayContext::build_vertex_to_tets() {
+    const GEO::index_t n = GEO::index_t(num_points_);
+    const GEO::index_t nb_cells = delaunay_->nb_cells();
+    vertex_tets_rowptr_.assign(size_t(n) + 1, 0);
+    for (GEO::index_t t = 0; t < nb_cells; ++t) {
+        for (GEO::index_t lv = 0; lv < 4; ++lv) {
+            GEO::index_t v = delaunay_->cell_vertex(t, lv);
+            if (v < n) {
+                ++vertex_tets_rowptr_[v + 1];
+            }
+        }
+    }
+    for (GEO::index_t v = 0; v < n; ++v) {
+        vertex_tets_rowptr_[v + 1] += vertex_tets_rowptr_[v];
+    }
+    vertex_tets_.resize(vertex_tets_rowptr_[n]);
+    int* cursor = frame_arena().allocate_array<int>(n);
+    std::copy(vertex_tets_rowptr_.begin(), vertex_tets_rowptr_.end() - 1, cursor);
+    for (GEO::index_t t = 0; t < nb_cells; ++t) {
+        for (GEO::index_t lv = 0; lv < 4; ++lv) {
+            GEO::index_t v = delaunay_->cell_vertex(t, lv);
+            if (v < n) {
+                vertex_tets_[cursor[v]++] = int(t);
+            }
+        }
+    }
+}
+
+bool DelaunayContext::neighbors(int v, std::vector<int>& neighbors,
+                                std::vector<double>* positions) const {
+    neighbors.clear();
+    if (positions) {
+        positions->clear();
+    }
+    if (!has_triangulation_ || !keeps(KEEP_NEIGHBORS) || v < 0 || v >= num_points_) {
+        return false;
+    }
+    const GEO::PeriodicDelaunay3d& D = *delaunay_;
+    for (int k = vertex_tets_rowptr_[v]; k < vertex_tets_rowptr_[v + 1]; ++k) {
+        for (GEO::index_t lv = 0; lv < 4; ++lv) {
+            GEO::index_t w = D.cell_vertex(GEO::index_t(vertex_tets_[k]), lv);
+            if (w == GEO::NO_INDEX) {
+                continue;
+            }
+            // Skips v itself and its own periodic copies.
+            const int real = int(D.periodic_vertex_real(w));
+            if (real == v ||
+                std::find(neighbors.begin(), neighbors.end(), real) != neighbors.end()) {
+                continue;
+            }
+            neighbors.push_back(real);
+            if (positions) {
+                const GEO::vec3 position = D.vertex(w);
+                positions->insert(positions->end(), {position.x, position.y, position.z});
+            }
+        }
+    }
+    return true;
+}
+
+bool DelaunayContext::compute_adjacency() {
+    if (!has_triangulation_) {
+        return false;
+    }
+    if (adjacency_valid_) {
+        return true;
+    }
+    if (!keeps(KEEP_NEIGHBORS)) {
+        if (g_log_level >= LOG_ERRORS) {
+            std::cerr << "DelaunayContext: the low-memory mode dropped the stores of "
+                         "the Delaunay graph (KEEP_NEIGHBORS)." << std::endl;
+        }
+        return false;
+    }
+    frame_arena().reset();
+    const GEO::PeriodicDelaunay3d& D = *delaunay_;
+    const int n = num_points_;
+    // last_seen[w] == v once w is a neighbor of v: one pass per star.
+    int* last_seen = frame_arena().allocate_array<int>(size_t(n));
+    std::fill(last_seen, last_seen + n, -1);
+    adjacency_rowptr_.resize(size_t(n) + 1);
+    adjacency_.clear();
+    adjacency_rowptr_[0] = 0;
+    for (int v = 0; v < n; ++v) {
+        last_seen[v] = v;
+        for (int k = vertex_tets_rowptr_[v]; k < vertex_tets_rowptr_[v + 1]; ++k) {
+            for (GEO::index_t lv = 0; lv < 4; ++lv) {
+                GEO::index_t w = D.cell_vertex(GEO::index_t(vertex_tets_[k]), lv);
+                if (w == GEO::NO_INDEX) {
+                    continue;
+                }
+                const int real = int(D.periodic_vertex_real(w));
+                if (last_seen[real] != v) {
+                    last_seen[real] = v;
+                    adjacency_.push_back(real);
+                }
+            }
+        }
+        adjacency_rowptr_[v + 1] = int(adjacency_.size());
+        std::sort(adjacency_.begin() + adjacency_rowptr_[v], adjacency_.end());
+    }
+    adjacency_valid_ = true;
+    ++adjacency_version_;
+    return true;
+}
+
+// The Voronoi vertices of a cell are the circumcenters of the tets of its
+// star, so a cell changes exactly when one of its star tets has a moved
+// vertex: the moved points and their Delaunay neighbors.
+void DelaunayContext::collect_changed_cells() {
+    const GEO::PeriodicDelaunay3d& D = *delaunay_;
+    const GEO::index_t n = GEO::index_t(num_points_);
+    char* changed_mark = frame_arena().allocate_array<char>(n);
+    std::fill(changed_mark, changed_mark + n, 0);
+    changed_cells_.clear();
+    for (int v : moved_) {
+        for (int k = vertex_tets_rowptr_[v]; k < vertex_tets_rowptr_[v + 1]; ++k) {
+            for (GEO::index_t lv = 0; lv < 4; ++lv) {
+                GEO::index_t w = D.cell_vertex(GEO::index_t(vertex_tets_[k]), lv);
+                if (w == GEO::NO_INDEX) {
+                    continue;
+                }
+                w = D.periodic_vertex_real(w);
+                if (!changed_mark[w]) {
+                    changed_mark[w] = 1;
+                    changed_cells_.push_back(int(w));
+                }
+            }
+        }
+    }
+    std::sort(changed_cells_.begin(), changed_cells_.end());
+}
+
+// Loads the Voronoi cell of real vertex i into cell_.
+void DelaunayContext::build_voronoi_cell(GEO::index_t i) {
+    const GEO::PeriodicDelaunay3d& D = *delaunay_;
+    if (is_periodic_) {
+        // The star of a real vertex is complete, copies included.
+        D.copy_Laguerre_cell_from_Delaunay(i, cell_, incident_tets_);
+        return;
+    }
+
+    cell_.init_with_box(0.0, 0.0, 0.0, 1.0, 1.0, 1.0);
+    for (GEO::index_t lv = 1; lv < cell_.nb_v(); ++lv) {
+        cell_.set_v_global_index(lv, GEO::NO_INDEX);
+    }
+    const GEO::index_t n = GEO::index_t(num_points_);
+    const GEO::vec3 Pi = D.vertex(i);
+    const double hi = D.weight(i) - GEO::length2(Pi);
+    for (int k = vertex_tets_rowptr_[i]; k < vertex_tets_rowptr_[i + 1]; ++k) {
+        for (GEO::index_t lv = 0; lv < 4; ++lv) {
+            GEO::index_t j = D.cell_vertex(GEO::index_t(vertex_tets_[k]), lv);
+            // Also discards the vertex at infinity (NO_INDEX).
+            if (j == i || j >= n || cell_.has_v_global_index(j)) {
+                continue;
+            }
+            const GEO::vec3 Pj = D.vertex(j);
+            const double hj = D.weight(j) - GEO::length2(Pj);
+            cell_.clip_by_plane(
+                GEO::vec4(2.0 * (Pi.x - Pj.x), 2.0 * (Pi.y - Pj.y), 2.0 * (Pi.z - Pj.z),
+                          hi - hj),
+                j);
+        }
+    }
+}
+
+// Appends the vertices and faces of cell_ to the packed Voronoi arrays.
+// The vertices of the Voronoi cell are the triangles of cell_, its faces
+// are the planes of cell_ with at least one incident triangle.
+void DelaunayContext::append_voronoi_cell() {
+    if (cell_.empty()) {
+        return;
+    }
+    cell_.compute_geometry();
+
+    const int vertex_offset = int(voronoi_vertices_.size() / 3);
+    voronoi_triangle_vertex_.assign(cell_.max_t(), -1);
+    int nb_vertices = 0;
+    for (VBW::ushort t = cell_.first_triangle(); t != VBW::END_OF_LIST;
+         t = cell_.next_triangle(t)) {
+        voronoi_triangle_vertex_[t] = vertex_offset + nb_vertices++;
+        GEO::vec3 p = cell_.triangle_point(t);
+        voronoi_vertices_.push_back(p.x);
+        voronoi_vertices_.push_back(p.y);
+        voronoi_vertices_.push_back(p.z);
+    }
+
+    // Plane 0 is the vertex at infinity.
+    for (GEO::index_t v = 1; v < cell_.nb_v(); ++v) {
+        if (!cell_.vertex_is_contributing(v)) {
+            continue;
+        }
+        GEO::index_t j = cell_.v_global_index(v);
+        voronoi_face_neighbor_.push_back(
+            j == GEO::NO_INDEX ? -1 : int(delaunay_->periodic_vertex_real(j)));
+        GEO::index_t t0 = cell_.vertex_triangle(v);
+        GEO::index_t t = t0;
+        do {
+            voronoi_face_vertices_.push_back(voronoi_triangle_vertex_[t]);
+            GEO::index_t lv = cell_.triangle_find_vertex(t, v);
+            t = cell_.triangle_adjacent(t, (lv + 1) % 3);
+        } while (t != t0);
+        voronoi_face_ptr_.push_back(int(voronoi_face_vertices_.size()));
+    }
+}
+
+// Fills moved_ with the points that differ from reference_points_, or
+// whose weight differs from reference_weights_.
+// Returns false if one of them requires a full recompute.
+bool DelaunayContext::collect_moved_points(double max_displacement) {
+    moved_.clear();
+    const double max_d2 = max_displacement * max_displacement;
+    for (int v = 0; v < num_points_; ++v) {
+        const double* p = &points_[size_t(v) * 3];
+        const double* q = &reference_points_[size_t(v) * 3];
+        if (p[0] == q[0] && p[1] == q[1] && p[2] == q[2]) {
+            if (weighted_ && weights_[v] != reference_weights_[v]) {
+                moved_.push_back(v);
+            }
+            continue;
+        }
+        for (int c = 0; c < 3; ++c) {
+            if (p[c] < 0.0 || p[c] >= 1.0) {
+                return false;
+            }
+        }
+        double d2 = (p[0] - q[0]) * (p[0] - q[0]) +
+                    (p[1] - q[1]) * (p[1] - q[1]) +
+                    (p[2] - q[2]) * (p[2] - q[2]);
+        if (d2 > max_d2) {
+            return false;
+        }
+        moved_.push_back(v);
+    }
+    return true;
+}
+
+// Checks the certificates of every tet incident to a moved point.
+bool DelaunayContext::certify_moved_points() const {
+    for (int v : moved_) {
+        if (vertex_tets_rowptr_[v] == vertex_tets_rowptr_[v + 1]) {
+            // Not in the triangulation: nothing certifies that it stays out.
+            return false;
+        }
+        for (int i = vertex_tets_rowptr_[v]; i < vertex_tets_rowptr_[v + 1]; ++i) {
+            if (!certify_tet(GEO::index_t(vertex_tets_[i]))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool DelaunayContext::certify_tet(GEO::index_t t) const {
+    const GEO::PeriodicDelaunay3d& D = *delaunay_;
+    GEO::vec3 p[5];
+    for (GEO::index_t lv = 0; lv < 4; ++lv) {
+        p[lv] = D.vertex(D.cell_vertex(t, lv));
+    }
+    if (GEO::PCK::orient_3d(p[0].data(), p[1].data(), p[2].data(), p[3].data()) <= 0) {
+        return false;
+    }
+    double h[5];
+    for (GEO::index_t lv = 0; lv < 4; ++lv) {
+        h[lv] = GEO::length2(p[lv]) - D.weight(D.cell_vertex(t, lv));
+    }
+    for (GEO::index_t lf = 0; lf < 4; ++lf) {
+        GEO::index_t neighbor = D.cell_adjacent(t, lf);
+        if (neighbor != GEO::NO_INDEX) {
+            GEO::index_t opposite = D.cell_vertex(neighbor, D.adjacent_index(neighbor, t));
+            p[4] = D.vertex(opposite);
+            h[4] = GEO::length2(p[4]) - D.weight(opposite);
+        } else if (!is_periodic_) {
+            // Convex hull facet: nothing on the other side to be in conflict
+            // with, but the hull must stay convex.
+            if (!certify_hull_facet(t, lf)) {
+                return false;
+            }
+            continue;
+        } else if (!find_translated_opposite(t, lf, p[4], h[4])) {
+            return false;
+        }
+        if (GEO::PCK::orient_3dlifted_SOS(
+                p[0].data(), p[1].data(), p[2].data(), p[3].data(), p[4].data(),
+                h[0], h[1], h[2], h[3], h[4]) > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Non-periodic mode: facet lf of t is on the convex hull. Checks that the
+// hull stays convex at the three edges of the facet: around each edge, walks
+// the tets to the other hull facet, whose vertex opposite to the edge must
+// be strictly on the inner side of the plane of this one, like the vertex of
+// t opposite to it. A coplanar pair of hull facets is not certified.
+bool DelaunayContext::certify_hull_facet(GEO::index_t t, GEO::index_t lf) const {
+    const GEO::PeriodicDelaunay3d& D = *delaunay_;
+    const GEO::index_t interior = D.cell_vertex(t, lf);
+    GEO::index_t facet[3];
+    for (GEO::index_t i = 0; i < 3; ++i) {
+        facet[i] = D.cell_vertex(t, (lf + 1 + i) % 4);
+    }
+    const GEO::vec3 a = D.vertex(facet[0]);
+    const GEO::vec3 b = D.vertex(facet[1]);
+    const GEO::vec3 c = D.vertex(facet[2]);
+    const GEO::Sign inner = GEO::PCK::orient_3d(a.data(), b.data(), c.data(),
+                                                D.vertex(interior).data());
+    for (GEO::index_t e = 0; e < 3; ++e) {
+        // Edge (u, w) of the facet, then the tets around it, each entered
+        // through the facet (u, w, x) and left through (u, w, y).
+        const GEO::index_t u = facet[e];
+        const GEO::index_t w = facet[(e + 1) % 3];
+        GEO::index_t x = facet[(e + 2) % 3];
+        GEO::index_t cur = t;
+        GEO::index_t y = interior;
+        for (GEO::index_t steps = 0;; ++steps) {
+            GEO::index_t next = D.cell_adjacent(cur, D.index(cur, x));
+            if (next == GEO::NO_INDEX) {
+                break;
+            }
+            if (steps == D.nb_cells()) {
+                return false;
+            }
+            x = y;
+            cur = next;
+            for (GEO::index_t lv = 0; lv < 4; ++lv) {
+                GEO::index_t v = D.cell_vertex(cur, lv);
+                if (v != u && v != w && v != x) {
+                    y = v;
+                }
+            }
+        }
+        // (u, w, y) is the other hull facet at the edge.
+        if (GEO::PCK::orient_3d(a.data(), b.data(), c.data(), D.vertex(y).data()) != inner) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Periodic mode: facet lf of t has no neighbor because the tet on the
+// other side only has periodic copies and was discarded. Finds that tet's
+// translate around the real instance of one of the facet vertices, and
+// returns its opposite vertex (translated back) with its lifted height.
+bool DelaunayContext::find_translated_opposite(GEO::index_t t, GEO::index_t lf,
+                                               GEO::vec3& position, double& height) const {
+    const GEO::PeriodicDelaunay3d& D = *delaunay_;
+    GEO::index_t facet[3];
+    for (GEO::index_t i = 0; i < 3; ++i) {
+        facet[i] = D.cell_vertex(t, (lf + 1 + i) % 4);
+    }
+
+    // Translate the facet so that facet[0] becomes a real vertex.
+    const int* shift = GEO::Periodic::translation[D.periodic_vertex_instance(facet[0])];
+    GEO::index_t translated[3];
+    for (GEO::index_t i = 0; i < 3; ++i) {
+        const int* T = GEO::Periodic::translation[D.periodic_vertex_instance(facet[i])];
+        int Tx = T[0] - shift[0], Ty = T[1] - shift[1], Tz = T[2] - shift[2];
+        if (std::abs(Tx) > 1 || std::abs(Ty) > 1 || std::abs(Tz) > 1) {
+            return false;
+        }
+        translated[i] = D.make_periodic_vertex(
+            D.periodic_vertex_real(facet[i]), GEO::Periodic::T_to_instance(Tx, Ty, Tz));
+    }
+
+    // Vertex of t opposite to the facet, as seen from the translated frame.
+    GEO::index_t own = D.cell_vertex(t, lf);
+    const int* T_own = GEO::Periodic::translation[D.periodic_vertex_instance(own)];
+
+    GEO::index_t u = translated[0];
+    for (int i = vertex_tets_rowptr_[u]; i < vertex_tets_rowptr_[u + 1]; ++i) {
+        GEO::index_t s = GEO::index_t(vertex_tets_[i]);
+        int found = 0;
+        GEO::index_t other = GEO::NO_INDEX;
+        for (GEO::index_t lv = 0; lv < 4; ++lv) {
+            GEO::index_t w = D.cell_vertex(s, lv);
+            if (w == translated[0] || w == translated[1] || w == translated[2]) {
+                ++found;
+            } else {
+                other = w;
+            }
+        }
+        if (found != 3) {
+            continue;
+        }
+        const int* T_other = GEO::Periodic::translation[D.periodic_vertex_instance(other)];
+        bool is_t_translate =
+            D.periodic_vertex_real(other) == D.periodic_vertex_real(own) &&
+            T_other[0] + shift[0] == T_own[0] &&
+            T_other[1] + shift[1] == T_own[1] &&
+            T_other[2] + shift[2] == T_own[2];
+        if (is_t_translate) {
+            continue;
+        }
+        position = D.vertex(other);
+        position.x += double(shift[0]);
+        position.y += double(shift[1]);
+        position.z += double(shift[2]);
+        height = GEO::length2(position) - D.weight(other);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,512 @@
+// delaunay_core.h
+//
+// Periodic / non-periodic Delaunay triangulation of points in the unit cube,
+// tet deduplication and Voronoi cell extraction on top of the Geogram PSM.
+// Like every header of this directory but the PSM's, it is plain C++ with no
+// dependency on Emscripten: periodic_delaunay.cpp and acuteness_wasm.cpp bind
+// the core for JavaScript, the native library and CLI use it directly.
+
+#pragma once
+
+#include "Delaunay_psm.h"
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// Canonical form of a tetrahedron: its 4 vertex indices in ascending order.
+struct TetKey {
+    int v[4];
+
+    bool operator==(const TetKey& other) const {
+        return v[0] == other.v[0] && v[1] == other.v[1] &&
+               v[2] == other.v[2] && v[3] == other.v[3];
+    }
+};
+
+// Sorts the 4 indices of a tet with a fixed 5-comparator network.
+inline TetKey make_tet_key(const int tet[4]) {
+    TetKey key = {{tet[0], tet[1], tet[2], tet[3]}};
+    if (key.v[0] > key.v[1]) std::swap(key.v[0], key.v[1]);
+    if (key.v[2] > key.v[3]) std::swap(key.v[2], key.v[3]);
+    if (key.v[0] > key.v[2]) std::swap(key.v[0], key.v[2]);
+    if (key.v[1] > key.v[3]) std::swap(key.v[1], key.v[3]);
+    if (key.v[1] > key.v[2]) std::swap(key.v[1], key.v[2]);
+    return key;
+}
+
+// Open-addressing hash set of TetKeys used to drop the duplicate tets produced
+// by the periodic copies. The slot array is kept between calls and only grows,
+// so steady-state frames perform no allocation.
+class TetDeduplicator {
+public:
+    // Prepares the table for at most max_keys insertions (load factor <= 0.5).
+    void reset(size_t max_keys) {
+        size_t capacity = 16;
+        while (capacity < max_keys * 2) capacity <<= 1;
+        if (slots_.size() < capacity) {
+            slots_.resize(capacity);
+        }
+        mask_ = capacity - 1;
+        size_ = 0;
+        const TetKey empty = {{EMPTY_SLOT, EMPTY_SLOT, EMPTY_SLOT, EMPTY_SLOT}};
+        std::fill(slots_.begin(), slots_.begin() + capacity, empty);
+    }
+
+    // Returns true if key was not in the set yet.
+    bool insert(const TetKey& key) {
+        size_t slot = hash(key) & mask_;
+        for (;;) {
+            TetKey& entry = slots_[slot];
+            if (entry.v[0] == EMPTY_SLOT) {
+                entry = key;
+                ++size_;
+                return true;
+            }
+            if (entry == key) {
+                return false;
+            }
+            slot = (slot + 1) & mask_;
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t memory_bytes() const {
+        return slots_.capacity() * sizeof(TetKey);
+    }
+
+private:
+    static constexpr int EMPTY_SLOT = -1;
+
+    static size_t hash(const TetKey& key) {
+        uint64_t h = uint32_t(key.v[0]);
+        h = h * 0x9E3779B97F4A7C15ull + uint32_t(key.v[1]);
+        h = h * 0x9E3779B97F4A7C15ull + uint32_t(key.v[2]);
+        h = h * 0x9E3779B97F4A7C15ull + uint32_t(key.v[3]);
+        return size_t(h ^ (h >> 29));
+    }
+
+    std::vector<TetKey> slots_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+};
+
+// Counters and timers of the last triangulation, filled on every call so
+// that callers can query them instead of parsing console output. Times are
+// wall-clock seconds. The PSM stages come from
+// PeriodicDelaunay3d::stats(), which is filled on every compute().
+struct DelaunayStats {
+    bool incremental = false;       // compute_incremental() kept the tets
+    bool weighted = false;          // power diagram of weighted points
+    double marshal = 0.0;           // wrapping the input coordinates into [0,1) (periodic)
+    double reorder = 0.0;           // set_vertices(): BRIO reordering
+    double insertion = 0.0;         // insertion of the points (DelMain)
+    double periodic_phase_1 = 0.0;  // periodic copies of the boundary points
+    double periodic_phase_2 = 0.0;  // real neighbors of the periodic copies
+    double compress = 0.0;          // rest of compute(): compression, v_to_cell
+    double dedup = 0.0;             // periodic index mapping and dedup (periodic)
+    double certify = 0.0;           // compute_incremental(): certificates
+    double output = 0.0;            // DelaunayContext: incidence, changed cells
+    double total = 0.0;
+    int num_raw_tets = 0;           // tets of the PSM, before dedup
+    int num_unique_tets = 0;        // after dedup
+    int nb_reallocations = 0;       // PSM tet store growths, since its creation
+    double heap_bytes = 0.0;        // current memory footprint
+    double peak_memory_bytes = 0.0; // peak footprint of the process
+    double retained_bytes = 0.0;    // held by the DelaunayContext after the call, see memory_bytes()
+};
+
+// Verbosity of the core's console output. The default, LOG_ERRORS, prints
+// nothing unless a call fails, so the release build does no console I/O on
+// the hot path. Define VORONOI_LOG_LEVEL to change the default at build time.
+enum LogLevel {
+    LOG_QUIET = 0,
+    LOG_ERRORS = 1,
+    LOG_INFO = 2,   // also unmutes the Geogram logger
+    LOG_DEBUG = 3   // one summary line per triangulation
+};
+
+void set_log_level(int level);
+int log_level();
+
+// Fills the memory fields of stats.
+void sample_memory(DelaunayStats& stats);
+
+// Initialize Geogram once
+void initialize_geogram();
+
+// Creates a PeriodicDelaunay3d configured the way every entry point uses it.
+std::unique_ptr<GEO::PeriodicDelaunay3d> create_delaunay(bool is_periodic);
+
+// Triangulates num_points points stored as xyz triplets in coords with the
+// given Delaunay object and appends the unique tetrahedra (4 vertex indices
+// each) to tets_out. In periodic mode the coordinates are first wrapped into
+// [0,1) in place, and the tets of the periodic copies are mapped back and
+// deduplicated. Non-periodic tets are unique: they are copied as is, and the
+// coordinates are left untouched. coords must stay alive as long as delaunay
+// is queried. Returns false if Geogram failed. Fills stats (all stages but
+// certify and output) if not null.
+// If translations is not null, it receives 12 values per tet, as tets_out:
+// the periodic lattice translation (x, y, z in periods, -1 to 1) of each
+// vertex relative to the first one, i.e. vertex k of the tet sits at
+// points[tet[k]] + translation[k] * period in the copy where the tet is
+// connected. All zero in non-periodic mode.
+// Instantiated for std::vector<int> and FrameVector<int>.
+template <class TetVector>
+bool compute_unique_tets(GEO::PeriodicDelaunay3d& delaunay,
+                         double* coords, int num_points, bool is_periodic,
+                         TetDeduplicator& dedup, TetVector& tets_out,
+                         DelaunayStats* stats = nullptr,
+                         std::vector<int8_t>* translations = nullptr);
+
+// Non-periodic fast path for one-off triangulations: a factory-created
+// GEO::Delaunay ("PDEL" when threads are available, else "BDEL") with none of
+// the periodic machinery. The coordinates are read as is and the tets are
+// copied straight from the triangulation into tets_out, which has no
+// wrapping, remapping or dedup stage. Its BRIO order is internal; callers
+// that need an insertion order use compute_unique_tets(). Returns false if
+// Geogram failed. Fills the marshal, insertion, output and total stages of
+// stats if not null.
+// Instantiated for std::vector<int> and FrameVector<int>.
+template <class TetVector>
+bool compute_bounded_tets(const double* coords, int num_points, TetVector& tets_out,
+                          DelaunayStats* stats = nullptr);
+
+// Queries of a DelaunayContext that the low-memory mode keeps available,
+// see DelaunayContext::set_low_memory().
+enum ContextQueries : unsigned {
+    KEEP_TETS_ONLY = 0,       // tets(), tet_translations(), changed_cells()
+    KEEP_NEIGHBORS = 1,       // neighbors(), compute_adjacency()
+    KEEP_VORONOI_CELLS = 2,   // compute_voronoi_cells()
+    KEEP_INCREMENTAL = 4,     // the kinetic path of compute_incremental()
+    KEEP_ALL_QUERIES = 7
+};
+
+// Triangulation state kept alive between frames. Reusing one
+// PeriodicDelaunay3d keeps its tet stores, BRIO order and per-thread scratch
+// allocated, so steady-state frames of the growth and physics loops no longer
+// go through the allocator.
+class DelaunayContext {
+public:
+    explicit DelaunayContext(bool is_periodic);
+
+    bool is_periodic() const {
+        return is_periodic_;
+    }
+
+    int num_points() const {
+        return num_points_;
+    }
+
+    // The context's coordinate buffer, sized for num_points xyz triplets,
+    // to be filled in place before compute().
+    double* points_buffer(int num_points);
+
+    // Copies num_points xyz triplets into the context.
+    void set_points(const double* coords, int num_points);
+
+    // The current points, 3 coordinates per point. In periodic mode compute()
+    // wraps them into [0,1) in place.
+    const std::vector<double>& points() const {
+        return points_;
+    }
+
+    // Weighted mode: with one weight per point, the context computes the
+    // regular triangulation and power (Laguerre) cells of the weighted
+    // points, for the power distance |x - p_i|^2 - w_i. Raising w_i grows
+    // cell i at the expense of its neighbors without moving any point, and
+    // compute_incremental() treats a weight change like a move. A point
+    // whose weight is too small for its neighbors' has an empty cell, and
+    // compute() then fails: keep |w_i - w_j| below the squared distance
+    // between neighbors.
+    //
+    // The context's weight buffer, sized for num_points weights, to be
+    // filled in place before compute(). Enables the weighted mode.
+    double* weights_buffer(int num_points);
+
+    // Copies num_points weights into the context, enabling the weighted mode.
+    void set_weights(const double* weights, int num_points);
+
+    // Back to the unweighted (Delaunay / Voronoi) mode.
+    void clear_weights();
+
+    bool is_weighted() const {
+        return weighted_;
+    }
+
+    // Triangulates the current points. The unique tets (4 indices per tet)
+    // are then in tets() until the next call to compute() or destroy().
+    // Returns false on failure.
+    bool compute();
+
+    // Kinetic update for small displacements. The points that moved since the
+    // last accepted triangulation are detected, and every tet around them is
+    // re-certified (positive orientation, no neighbor's opposite vertex in
+    // conflict with it and, in non-periodic mode, a convex hull still convex
+    // at its facets) through the PSM's cell adjacency. If all certificates
+    // hold, the combinatorics are unchanged: the PSM already reads the new
+    // coordinates in place and the previous tets are kept without
+    // recomputing. Falls back to compute() when a certificate fails, the
+    // point count changed, or a point moved further than max_displacement or
+    // left [0,1). The update only certifies, it does not flip: a single
+    // needed flip rebuilds everything, so the gain depends on how often a
+    // frame leaves every tet around the moved points valid. With 30 of 1500
+    // points moved by 1e-4 per frame, about 4 frames in 10 keep their tets
+    // (and are accepted, in both modes); at 1e-2 almost none do.
+    bool compute_incremental(double max_displacement);
+
+    // Unique tets of the last successful update, 4 indices per tet.
+    const std::vector<int>& tets() const {
+        return tets_;
+    }
+
+    // Low-memory mode, for point counts that the 2-4 GB WASM heap caps. At
+    // the end of every compute(), the context frees what only the
+    // construction needs (the dedup table, the PSM's free lists, cell
+    // status and periodic vertex copies, see
+    // PeriodicDelaunay3d::release_construction_buffers()), shrinks the tet
+    // stores to the final tets, and frees whatever stores the queries in
+    // kept_queries (ContextQueries flags) do not read: the tet adjacency,
+    // v_to_cell, the vertex -> tets incidence, the reference points of the
+    // kinetic update, or the whole PSM object with KEEP_TETS_ONLY. A query
+    // left out then returns false, and compute_incremental() always
+    // computes in full. The next compute() reallocates the construction
+    // buffers, so steady-state frames go through the allocator again: the
+    // mode trades time for footprint. Takes effect at the next compute().
+    // Off by default.
+    void set_low_memory(bool low_memory, unsigned kept_queries = KEEP_ALL_QUERIES) {
+        low_memory_ = low_memory;
+        kept_queries_ = kept_queries & KEEP_ALL_QUERIES;
+    }
+
+    bool is_low_memory() const {
+        return low_memory_;
+    }
+
+    // Bytes currently held by the context: its own buffers (points, tets,
+    // incidences, Voronoi cells, dedup table) and the PSM's stores, by
+    // capacity. Divided by num_points(), the per-point cost that bounds the
+    // largest triangulation fitting in the heap.
+    size_t memory_bytes() const;
+
+    // Also keep the periodic translation of every tet vertex, 3 per vertex
+    // (12 per tet) in tet_translations(), see compute_unique_tets(). Takes
+    // effect at the next compute(), or compute_incremental(), which then
+    // computes in full. Incremental updates keep the combinatorics, and so
+    // the translations. Off by default.
+    void set_keeps_tet_translations(bool keep) {
+        keep_translations_ = keep;
+    }
+
+    const std::vector<int8_t>& tet_translations() const {
+        return translations_;
+    }
+
+    // Inserts the points with one thread, the calling one, instead of the
+    // whole pool: the PSM then stays out of the process-wide thread
+    // machinery, and several contexts can compute concurrently, one per
+    // thread (see DelaunayBatch). Takes effect at the next compute(). Off by
+    // default.
+    void set_single_threaded(bool single_threaded) {
+        single_threaded_ = single_threaded;
+    }
+
+    // true after a successful update, until sort_points_spatially(),
+    // destroy() or a failed update.
+    bool has_triangulation() const {
+        return has_triangulation_;
+    }
+
+    // Delaunay neighbors of point v in the current triangulation, each once,
+    // in neighbors (cleared first). If positions is not null, it receives the
+    // xyz coordinates of every neighbor as seen from v: in periodic mode the
+    // translate adjacent to v, so that the difference with points()[v] is the
+    // actual displacement across the faces of the cube. Reads the current
+    // coordinates. Returns false without a triangulation.
+    bool neighbors(int v, std::vector<int>& neighbors,
+                   std::vector<double>* positions = nullptr) const;
+
+    // Builds the Delaunay graph of the current triangulation in CSR form:
+    // the neighbors of point v are adjacency()[adjacency_rowptr()[v]] to
+    // adjacency()[adjacency_rowptr()[v + 1] - 1], sorted, each once, v
+    // itself excluded. Periodic copies are folded back to their real point.
+    // The graph only depends on the combinatorics, so it is kept as is
+    // through incremental updates and rebuilt after a full compute().
+    // Returns false without a triangulation.
+    bool compute_adjacency();
+
+    const std::vector<int>& adjacency_rowptr() const {
+        return adjacency_rowptr_;
+    }
+
+    const std::vector<int>& adjacency() const {
+        return adjacency_;
+    }
+
+    // Incremented every time compute_adjacency() rebuilds the graph, so
+    // that callers can keep their copy while it is unchanged.
+    int adjacency_version() const {
+        return adjacency_version_;
+    }
+
+    // true if the last update kept the previous combinatorics.
+    bool last_update_was_incremental() const {
+        return last_update_incremental_;
+    }
+
+    // The cells (point indices) whose Voronoi cell may differ since the
+    // previous update: every cell after a full compute(), the moved points
+    // and their Delaunay neighbors after an incremental one. Feeds
+    // updateCellAcuteness().
+    const std::vector<int>& changed_cells() const {
+        return changed_cells_;
+    }
+
+    // Number of points found to have moved by the last compute_incremental().
+    int last_moved_count() const {
+        return int(moved_.size());
+    }
+
+    // The points found to have moved by the last compute_incremental();
+    // empty after a full compute().
+    const std::vector<int>& moved_points() const {
+        return moved_;
+    }
+
+    // Incremented by every compute() (including the fallback of
+    // compute_incremental()), successful incremental update,
+    // sort_points_spatially() and destroy(), so that caches of per-tet data
+    // can tell whether they followed every update.
+    int update_version() const {
+        return update_version_;
+    }
+
+    // Permutes the current points (and weights) into the PSM's BRIO
+    // insertion order, in which each BRIO level is Hilbert-sorted, so that
+    // neighboring points get nearby indices. spatial_order() then holds the permutation: point k is
+    // the one previously at index spatial_order()[k], and callers must
+    // reorder their own per-point data the same way. The BRIO levels are
+    // kept, so later compute() calls insert the points as they are instead
+    // of sorting them again, until the point count changes or this is called
+    // again. Drops the current triangulation. Returns false with fewer than
+    // 4 points.
+    bool sort_points_spatially();
+
+    // Permutation applied by the last sort_points_spatially().
+    const std::vector<int>& spatial_order() const {
+        return spatial_order_;
+    }
+
+    // true while compute() reuses the BRIO levels of sort_points_spatially().
+    bool points_spatially_sorted() const {
+        return !spatial_levels_.empty() &&
+               spatial_levels_.back() == GEO::index_t(num_points_);
+    }
+
+    // Counters and stage timings of the last compute() or
+    // compute_incremental().
+    const DelaunayStats& stats() const {
+        return stats_;
+    }
+
+    // Computes the true (circumcentric) Voronoi cell of every point of the
+    // current triangulation, packed in voronoi_cells() in the spirit of
+    // GEO::PackedArrays:
+    //   [0] num_cells (n)  [1] num_faces (F)  [2] num_vertices (V)
+    //   cell_vertex_ptr[n + 1]  range of each cell in the vertex array
+    //   cell_face_ptr[n + 1]    range of each cell in the face arrays
+    //   face_ptr[F + 1]         range of each face in face_vertices
+    //   face_neighbor[F]        point on the other side, -1 for the box
+    //   face_vertices[...]      vertex indices, consistently oriented
+    // The xyz coordinates of the V vertices are in voronoi_cell_vertices().
+    // Periodic cells are copied from the Delaunay stars with
+    // copy_Laguerre_cell_from_Delaunay() and are not clipped, so a cell may
+    // cross the faces of the unit cube. Non-periodic cells are clipped by the
+    // unit cube, since the PSM does not keep the tets incident to the hull.
+    // Both arrays stay valid until the next call to compute_voronoi_cells()
+    // or destroy(). Returns false without a triangulation.
+    bool compute_voronoi_cells();
+
+    // Streaming variant: the cells of points first to first + count - 1
+    // only, in the same layout with num_cells = count (cell k of the chunk is
+    // point first + k). The buffers keep the capacity of the largest chunk,
+    // so extracting the cells chunk by chunk bounds the memory by the chunk
+    // size instead of the point count. Returns false without a triangulation
+    // or if the range is out of bounds.
+    bool compute_voronoi_cells(int first, int count);
+
+    // Copies the tets first to first + count - 1 of tets() (4 indices each)
+    // into out, clipped to the tets available. Returns the number copied.
+    int copy_tets(int first, int count, int* out) const;
+
+    const std::vector<int>& voronoi_cells() const {
+        return voronoi_cells_;
+    }
+
+    const std::vector<double>& voronoi_cell_vertices() const {
+        return voronoi_vertices_;
+    }
+
+    // Releases the triangulation and every buffer. compute() may still be
+    // called to start over.
+    void destroy();
+
+private:
+    bool keeps(unsigned query) const;
+    void release_stores();
+    void build_vertex_to_tets();
+    void collect_changed_cells();
+    void build_voronoi_cell(GEO::index_t i);
+    void append_voronoi_cell();
+    bool collect_moved_points(double max_displacement);
+    bool certify_moved_points() const;
+    bool certify_tet(GEO::index_t t) const;
+    bool certify_hull_facet(GEO::index_t t, GEO::index_t lf) const;
+    bool find_translated_opposite(GEO::index_t t, GEO::index_t lf,
+                                  GEO::vec3& position, double& height) const;
+
+    bool is_periodic_;
+    bool weighted_;
+    int num_points_;
+    bool has_triangulation_;
+    bool last_update_incremental_;
+    std::unique_ptr<GEO::PeriodicDelaunay3d> delaunay_;
+    std::vector<double> points_;
+    std::vector<double> reference_points_;
+    std::vector<double> weights_;
+    std::vector<double> reference_weights_;
+    std::vector<int> tets_;
+    bool keep_translations_;
+    bool single_threaded_;
+    bool low_memory_;
+    unsigned kept_queries_;
+    bool stores_released_;
+    std::vector<int8_t> translations_;
+    std::vector<int> vertex_tets_rowptr_;
+    std::vector<int> vertex_tets_;
+    std::vector<int> moved_;
+    std::vector<int> changed_cells_;
+    std::vector<int> adjacency_rowptr_;
+    std::vector<int> adjacency_;
+    bool adjacency_valid_;
+    int adjacency_version_;
+    int update_version_;
+    std::vector<int> spatial_order_;
+    GEO::vector<GEO::index_t> spatial_levels_;
+    TetDeduplicator dedup_;
+    DelaunayStats stats_;
+
+    GEO::ConvexCell cell_{VBW::WithVGlobal};
+    GEO::PeriodicDelaunay3d::IncidentTetrahedra incident_tets_;
+    std::vector<int> voronoi_cells_;
+    std::vector<double> voronoi_vertices_;
+    std::vector<int> voronoi_vertex_ptr_;
+    std::vector<int> voronoi_cell_face_ptr_;
+    std::vector<int> voronoi_face_ptr_;
+    std::vector<int> voronoi_face_neighbor_;
+    std::vector<int> voronoi_face_vertices_;
+    std::vector<int> voronoi_triangle_vertex_;
+};
@@ -0,0 +1,172 @@
+// frame_arena.h
+//
+// Bump allocator for per-frame scratch in the WASM entry points. Every
+// compute/calculate call starts with frame_arena().reset(), then draws its
+// temporaries from the arena instead of going through malloc. Memory is only
+// returned to the system by release(); after a frame that overflowed into
+// extra blocks, reset() merges them into a single block sized for the
+// high-water mark, so steady-state frames allocate nothing.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class FrameArena {
+public:
+    explicit FrameArena(size_t initial_bytes = size_t(1) << 20) :
+        initial_bytes_(initial_bytes), current_(0), offset_(0), used_(0), high_water_mark_(0) {}
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Starts a new frame. Everything allocated so far becomes invalid.
+    void reset() {
+        if (blocks_.size() > 1) {
+            size_t total = 0;
+            for (const Block& block : blocks_) {
+                total += block.size;
+            }
+            blocks_.clear();
+            add_block(std::max(total, high_water_mark_));
+        }
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    // Makes sure the next frames can use at least bytes without growing.
+    void reserve(size_t bytes) {
+        if (capacity() < bytes) {
+            blocks_.clear();
+            add_block(bytes);
+            current_ = 0;
+            offset_ = 0;
+            used_ = 0;
+        }
+    }
+
+    // Frees every block (for instance after a one-off very large frame).
+    void release() {
+        std::vector<Block>().swap(blocks_);
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        for (;;) {
+            if (current_ < blocks_.size()) {
+                Block& block = blocks_[current_];
+                uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+                uintptr_t aligned = (base + offset_ + alignment - 1) & ~uintptr_t(alignment - 1);
+                size_t end = size_t(aligned - base) + bytes;
+                if (end <= block.size) {
+                    used_ += end - offset_;
+                    offset_ = end;
+                    high_water_mark_ = std::max(high_water_mark_, used_);
+                    return reinterpret_cast<void*>(aligned);
+                }
+                // Move to the next block, the tail of this one is wasted.
+                used_ += block.size - offset_;
+                ++current_;
+                offset_ = 0;
+                continue;
+            }
+            size_t last = blocks_.empty() ? initial_bytes_ : blocks_.back().size * 2;
+            add_block(std::max(last, bytes + alignment));
+        }
+    }
+
+    template <class T>
+    T* allocate_array(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Bytes handed out (including alignment padding) since the last reset().
+    size_t used() const {
+        return used_;
+    }
+
+    // Largest used() seen since construction or reset_high_water_mark().
+    size_t high_water_mark() const {
+        return high_water_mark_;
+    }
+
+    void reset_high_water_mark() {
+        high_water_mark_ = used_;
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& block : blocks_) {
+            total += block.size;
+        }
+        return total;
+    }
+
+    size_t nb_blocks() const {
+        return blocks_.size();
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    void add_block(size_t bytes) {
+        Block block;
+        block.data.reset(new unsigned char[bytes]);
+        block.size = bytes;
+        blocks_.push_back(std::move(block));
+    }
+
+    size_t initial_bytes_;
+    std::vector<Block> blocks_;
+    size_t current_;
+    size_t offset_;
+    size_t used_;
+    size_t high_water_mark_;
+};
+
+// The arena shared by every WASM entry point of the module. One per thread,
+// so that the jobs DelaunayBatch runs concurrently each draw from their own.
+inline FrameArena& frame_arena() {
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+// STL allocator drawing from frame_arena(). deallocate() is a no-op, so
+// containers using it should reserve() their final size up front.
+template <class T>
+struct FrameAllocator {
+    typedef T value_type;
+
+    FrameAllocator() = default;
+
+    template <class U>
+    FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        return frame_arena().allocate_array<T>(count);
+    }
+
+    void deallocate(T*, size_t) {}
+
+    template <class U>
+    bool operator==(const FrameAllocator<U>&) const {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=(const FrameAllocator<U>&) const {
+        return false;
+    }
+};
+
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
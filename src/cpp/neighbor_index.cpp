@@ -0,0 +1,247 @@
+// neighbor_index.cpp
+//
+// Implementation of neighbor_index.h.
+
+#include "neighbor_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// The kd-tree keeps its k best candidates on the stack: above this many, a
+// query scans the points instead.
+const int MAX_TREE_NEIGHBORS = 4096;
+
+// First k of the radius queries, doubled until the ball is covered.
+const int RADIUS_START_K = 16;
+
+double wrap(double x) {
+    x -= std::floor(x);
+    return x < 1.0 ? x : 0.0;
+}
+
+// Squared distance from p to q, across the faces of the cube.
+double periodic_sq_dist(const double* p, const double* q) {
+    double result = 0.0;
+    for (int c = 0; c < 3; ++c) {
+        double d = std::abs(p[c] - q[c]);
+        d = std::min(d, 1.0 - d);
+        result += d * d;
+    }
+    return result;
+}
+
+double sq_dist(const double* p, const double* q) {
+    const double dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+} // namespace
+
+NeighborIndex::NeighborIndex(bool is_periodic) : is_periodic_(is_periodic) {
+}
+
+void NeighborIndex::set_points(const double* coords, int num_points) {
+    const size_t size = size_t(std::max(num_points, 0)) * 3;
+    if (points_.size() != size) {
+        points_.resize(size);
+        stale_ = true;
+    }
+    for (size_t k = 0; k < size; ++k) {
+        const double x = is_periodic_ ? wrap(coords[k]) : coords[k];
+        if (points_[k] != x) {
+            points_[k] = x;
+            stale_ = true;
+        }
+    }
+}
+
+void NeighborIndex::rebuild() {
+    initialize_geogram();
+    if (tree_.is_null()) {
+        tree_ = GEO::NearestNeighborSearch::create(3, "BNN");
+    }
+    tree_->set_points(GEO::index_t(num_points()), points_.data());
+    stale_ = false;
+    ++num_rebuilds_;
+}
+
+// Leaves the min(k, n - excluded) nearest points of p in candidates_, as
+// (sq_dist, index) sorted by distance.
+void NeighborIndex::query(const double* p, int k, int exclude) {
+    candidates_.clear();
+    const int n = num_points();
+    const bool excluded = exclude >= 0 && exclude < n;
+    const int wanted = std::min(k, n - int(excluded));
+    if (wanted <= 0) {
+        return;
+    }
+    const int fetch = wanted + int(excluded);
+    double wrapped[3] = {p[0], p[1], p[2]};
+    if (is_periodic_) {
+        for (int c = 0; c < 3; ++c) {
+            wrapped[c] = wrap(p[c]);
+        }
+        p = wrapped;
+    }
+
+    if (fetch > MAX_TREE_NEIGHBORS) {
+        for (int j = 0; j < n; ++j) {
+            if (j != exclude) {
+                const double* q = &points_[size_t(j) * 3];
+                candidates_.emplace_back(is_periodic_ ? periodic_sq_dist(p, q) : sq_dist(p, q), j);
+            }
+        }
+        std::partial_sort(candidates_.begin(), candidates_.begin() + wanted, candidates_.end());
+        candidates_.resize(size_t(wanted));
+        return;
+    }
+
+    if (stale_) {
+        rebuild();
+    }
+    hits_.resize(size_t(fetch));
+    hit_dists_.resize(size_t(fetch));
+    auto visit = [&](const double* q) {
+        tree_->get_nearest_neighbors(GEO::index_t(fetch), q, hits_.data(), hit_dists_.data());
+        for (int j = 0; j < fetch; ++j) {
+            if (int(hits_[j]) != exclude) {
+                candidates_.emplace_back(hit_dists_[j], int(hits_[j]));
+            }
+        }
+    };
+
+    if (!is_periodic_) {
+        visit(p);
+        std::sort(candidates_.begin(), candidates_.end());
+        candidates_.resize(std::min(candidates_.size(), size_t(wanted)));
+        return;
+    }
+
+    // Periodic: the cube, then every image of it that the ball through the
+    // current k-th neighbor reaches. The image shifted by s holds the points
+    // x + s, i.e. the points nearest to p - s.
+    visit(p);
+    std::sort(candidates_.begin(), candidates_.end());
+    for (int s = 0; s < 27; ++s) {
+        const int shift[3] = {s % 3 - 1, (s / 3) % 3 - 1, s / 9 - 1};
+        if (shift[0] == 0 && shift[1] == 0 && shift[2] == 0) {
+            continue;
+        }
+        double gap = 0.0;
+        double q[3];
+        for (int c = 0; c < 3; ++c) {
+            const double face = shift[c] > 0 ? 1.0 - p[c] : shift[c] < 0 ? p[c] : 0.0;
+            gap += face * face;
+            q[c] = p[c] - shift[c];
+        }
+        if (int(candidates_.size()) >= wanted && gap > candidates_[size_t(wanted) - 1].first) {
+            continue;
+        }
+        visit(q);
+        // One entry per point, at its nearest image
+        std::sort(candidates_.begin(), candidates_.end(),
+                  [](const std::pair<double, int>& a, const std::pair<double, int>& b) {
+                      return a.second != b.second ? a.second < b.second : a.first < b.first;
+                  });
+        candidates_.erase(std::unique(candidates_.begin(), candidates_.end(),
+                                      [](const std::pair<double, int>& a, const std::pair<double, int>& b) {
+                                          return a.second == b.second;
+                                      }),
+                          candidates_.end());
+        std::sort(candidates_.begin(), candidates_.end());
+        candidates_.resize(std::min(candidates_.size(), size_t(wanted)));
+    }
+    candidates_.resize(std::min(candidates_.size(), size_t(wanted)));
+}
+
+int NeighborIndex::nearest(const double* p, int k, int* neighbors, double* sq_dists) {
+    query(p, k, -1);
+    for (size_t j = 0; j < candidates_.size(); ++j) {
+        neighbors[j] = candidates_[j].second;
+        if (sq_dists != nullptr) {
+            sq_dists[j] = candidates_[j].first;
+        }
+    }
+    return int(candidates_.size());
+}
+
+int NeighborIndex::nearest_to_point(int i, int k, int* neighbors, double* sq_dists) {
+    if (i < 0 || i >= num_points()) {
+        return -1;
+    }
+    query(&points_[size_t(i) * 3], k, i);
+    for (size_t j = 0; j < candidates_.size(); ++j) {
+        neighbors[j] = candidates_[j].second;
+        if (sq_dists != nullptr) {
+            sq_dists[j] = candidates_[j].first;
+        }
+    }
+    return int(candidates_.size());
+}
+
+void NeighborIndex::within_radius(const double* p, double radius, std::vector<int>& neighbors) {
+    neighbors.clear();
+    const double sq_radius = radius * radius;
+    const int n = num_points();
+    // Double k until the k-th neighbor falls outside the ball.
+    for (int k = RADIUS_START_K;; k = std::min(2 * k, n)) {
+        query(p, k, -1);
+        if (int(candidates_.size()) < k || candidates_.back().first > sq_radius || k >= n) {
+            break;
+        }
+    }
+    for (const std::pair<double, int>& candidate : candidates_) {
+        if (candidate.first > sq_radius) {
+            break;
+        }
+        neighbors.push_back(candidate.second);
+    }
+}
+
+void NeighborIndex::within_radius_of_point(int i, double radius, std::vector<int>& neighbors) {
+    neighbors.clear();
+    if (i < 0 || i >= num_points()) {
+        return;
+    }
+    const double* p = &points_[size_t(i) * 3];
+    const double sq_radius = radius * radius;
+    const int others = num_points() - 1;
+    for (int k = RADIUS_START_K;; k = std::min(2 * k, others)) {
+        query(p, k, i);
+        if (int(candidates_.size()) < k || candidates_.back().first > sq_radius || k >= others) {
+            break;
+        }
+    }
+    for (const std::pair<double, int>& candidate : candidates_) {
+        if (candidate.first > sq_radius) {
+            break;
+        }
+        neighbors.push_back(candidate.second);
+    }
+}
+
+int NeighborIndex::all_nearest(int k, std::vector<int>& neighbors, std::vector<double>* sq_dists) {
+    const int n = num_points();
+    const int row = std::max(0, std::min(k, n - 1));
+    neighbors.resize(size_t(n) * size_t(row));
+    if (sq_dists != nullptr) {
+        sq_dists->resize(neighbors.size());
+    }
+    for (int i = 0; i < n; ++i) {
+        nearest_to_point(i, row, &neighbors[size_t(i) * size_t(row)],
+                         sq_dists != nullptr ? &(*sq_dists)[size_t(i) * size_t(row)] : nullptr);
+    }
+    return row;
+}
+
+void NeighborIndex::all_within_radius(double radius, std::vector<int>& rowptr, std::vector<int>& colidx) {
+    const int n = num_points();
+    rowptr.assign(size_t(n) + 1, 0);
+    colidx.clear();
+    for (int i = 0; i < n; ++i) {
+        within_radius_of_point(i, radius, row_);
+        colidx.insert(colidx.end(), row_.begin(), row_.end());
+        rowptr[size_t(i) + 1] = int(colidx.size());
+    }
+}
@@ -0,0 +1,93 @@
+// neighbor_index.h
+//
+// k-nearest-neighbor and radius queries over a point set, backed by the PSM's
+// balanced kd-tree (GEO::NearestNeighborSearch "BNN"). In periodic mode the
+// distances are taken across the faces of the unit cube: a query also visits
+// the images of the cube its search ball reaches, so each point is reported
+// once, at its minimum image distance. The tree is rebuilt lazily, on the
+// first query after the points moved.
+
+#pragma once
+
+#include "delaunay_core.h"
+#include <utility>
+#include <vector>
+
+class NeighborIndex {
+public:
+    explicit NeighborIndex(bool is_periodic);
+
+    bool is_periodic() const {
+        return is_periodic_;
+    }
+
+    // Copies num_points xyz triplets. The tree is only marked stale if a
+    // coordinate changed, so calling this every frame is cheap when the
+    // points stand still.
+    void set_points(const double* coords, int num_points);
+
+    // set_points() from the current points of a context.
+    void sync(const DelaunayContext& context) {
+        set_points(context.points().data(), context.num_points());
+    }
+
+    int num_points() const {
+        return int(points_.size() / 3);
+    }
+
+    const std::vector<double>& points() const {
+        return points_;
+    }
+
+    // true until the next query rebuilds the tree.
+    bool is_stale() const {
+        return stale_;
+    }
+
+    // Tree builds since the creation of the index.
+    int num_rebuilds() const {
+        return num_rebuilds_;
+    }
+
+    // The min(k, n) points nearest to p, by increasing squared distance (ties
+    // by index), into neighbors and sq_dists (optional). Returns the count.
+    int nearest(const double* p, int k, int* neighbors, double* sq_dists = nullptr);
+
+    // Same for point i, which is itself excluded. Returns -1 if i is out of
+    // range.
+    int nearest_to_point(int i, int k, int* neighbors, double* sq_dists = nullptr);
+
+    // The points within radius of p (distance <= radius), by increasing
+    // distance, into neighbors (cleared first).
+    void within_radius(const double* p, double radius, std::vector<int>& neighbors);
+
+    // Same for point i, itself excluded.
+    void within_radius_of_point(int i, double radius, std::vector<int>& neighbors);
+
+    // The k nearest points of every point, itself excluded: n * min(k, n - 1)
+    // indices in neighbors, point by point, and the squared distances in
+    // sq_dists if not null. Returns the row length min(k, n - 1).
+    int all_nearest(int k, std::vector<int>& neighbors, std::vector<double>* sq_dists = nullptr);
+
+    // The points within radius of every point, itself excluded, as CSR arrays:
+    // the neighbors of v in colidx[rowptr[v]] to colidx[rowptr[v + 1] - 1],
+    // by increasing distance.
+    void all_within_radius(double radius, std::vector<int>& rowptr, std::vector<int>& colidx);
+
+private:
+    void rebuild();
+    void query(const double* p, int k, int exclude);
+
+    bool is_periodic_;
+    std::vector<double> points_;
+    GEO::NearestNeighborSearch_var tree_;
+    bool stale_ = true;
+    int num_rebuilds_ = 0;
+
+    // Query scratch: tree hits, and (sq_dist, index) candidates across the
+    // periodic images.
+    std::vector<GEO::index_t> hits_;
+    std::vector<double> hit_dists_;
+    std::vector<std::pair<double, int>> candidates_;
+    std::vector<int> row_;
+};
@@ -1,173 +1,845 @@
+// periodic_delaunay.cpp
+//
+// Embind bindings of the triangulation core (delaunay_core.h), of its
+// snapshots (snapshot.h), of the parameter sweeps (batch_compute.h), of the
+// lazy analysis cache (analysis_cache.h), of the 2D engine (delaunay_2d.h),
+// of the physics stepper (physics_step.h), of the neighbor index
+// (neighbor_index.h), of the tet centers (tet_centers.h) and of the render
+// buffers (render_buffers.h).
+
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
-#include "Delaunay_psm.h"
+#include "acuteness.h"
+#include "analysis_cache.h"
+#include "batch_compute.h"
+#include "delaunay_2d.h"
+#include "delaunay_core.h"
+#include "frame_arena.h"
+#include "neighbor_index.h"
+#include "physics_step.h"
+#include "render_buffers.h"
+#include "snapshot.h"
+#include "tet_centers.h"
 #include <iostream>
 #include <memory>
 #include <vector>
-#include <set>
 #include <algorithm>
 
-// Global initialization flag
-static bool g_geogram_initialized = false;
+// Buffers owned by the module for the zero-copy entry points.
+// JS writes coordinates straight into g_points_buffer through a typed
+// memory view and reads the tets back from g_tets_buffer the same way.
+static std::vector<double> g_points_buffer;
+static std::vector<int> g_tets_buffer;
 
-// Initialize Geogram once
-void initialize_geogram() {
-    if (!g_geogram_initialized) {
-        // Initialize Geogram using the PSM's initialize function
-        GEO::initialize();
-        g_geogram_initialized = true;
-        std::cout << "Geogram initialized." << std::endl;
-    }
+static TetDeduplicator g_tet_dedup;
+
+// BRIO insertion order of the last compute_delaunay or
+// compute_delaunay_buffer, see last_spatial_order().
+static std::vector<int> g_spatial_order;
+
+static void save_spatial_order(const GEO::PeriodicDelaunay3d& delaunay, int num_points) {
+    const GEO::index_t* order = delaunay.insertion_order();
+    g_spatial_order.assign(order, order + num_points);
+}
+
+// Staging buffer of NeighborIndex.set_points(), and results of the last
+// query, returned as views.
+static std::vector<double> g_neighbor_points;
+static std::vector<int> g_neighbors;
+static std::vector<double> g_neighbor_sq_dists;
+static std::vector<int> g_neighbor_rowptr;
+
+// Counters of the last call to any compute entry point, see last_stats().
+static DelaunayStats g_last_stats;
+
+// JS object mirroring DelaunayStats, with the stage times in milliseconds.
+static emscripten::val stats_to_val(const DelaunayStats& stats) {
+    emscripten::val stages = emscripten::val::object();
+    stages.set("marshal", stats.marshal * 1000.0);
+    stages.set("reorder", stats.reorder * 1000.0);
+    stages.set("insertion", stats.insertion * 1000.0);
+    stages.set("periodic_phase_1", stats.periodic_phase_1 * 1000.0);
+    stages.set("periodic_phase_2", stats.periodic_phase_2 * 1000.0);
+    stages.set("compress", stats.compress * 1000.0);
+    stages.set("dedup", stats.dedup * 1000.0);
+    stages.set("certify", stats.certify * 1000.0);
+    stages.set("output", stats.output * 1000.0);
+    stages.set("total", stats.total * 1000.0);
+
+    emscripten::val result = emscripten::val::object();
+    result.set("incremental", stats.incremental);
+    result.set("weighted", stats.weighted);
+    result.set("stages_ms", stages);
+    result.set("num_raw_tets", stats.num_raw_tets);
+    result.set("num_unique_tets", stats.num_unique_tets);
+    result.set("nb_reallocations", stats.nb_reallocations);
+    result.set("heap_bytes", stats.heap_bytes);
+    result.set("peak_memory_bytes", stats.peak_memory_bytes);
+    result.set("retained_bytes", stats.retained_bytes);
+    return result;
+}
+
+// Counters and stage timings of the last compute_delaunay,
+// compute_delaunay_buffer or DelaunayContext update, as a plain object:
+//   { incremental, weighted, stages_ms: { marshal, reorder, insertion,
+//     periodic_phase_1, periodic_phase_2, compress, dedup, certify, output,
+//     total }, num_raw_tets, num_unique_tets, nb_reallocations, heap_bytes,
+//     peak_memory_bytes, retained_bytes }
+emscripten::val last_stats() {
+    return stats_to_val(g_last_stats);
 }
 
 // Wrapper function that uses Emscripten's val for easier JavaScript interaction
 emscripten::val compute_periodic_delaunay_js(emscripten::val points_array, int num_points, bool is_periodic) {
-    // --- 1. Initialize ---
-    initialize_geogram();
-    std::cout << "Starting Delaunay computation..." << std::endl;
-
-    // --- 2. Create Delaunay Object ---
-    std::unique_ptr<GEO::PeriodicDelaunay3d> delaunay;
-    
-    if (is_periodic) {
-        delaunay = std::make_unique<GEO::PeriodicDelaunay3d>(GEO::vec3(1.0, 1.0, 1.0));
-    } else {
-        delaunay = std::make_unique<GEO::PeriodicDelaunay3d>(false);
-    }
-    
-    delaunay->set_stores_cicl(false);
+    frame_arena().reset();
 
-    std::cout << "Delaunay object created. Periodic mode: " << is_periodic << std::endl;
-    std::cout << "Processing " << num_points << " points." << std::endl;
-
-    // --- 3. Get points from JavaScript array ---
-    std::vector<double> vertices;
-    vertices.reserve(num_points * 3);
-    
     // Extract points from JavaScript Float64Array
+    FrameVector<double> vertices;
+    vertices.reserve(num_points * 3);
     for (int i = 0; i < num_points * 3; i++) {
-        double coord = points_array[i].as<double>();
-        // Ensure coordinates are in [0,1) range
-        while (coord < 0.0) coord += 1.0;
-        while (coord >= 1.0) coord -= 1.0;
-        vertices.push_back(coord);
+        vertices.push_back(points_array[i].as<double>());
     }
-    
-    // Print first few points for debugging
-    std::cout << "First 3 points:" << std::endl;
-    for (int i = 0; i < std::min(3, num_points); i++) {
-        std::cout << "  Point " << i << ": (" 
-                  << vertices[i*3] << ", " 
-                  << vertices[i*3+1] << ", " 
-                  << vertices[i*3+2] << ")" << std::endl;
-    }
-
-    // --- 4. Set vertices ---
-    delaunay->set_vertices(num_points, vertices.data());
-    std::cout << "Vertices set. Actual vertex count: " << delaunay->nb_vertices() << std::endl;
 
-    // --- 5. Compute ---
-    try {
-        delaunay->compute();
-        std::cout << "Delaunay computation successful." << std::endl;
-    } catch (const std::exception& e) {
-        std::cerr << "Exception during compute: " << e.what() << std::endl;
-        return emscripten::val::null();
-    } catch (...) {
-        std::cerr << "Unknown exception during compute." << std::endl;
-        return emscripten::val::null();
+    FrameVector<int> tets;
+    if (!is_periodic) {
+        // No periodic machinery to go through: the plain engine is faster.
+        g_spatial_order.clear();
+        if (!compute_bounded_tets(vertices.data(), num_points, tets, &g_last_stats)) {
+            return emscripten::val::null();
+        }
+    } else {
+        std::unique_ptr<GEO::PeriodicDelaunay3d> delaunay = create_delaunay(is_periodic);
+        if (!compute_unique_tets(*delaunay, vertices.data(), num_points, is_periodic, g_tet_dedup, tets,
+                                 &g_last_stats)) {
+            return emscripten::val::null();
+        }
+        save_spatial_order(*delaunay, num_points);
     }
 
-    // --- 6. Get results ---
-    int num_tets = delaunay->nb_cells();
-    std::cout << "Found " << num_tets << " tetrahedra." << std::endl;
-    
-    // Debug: Check the actual number of vertices in the triangulation
-    if (is_periodic) {
-        std::cout << "DEBUG: nb_vertices() = " << delaunay->nb_vertices() << std::endl;
-        std::cout << "DEBUG: original num_points = " << num_points << std::endl;
-    }
-    
-    // Also check if we have a valid triangulation
-    if (num_tets == 0 && num_points >= 4) {
-        std::cout << "WARNING: No tetrahedra generated despite having " << num_points << " points." << std::endl;
-        std::cout << "This might indicate degenerate point configuration." << std::endl;
-    }
-    
-    if (num_tets == 0) {
-        return emscripten::val::array();
-    }
-    
     // Create JavaScript array for results
     emscripten::val result = emscripten::val::array();
-    
-    // In periodic mode, Geogram creates 27 copies of each vertex (3^3 for 3D)
-    // We need to map the vertex indices back to the original range [0, num_points)
-    const int nb_vertices_non_periodic = num_points;
-    
-    // Debug first few tetrahedra
-    if (is_periodic) {
-        std::cout << "DEBUG: First few tetrahedra raw indices:" << std::endl;
-        for (int t = 0; t < std::min(3, num_tets); ++t) {
-            std::cout << "  Tet " << t << ": [" 
-                      << delaunay->cell_vertex(t, 0) << ", "
-                      << delaunay->cell_vertex(t, 1) << ", "
-                      << delaunay->cell_vertex(t, 2) << ", "
-                      << delaunay->cell_vertex(t, 3) << "]" << std::endl;
+    for (size_t t = 0; t < tets.size() / 4; ++t) {
+        emscripten::val tet = emscripten::val::array();
+        for (int v = 0; v < 4; ++v) {
+            tet.set(v, tets[t * 4 + v]);
         }
+        result.set(t, tet);
     }
-    
-    // Use a set to track unique tetrahedra
-    std::set<std::vector<int>> unique_tets;
-    int duplicate_count = 0;
-    
-    for (int t = 0; t < num_tets; ++t) {
-        std::vector<int> tet_indices(4);
-        
-        for (int v = 0; v < 4; ++v) {
-            int vertex_index = delaunay->cell_vertex(t, v);
-            
-            // In periodic mode, map back to original vertex
-            if (is_periodic && vertex_index >= nb_vertices_non_periodic) {
-                vertex_index = vertex_index % nb_vertices_non_periodic;
-            }
-            
-            // Ensure the index is valid
-            if (vertex_index < 0 || vertex_index >= nb_vertices_non_periodic) {
-                std::cerr << "Invalid vertex index " << vertex_index 
-                          << " in tetrahedron " << t << std::endl;
-                vertex_index = 0; // Fallback to prevent crashes
-            }
-            
-            tet_indices[v] = vertex_index;
+
+    return result;
+}
+
+// Returns a Float64Array view over the module-owned coordinate buffer,
+// sized for num_points xyz triplets. JS fills it in place before calling
+// compute_delaunay_buffer. The view is invalidated if the WASM heap grows,
+// so callers should request it again before every compute.
+emscripten::val get_points_buffer(int num_points) {
+    g_points_buffer.resize(std::max(num_points, 0) * 3);
+    return emscripten::val(emscripten::typed_memory_view(
+        g_points_buffer.size(), g_points_buffer.data()));
+}
+
+// Zero-copy variant of compute_delaunay: reads the coordinates from the
+// buffer returned by get_points_buffer and returns the unique tets as a flat
+// Int32Array (4 indices per tet) viewing a module-owned buffer. The view stays
+// valid until the next call.
+emscripten::val compute_delaunay_buffer(int num_points, bool is_periodic) {
+    if (num_points < 0 || size_t(num_points) * 3 > g_points_buffer.size()) {
+        if (log_level() >= LOG_ERRORS) {
+            std::cerr << "compute_delaunay_buffer: points buffer holds "
+                      << g_points_buffer.size() / 3 << " points, "
+                      << num_points << " requested." << std::endl;
         }
-        
-        // Sort the indices to create a canonical representation
-        std::vector<int> sorted_indices = tet_indices;
-        std::sort(sorted_indices.begin(), sorted_indices.end());
-        
-        // Check if this tetrahedron is unique
-        if (unique_tets.insert(sorted_indices).second) {
-            // This is a new unique tetrahedron, add it to results
-            emscripten::val tet = emscripten::val::array();
-            for (int v = 0; v < 4; ++v) {
-                tet.set(v, tet_indices[v]);
-            }
-            result.set(result["length"].as<int>(), tet);
-        } else {
-            duplicate_count++;
+        return emscripten::val::null();
+    }
+
+    frame_arena().reset();
+    g_tets_buffer.clear();
+    if (!is_periodic) {
+        g_spatial_order.clear();
+        if (!compute_bounded_tets(g_points_buffer.data(), num_points, g_tets_buffer, &g_last_stats)) {
+            return emscripten::val::null();
         }
+    } else {
+        std::unique_ptr<GEO::PeriodicDelaunay3d> delaunay = create_delaunay(is_periodic);
+        if (!compute_unique_tets(*delaunay, g_points_buffer.data(), num_points, is_periodic,
+                                 g_tet_dedup, g_tets_buffer, &g_last_stats)) {
+            return emscripten::val::null();
+        }
+        save_spatial_order(*delaunay, num_points);
+    }
+
+    return emscripten::val(emscripten::typed_memory_view(
+        g_tets_buffer.size(), g_tets_buffer.data()));
+}
+
+// Int32Array view of the order in which the last compute_delaunay or
+// compute_delaunay_buffer inserted the points: the PSM's BRIO order, in
+// which each level is Hilbert-sorted. Laying the points out in that order
+// (point k = old point order[k]) keeps neighbors close in memory, see
+// DelaunayContext.sort_points_spatially(). Empty after a non-periodic call,
+// whose engine keeps its order internal. Valid until the next call.
+emscripten::val last_spatial_order() {
+    return emscripten::val(emscripten::typed_memory_view(
+        g_spatial_order.size(), g_spatial_order.data()));
+}
+
+// Usage of the per-frame scratch arena, in bytes: what the last call used,
+// the high-water mark over all calls so far, and what is currently reserved.
+// Pass the high-water mark of a representative run to frame_arena_reserve()
+// at startup so that no frame has to grow the arena.
+emscripten::val frame_arena_stats() {
+    const FrameArena& arena = frame_arena();
+    emscripten::val stats = emscripten::val::object();
+    stats.set("used", double(arena.used()));
+    stats.set("high_water_mark", double(arena.high_water_mark()));
+    stats.set("capacity", double(arena.capacity()));
+    stats.set("blocks", int(arena.nb_blocks()));
+    return stats;
+}
+
+void frame_arena_reserve(double bytes) {
+    frame_arena().reserve(size_t(std::max(bytes, 0.0)));
+}
+
+// Frees the arena and restarts the high-water mark, e.g. after a one-off
+// very large frame.
+void frame_arena_release() {
+    frame_arena().release();
+    frame_arena().reset_high_water_mark();
+}
+
+template <class T>
+static emscripten::val array_view(const std::vector<T>& values) {
+    return emscripten::val(emscripten::typed_memory_view(values.size(), values.data()));
+}
+
+// Tets view of a context after an update, or null if it failed.
+static emscripten::val update_result(const DelaunayContext& context, bool ok) {
+    g_last_stats = context.stats();
+    return ok ? array_view(context.tets()) : emscripten::val::null();
+}
+
+// Reusable chunk of DelaunayContext.tets_chunk(), shared by all contexts.
+static std::vector<int> g_tets_chunk;
+
+// Inputs and meshes of the last build_render_buffers call.
+static std::vector<double> g_render_points;
+static std::vector<int> g_render_tets;
+static RenderBuffers g_render_buffers;
+
+static emscripten::val render_mesh_to_val(const RenderMesh& mesh, bool quantized) {
+    emscripten::val result = emscripten::val::object();
+    result.set("positions", quantized ? array_view(mesh.quantized_positions)
+                                      : array_view(mesh.positions));
+    result.set("indices", array_view(mesh.indices));
+    result.set("num_vertices", mesh.num_vertices());
+    return result;
+}
+
+// Render buffers of a Float64Array of points (xyz) and an Int32Array of tets
+// (4 per tet), with the tet circumcenters as the Voronoi vertices if
+// circumcenters (else the barycenters), see build_render_buffers():
+//   { delaunay_edges, voronoi_edges, tets, voronoi_faces: { positions,
+//     indices, num_vertices }, face_offsets, face_points, quantized, offset,
+//     scale }
+// positions is a Float32Array, or a Uint16Array if quantize. The views stay
+// valid until the next call.
+emscripten::val build_render_buffers_js(emscripten::val points, emscripten::val tets,
+                                        bool is_periodic, bool quantize, bool circumcenters) {
+    g_render_points.resize(points["length"].as<size_t>());
+    g_render_tets.resize(tets["length"].as<size_t>());
+    emscripten::val(emscripten::typed_memory_view(g_render_points.size(), g_render_points.data()))
+        .call<void>("set", points);
+    emscripten::val(emscripten::typed_memory_view(g_render_tets.size(), g_render_tets.data()))
+        .call<void>("set", tets);
+    RenderBuffers& buffers = g_render_buffers;
+    build_render_buffers(g_render_points.data(), int(g_render_points.size() / 3),
+                         g_render_tets.data(), int(g_render_tets.size() / 4),
+                         is_periodic, quantize,
+                         circumcenters ? TET_CIRCUMCENTER : TET_BARYCENTER, buffers);
+
+    emscripten::val result = emscripten::val::object();
+    result.set("delaunay_edges", render_mesh_to_val(buffers.delaunay_edges, quantize));
+    result.set("voronoi_edges", render_mesh_to_val(buffers.voronoi_edges, quantize));
+    result.set("tets", render_mesh_to_val(buffers.tets, quantize));
+    result.set("voronoi_faces", render_mesh_to_val(buffers.voronoi_faces, quantize));
+    result.set("face_offsets", array_view(buffers.face_offsets));
+    result.set("face_points", array_view(buffers.face_points));
+    result.set("quantized", buffers.quantized);
+    result.set("offset", buffers.offset);
+    result.set("scale", buffers.scale);
+    return result;
+}
+
+// Sections and bytes of the last encode_snapshot or decode_snapshot call.
+static Snapshot g_snapshot;
+static std::vector<uint8_t> g_snapshot_bytes;
+
+// Copies a typed array into values, or clears them for null / undefined.
+template <class T>
+static void copy_array(emscripten::val array, std::vector<T>& values) {
+    if (array.isNull() || array.isUndefined()) {
+        values.clear();
+        return;
     }
-    
-    if (is_periodic && duplicate_count > 0) {
-        std::cout << "Filtered out " << duplicate_count << " duplicate tetrahedra." << std::endl;
-        std::cout << "Returning " << unique_tets.size() << " unique tetrahedra." << std::endl;
+    values.resize(array["length"].as<size_t>());
+    emscripten::val(emscripten::typed_memory_view(values.size(), values.data()))
+        .call<void>("set", array);
+}
+
+// Binary snapshot (see snapshot.h) of a periodicity and typed arrays of xyz
+// points, weights, tets (4 per tet), the CSR Delaunay graph (rowptr, colidx)
+// and acuteness scores. All but points and tets may be null. Returns a
+// Uint8Array view valid until the next call, or null if the sections are
+// inconsistent.
+emscripten::val encode_snapshot(bool is_periodic, emscripten::val points, emscripten::val weights,
+                                emscripten::val tets, emscripten::val rowptr,
+                                emscripten::val colidx, emscripten::val scores) {
+    Snapshot& snapshot = g_snapshot;
+    snapshot.is_periodic = is_periodic;
+    copy_array(points, snapshot.points);
+    copy_array(weights, snapshot.weights);
+    copy_array(tets, snapshot.tets);
+    copy_array(rowptr, snapshot.adjacency_rowptr);
+    copy_array(colidx, snapshot.adjacency);
+    copy_array(scores, snapshot.scores);
+    if (!write_snapshot(snapshot, g_snapshot_bytes)) {
+        return emscripten::val::null();
     }
+    return array_view(g_snapshot_bytes);
+}
 
+// Decodes the Uint8Array of a snapshot, copied into module memory with one
+// TypedArray.set() call:
+//   { is_periodic, points, weights, tets, rowptr, colidx, scores }
+// views valid until the next call (empty for an absent section), or null if
+// the bytes are not a valid snapshot.
+emscripten::val decode_snapshot(emscripten::val bytes) {
+    copy_array(bytes, g_snapshot_bytes);
+    Snapshot& snapshot = g_snapshot;
+    if (!read_snapshot(g_snapshot_bytes.data(), g_snapshot_bytes.size(), snapshot)) {
+        if (log_level() >= LOG_ERRORS) {
+            std::cerr << "decode_snapshot: invalid or truncated snapshot." << std::endl;
+        }
+        return emscripten::val::null();
+    }
+    emscripten::val result = emscripten::val::object();
+    result.set("is_periodic", snapshot.is_periodic);
+    result.set("points", array_view(snapshot.points));
+    result.set("weights", array_view(snapshot.weights));
+    result.set("tets", array_view(snapshot.tets));
+    result.set("rowptr", array_view(snapshot.adjacency_rowptr));
+    result.set("colidx", array_view(snapshot.adjacency));
+    result.set("scores", array_view(snapshot.scores));
     return result;
 }
 
-// --- 7. Embind module ---
+// Inputs and output of the last compute_tet_centers call.
+static std::vector<double> g_center_points;
+static std::vector<int> g_center_tets;
+static std::vector<int8_t> g_center_translations;
+static std::vector<double> g_centers;
+
+// Voronoi vertices of a Float64Array of points (xyz) and an Int32Array of
+// tets (4 per tet): the barycenter of each tet, or its circumcenter if
+// circumcenters, unwrapped with the Int8Array of DelaunayContext
+// tet_translations() if given (null: minimum image) and wrapped into [0,1)
+// in periodic mode, see tet_centers.h. Returns a Float64Array view of 3
+// coordinates per tet, valid until the next call.
+emscripten::val compute_tet_centers_js(emscripten::val points, emscripten::val tets,
+                                       emscripten::val translations, bool is_periodic,
+                                       bool circumcenters) {
+    copy_array(points, g_center_points);
+    copy_array(tets, g_center_tets);
+    copy_array(translations, g_center_translations);
+    const int num_tets = int(g_center_tets.size() / 4);
+    const bool has_translations = g_center_translations.size() == size_t(num_tets) * 12;
+    g_centers.resize(size_t(num_tets) * 3);
+    compute_tet_centers(g_center_points.data(), g_center_tets.data(), num_tets,
+                        has_translations ? g_center_translations.data() : nullptr, is_periodic,
+                        circumcenters ? TET_CIRCUMCENTER : TET_BARYCENTER, g_centers.data());
+    return array_view(g_centers);
+}
+
+// Triangles view of a 2D context after an update, or null if it failed.
+static emscripten::val update_result(const DelaunayContext2d& context, bool ok) {
+    g_last_stats = context.stats();
+    return ok ? array_view(context.triangles()) : emscripten::val::null();
+}
+
+// Scores of the last DelaunayContext2d.triangle_acuteness call.
+static std::vector<int> g_triangle_scores_2d;
+
+// Items and scores of the last AnalysisCache.scores_of call.
+static std::vector<int> g_analysis_items;
+static std::vector<int> g_analysis_scores;
+
+// Inputs of the last DelaunayBatch.compute call.
+static std::vector<double> g_batch_points;
+static std::vector<int> g_batch_offsets;
+
+// --- Embind module ---
+// DelaunayContext views (get_points_buffer, compute, changed_cells,
+// compute_adjacency, compute_voronoi_cells, ...) alias the context's buffers
+// and stay valid until the next call that refills them, or destroy().
+// compute(), compute_incremental(), compute_adjacency() and
+// compute_voronoi_cells() return null on failure.
 EMSCRIPTEN_BINDINGS(my_module) {
     emscripten::function("compute_delaunay", &compute_periodic_delaunay_js);
-} 
\ No newline at end of file
+    emscripten::function("get_points_buffer", &get_points_buffer);
+    emscripten::function("compute_delaunay_buffer", &compute_delaunay_buffer);
+    emscripten::function("frame_arena_stats", &frame_arena_stats);
+    emscripten::function("frame_arena_reserve", &frame_arena_reserve);
+    emscripten::function("frame_arena_release", &frame_arena_release);
+    emscripten::function("last_stats", &last_stats);
+    emscripten::function("last_spatial_order", &last_spatial_order);
+    emscripten::function("build_render_buffers", &build_render_buffers_js);
+    emscripten::function("encode_snapshot", &encode_snapshot);
+    emscripten::function("decode_snapshot", &decode_snapshot);
+    emscripten::function("compute_tet_centers", &compute_tet_centers_js);
+    // 0 quiet, 1 errors (default), 2 info, 3 debug
+    emscripten::function("set_log_level", &set_log_level);
+    emscripten::function("log_level", &log_level);
+
+    emscripten::class_<DelaunayContext>("DelaunayContext")
+        .constructor<bool>()
+        .class_function("create", emscripten::optional_override([](bool is_periodic) {
+            return new DelaunayContext(is_periodic);
+        }), emscripten::allow_raw_pointers())
+        .function("is_periodic", &DelaunayContext::is_periodic)
+        .function("num_points", &DelaunayContext::num_points)
+        .function("has_triangulation", &DelaunayContext::has_triangulation)
+        // Current coordinates, e.g. after PhysicsStepper.step().
+        .function("points", emscripten::optional_override([](const DelaunayContext& context) {
+            return array_view(context.points());
+        }))
+        .function("get_points_buffer", emscripten::optional_override(
+            [](DelaunayContext& context, int num_points) {
+                double* points = context.points_buffer(num_points);
+                return emscripten::val(emscripten::typed_memory_view(
+                    size_t(context.num_points()) * 3, points));
+            }))
+        // Copies a Float64Array of xyz triplets with a single TypedArray.set() call.
+        .function("update_points", emscripten::optional_override(
+            [](DelaunayContext& context, emscripten::val points) {
+                int num_points = points["length"].as<int>() / 3;
+                double* buffer = context.points_buffer(num_points);
+                emscripten::val(emscripten::typed_memory_view(size_t(num_points) * 3, buffer))
+                    .call<void>("set", points);
+            }))
+        // Weighted (power / Laguerre) mode, see DelaunayContext::weights_buffer().
+        .function("get_weights_buffer", emscripten::optional_override(
+            [](DelaunayContext& context, int num_points) {
+                double* weights = context.weights_buffer(num_points);
+                return emscripten::val(emscripten::typed_memory_view(
+                    size_t(std::max(num_points, 0)), weights));
+            }))
+        .function("update_weights", emscripten::optional_override(
+            [](DelaunayContext& context, emscripten::val weights) {
+                int num_points = weights["length"].as<int>();
+                double* buffer = context.weights_buffer(num_points);
+                emscripten::val(emscripten::typed_memory_view(size_t(num_points), buffer))
+                    .call<void>("set", weights);
+            }))
+        .function("clear_weights", &DelaunayContext::clear_weights)
+        .function("is_weighted", &DelaunayContext::is_weighted)
+        .function("compute", emscripten::optional_override([](DelaunayContext& context) {
+            return update_result(context, context.compute());
+        }))
+        .function("compute_incremental", emscripten::optional_override(
+            [](DelaunayContext& context, double max_displacement) {
+                return update_result(context, context.compute_incremental(max_displacement));
+            }))
+        // Periodic translation of each tet vertex, 12 per tet, as an Int8Array,
+        // see DelaunayContext::set_keeps_tet_translations().
+        .function("set_keeps_tet_translations", &DelaunayContext::set_keeps_tet_translations)
+        .function("tet_translations", emscripten::optional_override(
+            [](const DelaunayContext& context) {
+                return array_view(context.tet_translations());
+            }))
+        // Low-memory mode, see DelaunayContext::set_low_memory(). keep lists
+        // the queries to keep available: { neighbors, voronoiCells,
+        // incremental }, each true or false; all of them if omitted.
+        .function("set_low_memory", emscripten::optional_override(
+            [](DelaunayContext& context, bool low_memory, emscripten::val keep) {
+                unsigned kept = KEEP_ALL_QUERIES;
+                if (!keep.isNull() && !keep.isUndefined()) {
+                    const emscripten::val neighbors = keep["neighbors"];
+                    const emscripten::val voronoi_cells = keep["voronoiCells"];
+                    const emscripten::val incremental = keep["incremental"];
+                    kept = KEEP_TETS_ONLY;
+                    if (!neighbors.isUndefined() && neighbors.as<bool>()) kept |= KEEP_NEIGHBORS;
+                    if (!voronoi_cells.isUndefined() && voronoi_cells.as<bool>()) kept |= KEEP_VORONOI_CELLS;
+                    if (!incremental.isUndefined() && incremental.as<bool>()) kept |= KEEP_INCREMENTAL;
+                }
+                context.set_low_memory(low_memory, kept);
+            }))
+        .function("is_low_memory", &DelaunayContext::is_low_memory)
+        .function("memory_bytes", emscripten::optional_override([](const DelaunayContext& context) {
+            return double(context.memory_bytes());
+        }))
+        .function("sort_points_spatially", &DelaunayContext::sort_points_spatially)
+        .function("spatial_order", emscripten::optional_override([](const DelaunayContext& context) {
+            return array_view(context.spatial_order());
+        }))
+        .function("points_spatially_sorted", &DelaunayContext::points_spatially_sorted)
+        .function("stats", emscripten::optional_override([](const DelaunayContext& context) {
+            return stats_to_val(context.stats());
+        }))
+        .function("last_update_was_incremental", &DelaunayContext::last_update_was_incremental)
+        .function("last_moved_count", &DelaunayContext::last_moved_count)
+        .function("changed_cells", emscripten::optional_override([](const DelaunayContext& context) {
+            return array_view(context.changed_cells());
+        }))
+        .function("moved_points", emscripten::optional_override([](const DelaunayContext& context) {
+            return array_view(context.moved_points());
+        }))
+        .function("update_version", &DelaunayContext::update_version)
+        // Delaunay graph in CSR form: compute_adjacency() returns the rowptr
+        // (num_points + 1 entries) or null, adjacency_colidx() the neighbors.
+        .function("compute_adjacency", emscripten::optional_override([](DelaunayContext& context) {
+            return context.compute_adjacency() ?
+                array_view(context.adjacency_rowptr()) : emscripten::val::null();
+        }))
+        .function("adjacency_colidx", emscripten::optional_override(
+            [](const DelaunayContext& context) {
+                return array_view(context.adjacency());
+            }))
+        .function("adjacency_version", &DelaunayContext::adjacency_version)
+        .function("compute_voronoi_cells", emscripten::optional_override([](DelaunayContext& context) {
+            return context.compute_voronoi_cells() ?
+                array_view(context.voronoi_cells()) : emscripten::val::null();
+        }))
+        // Streaming: the cells of points first to first + count - 1, packed
+        // as by compute_voronoi_cells(), or null.
+        .function("compute_voronoi_cells_range", emscripten::optional_override(
+            [](DelaunayContext& context, int first, int count) {
+                return context.compute_voronoi_cells(first, count) ?
+                    array_view(context.voronoi_cells()) : emscripten::val::null();
+            }))
+        // Streaming: up to count tets from tet first, as an Int32Array view of
+        // one module-owned chunk buffer, valid until the next call.
+        .function("tets_chunk", emscripten::optional_override(
+            [](const DelaunayContext& context, int first, int count) {
+                g_tets_chunk.resize(size_t(std::max(count, 0)) * 4);
+                const int copied = context.copy_tets(first, count, g_tets_chunk.data());
+                return emscripten::val(emscripten::typed_memory_view(
+                    size_t(copied) * 4, g_tets_chunk.data()));
+            }))
+        .function("voronoi_cell_vertices", emscripten::optional_override(
+            [](const DelaunayContext& context) {
+                return array_view(context.voronoi_cell_vertices());
+            }))
+        .function("destroy", &DelaunayContext::destroy);
+
+    // Parameter sweeps, see batch_compute.h. compute() takes the Float64Array
+    // of every job's xyz points, an Int32Array of num_jobs + 1 point offsets
+    // and { scores, maxNeighbors, incremental, maxDisplacement }, copies them
+    // in with one TypedArray.set() each and returns the number of jobs that
+    // succeeded, or -1 for inconsistent offsets. The result views alias the
+    // batch's buffers until its next compute() or release().
+    emscripten::class_<DelaunayBatch>("DelaunayBatch")
+        .constructor<bool>()
+        .function("is_periodic", &DelaunayBatch::is_periodic)
+        .function("num_jobs", &DelaunayBatch::num_jobs)
+        .function("compute", emscripten::optional_override(
+            [](DelaunayBatch& batch, emscripten::val points, emscripten::val offsets,
+               emscripten::val options) {
+                copy_array(points, g_batch_points);
+                copy_array(offsets, g_batch_offsets);
+                const int num_jobs = int(g_batch_offsets.size()) - 1;
+                bool valid = num_jobs >= 0 && g_batch_offsets[0] == 0 &&
+                             size_t(g_batch_offsets.back()) * 3 == g_batch_points.size();
+                for (int j = 0; valid && j < num_jobs; ++j) {
+                    valid = g_batch_offsets[j + 1] >= g_batch_offsets[j];
+                }
+                if (!valid) {
+                    if (log_level() >= LOG_ERRORS) {
+                        std::cerr << "DelaunayBatch.compute: offsets do not match the points." << std::endl;
+                    }
+                    return -1;
+                }
+                BatchOptions batch_options;
+                if (!options.isNull() && !options.isUndefined()) {
+                    const emscripten::val scores = options["scores"];
+                    const emscripten::val max_neighbors = options["maxNeighbors"];
+                    const emscripten::val incremental = options["incremental"];
+                    const emscripten::val max_displacement = options["maxDisplacement"];
+                    batch_options.scores = !scores.isUndefined() && scores.as<bool>();
+                    batch_options.incremental = !incremental.isUndefined() && incremental.as<bool>();
+                    if (!max_neighbors.isUndefined()) {
+                        batch_options.max_neighbors = max_neighbors.as<int>();
+                    }
+                    if (!max_displacement.isUndefined()) {
+                        batch_options.max_displacement = max_displacement.as<double>();
+                    }
+                }
+                const int num_ok = batch.compute(g_batch_points.data(), g_batch_offsets.data(),
+                                                 num_jobs, batch_options);
+                if (num_jobs > 0) {
+                    g_last_stats = batch.job_stats(num_jobs - 1);
+                }
+                return num_ok;
+            }))
+        // num_jobs + 1 offsets, in tets, into tets().
+        .function("tet_offsets", emscripten::optional_override([](const DelaunayBatch& batch) {
+            return array_view(batch.tet_offsets());
+        }))
+        .function("tets", emscripten::optional_override([](const DelaunayBatch& batch) {
+            return array_view(batch.tets());
+        }))
+        .function("scores", emscripten::optional_override([](const DelaunayBatch& batch) {
+            return array_view(batch.scores());
+        }))
+        .function("job_ok", emscripten::optional_override([](const DelaunayBatch& batch) {
+            return array_view(batch.job_ok());
+        }))
+        .function("job_stats", emscripten::optional_override([](const DelaunayBatch& batch, int j) {
+            return j >= 0 && j < batch.num_jobs() ? stats_to_val(batch.job_stats(j))
+                                                  : emscripten::val::null();
+        }))
+        .function("release", &DelaunayBatch::release);
+
+    // Lazy vertex / face / cell / edge scores of a DelaunayContext, see
+    // analysis_cache.h; metric 0 vertex, 1 face, 2 cell, 3 edge. Delete the
+    // cache before its context. scores() views alias the cache's scores
+    // until the next read of that metric, scores_of() views until the next
+    // scores_of() on any cache; both return null without a triangulation.
+    emscripten::class_<AnalysisCache>("AnalysisCache")
+        .constructor<const DelaunayContext&>()
+        .function("sync", &AnalysisCache::sync)
+        .function("count", &AnalysisCache::count)
+        .function("scores", emscripten::optional_override([](AnalysisCache& cache, int metric) {
+            const std::vector<int>* scores = cache.scores(metric);
+            return scores ? array_view(*scores) : emscripten::val::null();
+        }))
+        // Takes an Int32Array (or array) of item indices.
+        .function("scores_of", emscripten::optional_override(
+            [](AnalysisCache& cache, int metric, emscripten::val items) {
+                copy_array(items, g_analysis_items);
+                return cache.scores_of(metric, g_analysis_items.data(), int(g_analysis_items.size()),
+                                       g_analysis_scores) ?
+                    array_view(g_analysis_scores) : emscripten::val::null();
+            }))
+        .function("num_computed", emscripten::optional_override(
+            [](const AnalysisCache& cache, int metric) {
+                return double(cache.num_computed(metric));
+            }))
+        .function("num_invalidated", emscripten::optional_override(
+            [](const AnalysisCache& cache, int metric) {
+                return double(cache.num_invalidated(metric));
+            }))
+        // Face, cell and edge scores at the tet circumcenters instead of the
+        // barycenters; a change drops every score.
+        .function("set_circumcenters", emscripten::optional_override(
+            [](AnalysisCache& cache, bool circumcenters) {
+                cache.set_centers(circumcenters ? TET_CIRCUMCENTER : TET_BARYCENTER);
+            }))
+        .function("uses_circumcenters", emscripten::optional_override([](const AnalysisCache& cache) {
+            return cache.centers() == TET_CIRCUMCENTER;
+        }))
+        .function("num_rebuilds", &AnalysisCache::num_rebuilds)
+        .function("invalidate", &AnalysisCache::invalidate)
+        .function("memory_bytes", emscripten::optional_override([](const AnalysisCache& cache) {
+            return double(cache.memory_bytes());
+        }))
+        .function("release", &AnalysisCache::release);
+
+    // 2D counterpart of DelaunayContext, see delaunay_2d.h: the same calls
+    // on xy pairs, with 3 point indices per triangle where DelaunayContext
+    // has 4 per tet, and 2D Voronoi cells (see
+    // DelaunayContext2d::voronoi_cells()).
+    emscripten::class_<DelaunayContext2d>("DelaunayContext2d")
+        .constructor<bool>()
+        .function("is_periodic", &DelaunayContext2d::is_periodic)
+        .function("num_points", &DelaunayContext2d::num_points)
+        .function("has_triangulation", &DelaunayContext2d::has_triangulation)
+        .function("points", emscripten::optional_override([](const DelaunayContext2d& context) {
+            return array_view(context.points());
+        }))
+        .function("get_points_buffer", emscripten::optional_override(
+            [](DelaunayContext2d& context, int num_points) {
+                double* points = context.points_buffer(num_points);
+                return emscripten::val(emscripten::typed_memory_view(
+                    size_t(context.num_points()) * 2, points));
+            }))
+        .function("update_points", emscripten::optional_override(
+            [](DelaunayContext2d& context, emscripten::val points) {
+                int num_points = points["length"].as<int>() / 2;
+                double* buffer = context.points_buffer(num_points);
+                emscripten::val(emscripten::typed_memory_view(size_t(num_points) * 2, buffer))
+                    .call<void>("set", points);
+            }))
+        .function("get_weights_buffer", emscripten::optional_override(
+            [](DelaunayContext2d& context, int num_points) {
+                double* weights = context.weights_buffer(num_points);
+                return emscripten::val(emscripten::typed_memory_view(
+                    size_t(std::max(num_points, 0)), weights));
+            }))
+        .function("update_weights", emscripten::optional_override(
+            [](DelaunayContext2d& context, emscripten::val weights) {
+                int num_points = weights["length"].as<int>();
+                double* buffer = context.weights_buffer(num_points);
+                emscripten::val(emscripten::typed_memory_view(size_t(num_points), buffer))
+                    .call<void>("set", weights);
+            }))
+        .function("clear_weights", &DelaunayContext2d::clear_weights)
+        .function("is_weighted", &DelaunayContext2d::is_weighted)
+        .function("compute", emscripten::optional_override([](DelaunayContext2d& context) {
+            return update_result(context, context.compute());
+        }))
+        .function("compute_incremental", emscripten::optional_override(
+            [](DelaunayContext2d& context, double max_displacement) {
+                return update_result(context, context.compute_incremental(max_displacement));
+            }))
+        .function("memory_bytes", emscripten::optional_override([](const DelaunayContext2d& context) {
+            return double(context.memory_bytes());
+        }))
+        .function("stats", emscripten::optional_override([](const DelaunayContext2d& context) {
+            return stats_to_val(context.stats());
+        }))
+        .function("last_update_was_incremental", &DelaunayContext2d::last_update_was_incremental)
+        .function("last_moved_count", &DelaunayContext2d::last_moved_count)
+        .function("changed_cells", emscripten::optional_override([](const DelaunayContext2d& context) {
+            return array_view(context.changed_cells());
+        }))
+        .function("compute_adjacency", emscripten::optional_override([](DelaunayContext2d& context) {
+            return context.compute_adjacency() ?
+                array_view(context.adjacency_rowptr()) : emscripten::val::null();
+        }))
+        .function("adjacency_colidx", emscripten::optional_override(
+            [](const DelaunayContext2d& context) {
+                return array_view(context.adjacency());
+            }))
+        .function("adjacency_version", &DelaunayContext2d::adjacency_version)
+        .function("compute_voronoi_cells", emscripten::optional_override([](DelaunayContext2d& context) {
+            return context.compute_voronoi_cells() ?
+                array_view(context.voronoi_cells()) : emscripten::val::null();
+        }))
+        .function("voronoi_cell_vertices", emscripten::optional_override(
+            [](const DelaunayContext2d& context) {
+                return array_view(context.voronoi_cell_vertices());
+            }))
+        // Acute interior angles of each cell of compute_voronoi_cells() of the
+        // current update, as an Int32Array view of the context's scores, or
+        // null. With changed_only, the context's scores of the previous update
+        // are patched, see DelaunayContext2d::compute_cell_acuteness().
+        .function("cell_acuteness", emscripten::optional_override(
+            [](DelaunayContext2d& context, bool changed_only) {
+                return context.compute_cell_acuteness(changed_only) ?
+                    array_view(context.cell_scores()) : emscripten::val::null();
+            }))
+        .function("update_version", &DelaunayContext2d::update_version)
+        // Acute corners of each triangle (0..3), see triangleAcutenessInto().
+        .function("triangle_acuteness", emscripten::optional_override(
+            [](const DelaunayContext2d& context) {
+                if (!context.has_triangulation()) {
+                    return emscripten::val::null();
+                }
+                triangleAcutenessInto(context.points().data(), context.num_points(),
+                                      context.triangles().data(),
+                                      int(context.triangles().size() / 3),
+                                      context.is_periodic(), g_triangle_scores_2d);
+                return array_view(g_triangle_scores_2d);
+            }))
+        .function("destroy", &DelaunayContext2d::destroy);
+
+    // Physics step on the points of a DelaunayContext, see physics_step.h.
+    // velocities() and forces() alias the stepper's buffers until its next step.
+    emscripten::class_<PhysicsStepper>("PhysicsStepper")
+        .constructor<>()
+        .property("force_strength", &PhysicsStepper::force_strength)
+        .property("damping", &PhysicsStepper::damping)
+        .property("max_force", &PhysicsStepper::max_force)
+        .property("min_distance", &PhysicsStepper::min_distance)
+        .function("set_growth_rate", &PhysicsStepper::set_growth_rate)
+        .function("clear_growth_rates", &PhysicsStepper::clear_growth_rates)
+        .function("num_growing_cells", &PhysicsStepper::num_growing_cells)
+        .function("step", &PhysicsStepper::step)
+        .function("velocities", emscripten::optional_override([](const PhysicsStepper& stepper) {
+            return array_view(stepper.velocities());
+        }))
+        .function("forces", emscripten::optional_override([](const PhysicsStepper& stepper) {
+            return array_view(stepper.forces());
+        }))
+        .function("max_displacement", &PhysicsStepper::max_displacement)
+        .function("average_force", &PhysicsStepper::average_force)
+        // Takes an Int32Array, e.g. DelaunayContext.spatial_order().
+        .function("apply_permutation", emscripten::optional_override(
+            [](PhysicsStepper& stepper, emscripten::val order) {
+                std::vector<int> permutation(order["length"].as<size_t>());
+                emscripten::val(emscripten::typed_memory_view(permutation.size(), permutation.data()))
+                    .call<void>("set", order);
+                stepper.apply_permutation(permutation);
+            }))
+        .function("reset", &PhysicsStepper::reset);
+
+    // Query results are Int32Array / Float64Array views, valid until the next
+    // query on any index.
+    emscripten::class_<NeighborIndex>("NeighborIndex")
+        .constructor<bool>()
+        .function("is_periodic", &NeighborIndex::is_periodic)
+        .function("num_points", &NeighborIndex::num_points)
+        .function("is_stale", &NeighborIndex::is_stale)
+        .function("num_rebuilds", &NeighborIndex::num_rebuilds)
+        // Takes a Float64Array of xyz triplets.
+        .function("set_points", emscripten::optional_override(
+            [](NeighborIndex& index, emscripten::val points) {
+                std::vector<double>& coords = g_neighbor_points;
+                coords.resize(points["length"].as<size_t>());
+                emscripten::val(emscripten::typed_memory_view(coords.size(), coords.data()))
+                    .call<void>("set", points);
+                index.set_points(coords.data(), int(coords.size() / 3));
+            }))
+        .function("sync", &NeighborIndex::sync)
+        .function("nearest", emscripten::optional_override(
+            [](NeighborIndex& index, double x, double y, double z, int k) {
+                const double p[3] = {x, y, z};
+                g_neighbors.resize(size_t(std::max(k, 0)));
+                g_neighbor_sq_dists.resize(g_neighbors.size());
+                g_neighbors.resize(size_t(index.nearest(p, k, g_neighbors.data(),
+                                                        g_neighbor_sq_dists.data())));
+                g_neighbor_sq_dists.resize(g_neighbors.size());
+                return array_view(g_neighbors);
+            }))
+        .function("nearest_to_point", emscripten::optional_override(
+            [](NeighborIndex& index, int i, int k) {
+                g_neighbors.resize(size_t(std::max(k, 0)));
+                g_neighbor_sq_dists.resize(g_neighbors.size());
+                const int count = index.nearest_to_point(i, k, g_neighbors.data(),
+                                                         g_neighbor_sq_dists.data());
+                g_neighbors.resize(size_t(std::max(count, 0)));
+                g_neighbor_sq_dists.resize(g_neighbors.size());
+                return array_view(g_neighbors);
+            }))
+        .function("within_radius", emscripten::optional_override(
+            [](NeighborIndex& index, double x, double y, double z, double radius) {
+                const double p[3] = {x, y, z};
+                index.within_radius(p, radius, g_neighbors);
+                return array_view(g_neighbors);
+            }))
+        .function("within_radius_of_point", emscripten::optional_override(
+            [](NeighborIndex& index, int i, double radius) {
+                index.within_radius_of_point(i, radius, g_neighbors);
+                return array_view(g_neighbors);
+            }))
+        // n * k neighbor indices, point by point (k = min(k, n - 1)).
+        .function("all_nearest", emscripten::optional_override([](NeighborIndex& index, int k) {
+            index.all_nearest(k, g_neighbors, &g_neighbor_sq_dists);
+            return array_view(g_neighbors);
+        }))
+        // Squared distances of the last nearest* or all_nearest query.
+        .function("sq_dists", emscripten::optional_override([](const NeighborIndex&) {
+            return array_view(g_neighbor_sq_dists);
+        }))
+        // CSR row pointers; the column indices are then in colidx().
+        .function("all_within_radius", emscripten::optional_override(
+            [](NeighborIndex& index, double radius) {
+                index.all_within_radius(radius, g_neighbor_rowptr, g_neighbors);
+                return array_view(g_neighbor_rowptr);
+            }))
+        .function("colidx", emscripten::optional_override([](const NeighborIndex&) {
+            return array_view(g_neighbors);
+        }));
+}
@@ -0,0 +1,118 @@
+// physics_step.cpp
+//
+// Implementation of physics_step.h.
+
+#include "physics_step.h"
+#include "frame_arena.h"
+#include <algorithm>
+#include <cmath>
+
+void PhysicsStepper::set_growth_rate(int cell, double rate) {
+    auto it = std::find_if(growth_rates_.begin(), growth_rates_.end(),
+                           [cell](const std::pair<int, double>& entry) {
+                               return entry.first == cell;
+                           });
+    if (rate == 0.0) {
+        if (it != growth_rates_.end()) {
+            growth_rates_.erase(it);
+        }
+    } else if (it != growth_rates_.end()) {
+        it->second = rate;
+    } else {
+        growth_rates_.emplace_back(cell, rate);
+    }
+}
+
+bool PhysicsStepper::step(DelaunayContext& context, double dt) {
+    if (!context.has_triangulation()) {
+        return false;
+    }
+    const int n = context.num_points();
+    const size_t size = size_t(n) * 3;
+    velocities_.resize(size, 0.0);
+    forces_.assign(size, 0.0);
+    const std::vector<double>& points = context.points();
+
+    // Forces first: the neighbor positions are read from the points.
+    for (const std::pair<int, double>& entry : growth_rates_) {
+        const int g = entry.first;
+        const double rate = entry.second;
+        if (std::abs(rate) < 0.001 || !context.neighbors(g, neighbors_, &neighbor_positions_)) {
+            continue;
+        }
+        const double* p = &points[size_t(g) * 3];
+        double* growing_force = &forces_[size_t(g) * 3];
+        for (size_t k = 0; k < neighbors_.size(); ++k) {
+            const double* q = &neighbor_positions_[k * 3];
+            const double d[3] = {q[0] - p[0], q[1] - p[1], q[2] - p[2]};
+            const double distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            if (distance < min_distance) {
+                continue;
+            }
+            // Inverse square law, proportional to the growth rate.
+            const double magnitude = rate * force_strength / (distance * distance);
+            const double clamped = std::copysign(std::min(std::abs(magnitude), max_force), magnitude);
+            double* neighbor_force = &forces_[size_t(neighbors_[k]) * 3];
+            for (int c = 0; c < 3; ++c) {
+                const double f = d[c] / distance * clamped;
+                neighbor_force[c] += f;
+                // Reduced reaction keeps the growing cell more stable.
+                growing_force[c] -= f * 0.5;
+            }
+        }
+    }
+
+    double* x = context.points_buffer(n);
+    double max_velocity2 = 0.0;
+    double total_force = 0.0;
+    for (size_t i = 0; i < size; i += 3) {
+        double* v = &velocities_[i];
+        const double* f = &forces_[i];
+        for (int c = 0; c < 3; ++c) {
+            v[c] = (v[c] + f[c] * dt) * damping;
+            x[i + c] += v[c] * dt;
+        }
+        max_velocity2 = std::max(max_velocity2, v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        total_force += std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    }
+    max_displacement_ = std::sqrt(max_velocity2) * dt;
+    average_force_ = n > 0 ? total_force / n : 0.0;
+    return true;
+}
+
+void PhysicsStepper::apply_permutation(const std::vector<int>& order) {
+    const size_t n = order.size();
+    if (velocities_.size() == n * 3) {
+        frame_arena().reset();
+        double* sorted = frame_arena().allocate_array<double>(n * 3);
+        for (size_t k = 0; k < n; ++k) {
+            std::copy(&velocities_[size_t(order[k]) * 3], &velocities_[size_t(order[k]) * 3] + 3,
+                      sorted + k * 3);
+        }
+        std::copy(sorted, sorted + n * 3, velocities_.begin());
+    } else {
+        velocities_.clear();
+    }
+    forces_.clear();
+
+    std::vector<int> inverse(n, -1);
+    for (size_t k = 0; k < n; ++k) {
+        inverse[size_t(order[k])] = int(k);
+    }
+    for (std::pair<int, double>& entry : growth_rates_) {
+        entry.first = entry.first >= 0 && size_t(entry.first) < n ? inverse[size_t(entry.first)] : -1;
+    }
+    growth_rates_.erase(std::remove_if(growth_rates_.begin(), growth_rates_.end(),
+                                       [](const std::pair<int, double>& entry) {
+                                           return entry.first < 0;
+                                       }),
+                        growth_rates_.end());
+}
+
+void PhysicsStepper::reset() {
+    growth_rates_.clear();
+    velocities_.clear();
+    forces_.clear();
+    max_displacement_ = 0.0;
+    average_force_ = 0.0;
+}
@@ -0,0 +1,79 @@
+// physics_step.h
+//
+// Native counterpart of PhysicsExpansion.applyPhysicsStep: growing cells
+// push their Delaunay neighbors away (shrinking ones pull them in), and the
+// points of a DelaunayContext are integrated in place. The neighbors come
+// straight from the context's triangulation, so a step costs the stars of the
+// growing cells plus one pass over the points, with no allocation once the
+// buffers are sized.
+
+#pragma once
+
+#include "delaunay_core.h"
+#include <utility>
+#include <vector>
+
+class PhysicsStepper {
+public:
+    // Same parameters and defaults as PhysicsExpansion.
+    double force_strength = 0.5;
+    double damping = 0.8;
+    double max_force = 0.1;
+    double min_distance = 0.01;
+
+    // Growth rate of a cell: > 0 grows, < 0 shrinks, 0 removes it.
+    void set_growth_rate(int cell, double rate);
+
+    void clear_growth_rates() {
+        growth_rates_.clear();
+    }
+
+    int num_growing_cells() const {
+        return int(growth_rates_.size());
+    }
+
+    // Advances the points of context by one step of length dt:
+    //   - every growing cell g with |rate| >= 0.001 applies to each Delaunay
+    //     neighbor j the force rate * force_strength / d^2 along g -> j,
+    //     clamped to max_force, and half the opposite force to itself;
+    //   - velocities integrate the forces and are damped, positions integrate
+    //     the velocities, writing the context's points in place.
+    // Periodic neighbors are taken across the faces of the cube. The tets of
+    // the context are then stale: follow with compute_incremental(). Returns
+    // false without a triangulation.
+    bool step(DelaunayContext& context, double dt);
+
+    // Per-point velocities and forces of the last step, 3 per point.
+    const std::vector<double>& velocities() const {
+        return velocities_;
+    }
+
+    const std::vector<double>& forces() const {
+        return forces_;
+    }
+
+    // Largest |velocity| * dt, and mean |force|, of the last step.
+    double max_displacement() const {
+        return max_displacement_;
+    }
+
+    double average_force() const {
+        return average_force_;
+    }
+
+    // Follows DelaunayContext::sort_points_spatially(): point k becomes the
+    // point previously at order[k].
+    void apply_permutation(const std::vector<int>& order);
+
+    // Clears the velocities, forces and growth rates.
+    void reset();
+
+private:
+    std::vector<std::pair<int, double>> growth_rates_;
+    std::vector<double> velocities_;
+    std::vector<double> forces_;
+    std::vector<int> neighbors_;
+    std::vector<double> neighbor_positions_;
+    double max_displacement_ = 0.0;
+    double average_force_ = 0.0;
+};
@@ -0,0 +1,282 @@
+// render_buffers.cpp
+//
+// Implementation of render_buffers.h.
+
+#include "render_buffers.h"
+#include "tet_centers.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Incidences of the current build, grown once per thread and reused.
+struct RenderScratch {
+    std::vector<double> barycenters;
+    std::vector<int> star_ptr, star;         // point -> tets
+    std::vector<std::pair<int, int>> pairs;  // (b, tet) around the current point a
+    std::vector<int> ring;                   // tets of the current face, in order
+    std::vector<int> ring_others;            // their 2 vertices other than a and b
+    std::vector<int> ordered;
+    std::vector<char> used;
+};
+
+thread_local RenderScratch g_render_scratch;
+
+// Appends vertices to a mesh, as floats or quantized.
+struct Emitter {
+    RenderMesh& mesh;
+    bool quantize;
+    double offset;
+    double scale;
+
+    uint32_t add(const double* p) {
+        const uint32_t index = uint32_t(mesh.num_vertices());
+        for (int c = 0; c < 3; ++c) {
+            if (quantize) {
+                const double q = std::floor((p[c] - offset) / scale * 65535.0 + 0.5);
+                mesh.quantized_positions.push_back(uint16_t(std::min(std::max(q, 0.0), 65535.0)));
+            } else {
+                mesh.positions.push_back(float(p[c]));
+            }
+        }
+        return index;
+    }
+};
+
+// p in the periodic image nearest to ref.
+void unwrap(const double* ref, const double* p, bool is_periodic, double* out) {
+    for (int c = 0; c < 3; ++c) {
+        double value = p[c];
+        if (is_periodic) {
+            const double delta = value - ref[c];
+            if (delta > 0.5) value -= 1.0;
+            else if (delta < -0.5) value += 1.0;
+        }
+        out[c] = value;
+    }
+}
+
+bool tet_has(const int* tet, int v) {
+    return tet[0] == v || tet[1] == v || tet[2] == v || tet[3] == v;
+}
+
+// Orders the m tets around edge (a, b), listed in ring, so that consecutive
+// ones share a triangle. ring_others holds the 2 other vertices of each. An
+// open ring (an edge on the convex hull) starts at one of its ends.
+void order_ring(RenderScratch& s) {
+    const int m = int(s.ring.size());
+    int start = 0;
+    int from = s.ring_others[0];
+    bool open = false;
+    for (int i = 0; i < m && !open; ++i) {
+        for (int side = 0; side < 2 && !open; ++side) {
+            const int v = s.ring_others[size_t(i) * 2 + side];
+            if (std::count(s.ring_others.begin(), s.ring_others.end(), v) == 1) {
+                start = i;
+                from = v;
+                open = true;
+            }
+        }
+    }
+    s.used.assign(size_t(m), 0);
+    std::vector<int>& ordered = s.ordered;
+    ordered.clear();
+    int current = start;
+    while (current >= 0) {
+        s.used[current] = 1;
+        ordered.push_back(s.ring[current]);
+        const int* others = &s.ring_others[size_t(current) * 2];
+        const int to = others[0] == from ? others[1] : others[0];
+        current = -1;
+        for (int j = 0; j < m; ++j) {
+            if (!s.used[j] && (s.ring_others[size_t(j) * 2] == to || s.ring_others[size_t(j) * 2 + 1] == to)) {
+                current = j;
+                from = to;
+                break;
+            }
+        }
+    }
+    // Degenerate rings: the leftovers at the end.
+    for (int j = 0; j < m; ++j) {
+        if (!s.used[j]) {
+            ordered.push_back(s.ring[j]);
+        }
+    }
+    s.ring.swap(ordered);
+}
+
+} // namespace
+
+void build_render_buffers(const double* points, int num_points, const int* tets, int num_tets,
+                          bool is_periodic, bool quantize, TetCenter centers,
+                          RenderBuffers& out) {
+    RenderScratch& s = g_render_scratch;
+    const int n = std::max(num_points, 0);
+    const int T = std::max(num_tets, 0);
+
+    out.delaunay_edges.clear();
+    out.voronoi_edges.clear();
+    out.tets.clear();
+    out.voronoi_faces.clear();
+    out.face_offsets.assign(1, 0);
+    out.face_points.clear();
+    out.quantized = quantize;
+
+    // Voronoi vertices, and point -> tets (each tet once, even with a
+    // repeated vertex)
+    auto first_occurrence = [tets](int t, int k) {
+        const int* tet = &tets[size_t(t) * 4];
+        return std::find(tet, tet + k, tet[k]) == tet + k;
+    };
+    s.barycenters.resize(size_t(T) * 3);
+    compute_tet_centers(points, tets, T, nullptr, is_periodic, centers, s.barycenters.data());
+
+    // Unwrapped primitives stay within half a cube of [0,1). Non-periodic
+    // circumcenters of flat hull tets can lie far outside the box, which
+    // then grows to hold them.
+    double low = is_periodic ? -0.5 : 0.0;
+    double high = is_periodic ? 1.5 : 1.0;
+    if (!is_periodic && centers == TET_CIRCUMCENTER) {
+        for (double c : s.barycenters) {
+            low = std::min(low, c);
+            high = std::max(high, c);
+        }
+    }
+    out.offset = float(low);
+    out.scale = float(high - low);
+    Emitter delaunay_edges = {out.delaunay_edges, quantize, out.offset, out.scale};
+    Emitter voronoi_edges = {out.voronoi_edges, quantize, out.offset, out.scale};
+    Emitter tet_mesh = {out.tets, quantize, out.offset, out.scale};
+    Emitter faces = {out.voronoi_faces, quantize, out.offset, out.scale};
+    s.star_ptr.assign(size_t(n) + 1, 0);
+    for (int t = 0; t < T; ++t) {
+        for (int k = 0; k < 4; ++k) {
+            if (first_occurrence(t, k)) {
+                s.star_ptr[size_t(tets[size_t(t) * 4 + k]) + 1]++;
+            }
+        }
+    }
+    for (int v = 0; v < n; ++v) {
+        s.star_ptr[v + 1] += s.star_ptr[v];
+    }
+    s.star.resize(size_t(s.star_ptr[n]));
+    {
+        std::vector<int> cursor(s.star_ptr.begin(), s.star_ptr.end() - 1);
+        for (int t = 0; t < T; ++t) {
+            for (int k = 0; k < 4; ++k) {
+                if (first_occurrence(t, k)) {
+                    s.star[size_t(cursor[size_t(tets[size_t(t) * 4 + k])]++)] = t;
+                }
+            }
+        }
+    }
+
+    // Tets: 4 unwrapped corners and 4 triangles each.
+    static const int TET_TRIANGLES[4][3] = {{0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3}};
+    for (int t = 0; t < T; ++t) {
+        const int* tet = &tets[size_t(t) * 4];
+        const double* ref = &points[size_t(tet[0]) * 3];
+        uint32_t corner[4];
+        for (int k = 0; k < 4; ++k) {
+            double p[3];
+            unwrap(ref, &points[size_t(tet[k]) * 3], is_periodic, p);
+            corner[k] = tet_mesh.add(p);
+        }
+        for (const int* triangle : TET_TRIANGLES) {
+            out.tets.indices.push_back(corner[triangle[0]]);
+            out.tets.indices.push_back(corner[triangle[1]]);
+            out.tets.indices.push_back(corner[triangle[2]]);
+        }
+    }
+
+    // Delaunay edges (a, b), a < b, and the Voronoi face of each edge of 3+
+    // tets, from the star of a.
+    for (int a = 0; a < n; ++a) {
+        s.pairs.clear();
+        for (int k = s.star_ptr[a]; k < s.star_ptr[a + 1]; ++k) {
+            const int t = s.star[k];
+            for (int j = 0; j < 4; ++j) {
+                const int b = tets[size_t(t) * 4 + j];
+                if (b > a) {
+                    s.pairs.emplace_back(b, t);
+                }
+            }
+        }
+        std::sort(s.pairs.begin(), s.pairs.end());
+        s.pairs.erase(std::unique(s.pairs.begin(), s.pairs.end()), s.pairs.end());
+        const double* pa = &points[size_t(a) * 3];
+        for (size_t first = 0; first < s.pairs.size();) {
+            const int b = s.pairs[first].first;
+            size_t last = first;
+            while (last < s.pairs.size() && s.pairs[last].first == b) {
+                ++last;
+            }
+            double pb[3];
+            unwrap(pa, &points[size_t(b) * 3], is_periodic, pb);
+            delaunay_edges.add(pa);
+            delaunay_edges.add(pb);
+
+            if (last - first >= 3) {
+                s.ring.clear();
+                s.ring_others.clear();
+                for (size_t k = first; k < last; ++k) {
+                    const int t = s.pairs[k].second;
+                    const int* tet = &tets[size_t(t) * 4];
+                    int others[2] = {-1, -1};
+                    for (int j = 0, o = 0; j < 4 && o < 2; ++j) {
+                        if (tet[j] != a && tet[j] != b) {
+                            others[o++] = tet[j];
+                        }
+                    }
+                    s.ring.push_back(t);
+                    s.ring_others.push_back(others[0]);
+                    s.ring_others.push_back(others[1]);
+                }
+                order_ring(s);
+                const double* ref = &s.barycenters[size_t(s.ring[0]) * 3];
+                const uint32_t base = uint32_t(out.voronoi_faces.num_vertices());
+                for (int t : s.ring) {
+                    double p[3];
+                    unwrap(ref, &s.barycenters[size_t(t) * 3], is_periodic, p);
+                    faces.add(p);
+                }
+                for (uint32_t k = 1; k + 1 < uint32_t(s.ring.size()); ++k) {
+                    out.voronoi_faces.indices.push_back(base);
+                    out.voronoi_faces.indices.push_back(base + k);
+                    out.voronoi_faces.indices.push_back(base + k + 1);
+                }
+                out.face_offsets.push_back(int(out.voronoi_faces.indices.size() / 3));
+                out.face_points.push_back(a);
+                out.face_points.push_back(b);
+            }
+            first = last;
+        }
+    }
+
+    // Voronoi edges: tets t < u sharing a triangle that no other tet has.
+    for (int t = 0; t < T; ++t) {
+        const int* tet = &tets[size_t(t) * 4];
+        for (const int* triangle : TET_TRIANGLES) {
+            const int v[3] = {tet[triangle[0]], tet[triangle[1]], tet[triangle[2]]};
+            const int pivot = std::min(v[0], std::min(v[1], v[2]));
+            int match = -1;
+            int matches = 0;
+            for (int k = s.star_ptr[pivot]; k < s.star_ptr[pivot + 1]; ++k) {
+                const int u = s.star[k];
+                const int* other = &tets[size_t(u) * 4];
+                if (u != t && tet_has(other, v[0]) && tet_has(other, v[1]) && tet_has(other, v[2])) {
+                    match = u;
+                    ++matches;
+                }
+            }
+            if (matches == 1 && match > t) {
+                const double* p = &s.barycenters[size_t(t) * 3];
+                double q[3];
+                unwrap(p, &s.barycenters[size_t(match) * 3], is_periodic, q);
+                voronoi_edges.add(p);
+                voronoi_edges.add(q);
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+// render_buffers.h
+//
+// Render-ready geometry of a triangulation: the Delaunay edges, the Voronoi
+// edges and faces of the dual (the Voronoi vertices are the tet barycenters
+// or circumcenters, the `centers` of DelaunayComputation.js) and the tets,
+// as flat vertex and index buffers that upload straight to BufferGeometry
+// attributes.
+// Periodic primitives are unwrapped around their first vertex, the minimum
+// image convention of the demo, so they render without crossing the cube.
+// Positions are Float32, or 16-bit unsigned integers quantized over the box
+// the unwrapped primitives can reach.
+
+#pragma once
+
+#include "tet_centers.h"
+#include <cstdint>
+#include <vector>
+
+struct RenderMesh {
+    // xyz per vertex: floats, or quantized when RenderBuffers::quantized.
+    std::vector<float> positions;
+    std::vector<uint16_t> quantized_positions;
+    // 3 vertex indices per triangle. Empty for line segments, whose vertices
+    // go by pairs.
+    std::vector<uint32_t> indices;
+
+    int num_vertices() const {
+        return int((positions.empty() ? quantized_positions.size() : positions.size()) / 3);
+    }
+
+    void clear() {
+        positions.clear();
+        quantized_positions.clear();
+        indices.clear();
+    }
+};
+
+struct RenderBuffers {
+    RenderMesh delaunay_edges;  // line segments
+    RenderMesh voronoi_edges;   // line segments, between adjacent tets
+    RenderMesh tets;            // 4 vertices and 4 triangles per tet
+    RenderMesh voronoi_faces;   // one polygon per Delaunay edge of 3+ tets, fanned
+    // Triangles of face f: face_offsets[f] to face_offsets[f + 1] - 1. Face f
+    // separates the cells of points face_points[2f] and face_points[2f + 1].
+    std::vector<int> face_offsets;
+    std::vector<int> face_points;
+
+    // Quantized positions decode as offset + scale * q / 65535, i.e. a
+    // normalized Uint16 attribute under an object scaled by scale and
+    // translated by offset on every axis.
+    bool quantized = false;
+    float offset = 0.0f;
+    float scale = 1.0f;
+};
+
+// Builds the four meshes of num_points xyz points and num_tets tets (4 point
+// indices each), with `centers` as the Voronoi vertices, replacing the
+// previous contents of out.
+void build_render_buffers(const double* points, int num_points, const int* tets, int num_tets,
+                          bool is_periodic, bool quantize, TetCenter centers,
+                          RenderBuffers& out);
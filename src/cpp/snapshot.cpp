@@ -0,0 +1,354 @@
+// snapshot.cpp
+//
+// Implementation of snapshot.h.
+
+#include "snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if !defined(__EMSCRIPTEN__) && (defined(__unix__) || defined(__APPLE__))
+#define SNAPSHOT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char MAGIC[8] = {'V', 'C', 'E', 'S', 'N', 'A', 'P', '\0'};
+const size_t HEADER_SIZE = 32;
+
+enum : uint32_t {
+    FLAG_PERIODIC = 1,
+    FLAG_WEIGHTS = 2,
+    FLAG_ADJACENCY = 4,
+    FLAG_SCORES = 8
+};
+
+class Writer {
+public:
+    explicit Writer(std::vector<uint8_t>& out) : out_(out) {
+    }
+
+    void u32(uint32_t value) {
+        for (int k = 0; k < 4; ++k) {
+            out_.push_back(uint8_t(value >> (8 * k)));
+        }
+    }
+
+    void f64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int k = 0; k < 8; ++k) {
+            out_.push_back(uint8_t(bits >> (8 * k)));
+        }
+    }
+
+    void varint(uint32_t value) {
+        while (value >= 0x80) {
+            out_.push_back(uint8_t(value | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(uint8_t(value));
+    }
+
+    void align() {
+        out_.resize((out_.size() + 7) & ~size_t(7), 0);
+    }
+
+    // Reserves a byte count and returns its position for end_varints().
+    size_t begin_varints() {
+        const size_t at = out_.size();
+        u32(0);
+        return at;
+    }
+
+    void end_varints(size_t at) {
+        const uint32_t count = uint32_t(out_.size() - at - 4);
+        for (int k = 0; k < 4; ++k) {
+            out_[at + k] = uint8_t(count >> (8 * k));
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+};
+
+// Bounds-checked cursor over the input bytes.
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data_(data), size_(size) {
+    }
+
+    bool u32(uint32_t& value) {
+        if (size_ - pos_ < 4) return false;
+        value = 0;
+        for (int k = 0; k < 4; ++k) {
+            value |= uint32_t(data_[pos_++]) << (8 * k);
+        }
+        return true;
+    }
+
+    bool f64(double& value) {
+        if (size_ - pos_ < 8) return false;
+        uint64_t bits = 0;
+        for (int k = 0; k < 8; ++k) {
+            bits |= uint64_t(data_[pos_++]) << (8 * k);
+        }
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    // Within [pos_, end).
+    bool varint(size_t end, uint32_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 35 && pos_ < end; shift += 7) {
+            const uint8_t byte = data_[pos_++];
+            value |= uint32_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool align() {
+        const size_t aligned = (pos_ + 7) & ~size_t(7);
+        if (aligned > size_) return false;
+        pos_ = aligned;
+        return true;
+    }
+
+    bool skip_to(size_t pos) {
+        if (pos > size_) return false;
+        pos_ = pos;
+        return true;
+    }
+
+    size_t pos() const {
+        return pos_;
+    }
+
+    size_t remaining() const {
+        return size_ - pos_;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+uint32_t zigzag(int32_t value) {
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+bool adjacency_is_valid(const Snapshot& s) {
+    const int n = s.num_points();
+    if (s.adjacency_rowptr.size() != size_t(n) + 1 || s.adjacency_rowptr[0] != 0 ||
+        s.adjacency_rowptr[n] != int(s.adjacency.size())) {
+        return false;
+    }
+    for (int v = 0; v < n; ++v) {
+        if (s.adjacency_rowptr[v + 1] < s.adjacency_rowptr[v]) return false;
+        for (int k = s.adjacency_rowptr[v]; k < s.adjacency_rowptr[v + 1]; ++k) {
+            const int j = s.adjacency[k];
+            if (j < 0 || j >= n || (k > s.adjacency_rowptr[v] && j <= s.adjacency[k - 1])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool write_snapshot(const Snapshot& snapshot, std::vector<uint8_t>& out) {
+    const int n = snapshot.num_points();
+    const bool has_weights = !snapshot.weights.empty();
+    const bool has_adjacency = !snapshot.adjacency_rowptr.empty();
+    const bool has_scores = !snapshot.scores.empty();
+    if (snapshot.points.size() % 3 != 0 || snapshot.tets.size() % 4 != 0 ||
+        (has_weights && snapshot.weights.size() != size_t(n)) ||
+        (has_adjacency && !adjacency_is_valid(snapshot))) {
+        return false;
+    }
+    for (int v : snapshot.tets) {
+        if (v < 0 || v >= n) return false;
+    }
+
+    out.clear();
+    out.reserve(HEADER_SIZE + snapshot.points.size() * 8 + snapshot.weights.size() * 8 +
+                snapshot.tets.size() * 2 + snapshot.adjacency.size() + snapshot.scores.size() * 4);
+    Writer w(out);
+    out.insert(out.end(), MAGIC, MAGIC + 8);
+    w.u32(SNAPSHOT_VERSION);
+    w.u32((snapshot.is_periodic ? uint32_t(FLAG_PERIODIC) : 0u) |
+          (has_weights ? uint32_t(FLAG_WEIGHTS) : 0u) |
+          (has_adjacency ? uint32_t(FLAG_ADJACENCY) : 0u) |
+          (has_scores ? uint32_t(FLAG_SCORES) : 0u));
+    w.u32(uint32_t(n));
+    w.u32(uint32_t(snapshot.tets.size() / 4));
+    w.u32(uint32_t(snapshot.adjacency.size()));
+    w.u32(uint32_t(snapshot.scores.size()));
+
+    for (double x : snapshot.points) {
+        w.f64(x);
+    }
+    for (double x : snapshot.weights) {
+        w.f64(x);
+    }
+
+    size_t at = w.begin_varints();
+    int previous[4] = {0, 0, 0, 0};
+    for (size_t k = 0; k < snapshot.tets.size(); ++k) {
+        w.varint(zigzag(snapshot.tets[k] - previous[k % 4]));
+        previous[k % 4] = snapshot.tets[k];
+    }
+    w.end_varints(at);
+    w.align();
+
+    if (has_adjacency) {
+        at = w.begin_varints();
+        for (int v = 0; v < n; ++v) {
+            w.varint(uint32_t(snapshot.adjacency_rowptr[v + 1] - snapshot.adjacency_rowptr[v]));
+        }
+        for (int v = 0; v < n; ++v) {
+            int previous_neighbor = 0;
+            for (int k = snapshot.adjacency_rowptr[v]; k < snapshot.adjacency_rowptr[v + 1]; ++k) {
+                w.varint(uint32_t(snapshot.adjacency[k] - previous_neighbor));
+                previous_neighbor = snapshot.adjacency[k];
+            }
+        }
+        w.end_varints(at);
+        w.align();
+    }
+
+    for (int score : snapshot.scores) {
+        w.u32(uint32_t(score));
+    }
+    w.align();
+    return true;
+}
+
+bool read_snapshot(const uint8_t* data, size_t size, Snapshot& out) {
+    Reader r(data, size);
+    uint32_t version, flags, n, num_tets, num_adjacency, num_scores;
+    if (size < HEADER_SIZE || std::memcmp(data, MAGIC, 8) != 0 || !r.skip_to(8) ||
+        !r.u32(version) || version == 0 || version > SNAPSHOT_VERSION || !r.u32(flags) ||
+        !r.u32(n) || !r.u32(num_tets) || !r.u32(num_adjacency) || !r.u32(num_scores)) {
+        return false;
+    }
+    // Each point, tet index and neighbor takes at least a byte: reject the
+    // counts a truncated or corrupted file cannot hold before allocating.
+    const size_t payload = size - HEADER_SIZE;
+    if (size_t(n) > payload / 24 || size_t(num_tets) > payload / 4 ||
+        size_t(num_adjacency) > payload || size_t(num_scores) > payload / 4) {
+        return false;
+    }
+
+    out.is_periodic = (flags & FLAG_PERIODIC) != 0;
+    out.points.resize(size_t(n) * 3);
+    for (double& x : out.points) {
+        if (!r.f64(x)) return false;
+    }
+    out.weights.resize(flags & FLAG_WEIGHTS ? size_t(n) : 0);
+    for (double& x : out.weights) {
+        if (!r.f64(x)) return false;
+    }
+
+    uint32_t bytes;
+    if (!r.u32(bytes) || bytes > r.remaining()) return false;
+    size_t end = r.pos() + bytes;
+    out.tets.resize(size_t(num_tets) * 4);
+    int previous[4] = {0, 0, 0, 0};
+    for (size_t k = 0; k < out.tets.size(); ++k) {
+        uint32_t delta;
+        if (!r.varint(end, delta)) return false;
+        const int v = int(int64_t(previous[k % 4]) + unzigzag(delta));
+        if (v < 0 || v >= int(n)) return false;
+        out.tets[k] = previous[k % 4] = v;
+    }
+    if (!r.skip_to(end) || !r.align()) return false;
+
+    out.adjacency_rowptr.clear();
+    out.adjacency.clear();
+    if (flags & FLAG_ADJACENCY) {
+        if (!r.u32(bytes) || bytes > r.remaining()) return false;
+        end = r.pos() + bytes;
+        out.adjacency_rowptr.assign(size_t(n) + 1, 0);
+        for (uint32_t v = 0; v < n; ++v) {
+            uint32_t length;
+            if (!r.varint(end, length) || length > num_adjacency - uint32_t(out.adjacency_rowptr[v])) {
+                return false;
+            }
+            out.adjacency_rowptr[v + 1] = out.adjacency_rowptr[v] + int(length);
+        }
+        if (uint32_t(out.adjacency_rowptr[n]) != num_adjacency) return false;
+        out.adjacency.resize(num_adjacency);
+        for (uint32_t v = 0; v < n; ++v) {
+            int64_t neighbor = 0;
+            for (int k = out.adjacency_rowptr[v]; k < out.adjacency_rowptr[v + 1]; ++k) {
+                uint32_t gap;
+                if (!r.varint(end, gap)) return false;
+                neighbor += gap;
+                if (neighbor >= int64_t(n)) return false;
+                out.adjacency[k] = int(neighbor);
+            }
+        }
+        if (!r.skip_to(end) || !r.align()) return false;
+    }
+
+    out.scores.resize(flags & FLAG_SCORES ? num_scores : 0);
+    for (int& score : out.scores) {
+        uint32_t value;
+        if (!r.u32(value)) return false;
+        score = int(value);
+    }
+    return true;
+}
+
+bool save_snapshot(const Snapshot& snapshot, const std::string& path) {
+    std::vector<uint8_t> bytes;
+    if (!write_snapshot(snapshot, bytes)) {
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+    return bool(out);
+}
+
+bool load_snapshot(const std::string& path, Snapshot& out) {
+#ifdef SNAPSHOT_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    const size_t size = size_t(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const bool ok = read_snapshot(static_cast<const uint8_t*>(mapping), size, out);
+    munmap(mapping, size);
+    return ok;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return read_snapshot(bytes.data(), bytes.size(), out);
+#endif
+}
@@ -0,0 +1,65 @@
+// snapshot.h
+//
+// Compact binary snapshots of a run: the points, the power weights, the
+// unique tets, the CSR Delaunay graph and the acuteness scores, so that a
+// simulation restarts from a file without triangulating again.
+//
+// Layout, little-endian, version 1:
+//   0   char[8]  "VCESNAP" + NUL
+//   8   uint32   version
+//   12  uint32   flags: 1 periodic, 2 weights, 4 adjacency, 8 scores
+//   16  uint32   num_points
+//   20  uint32   num_tets
+//   24  uint32   num_adjacency (neighbor entries)
+//   28  uint32   num_scores
+//   32  float64  points[3 * num_points]
+//       float64  weights[num_points]                     (flag 2)
+//       uint32   tets byte count, then 4 * num_tets varints: tet index k
+//                minus the same index of the previous tet, zigzag encoded
+//       uint32   adjacency byte count, then varints: the num_points row
+//                lengths, then each sorted row as its first neighbor and the
+//                gaps to the next ones                     (flag 4)
+//       int32    scores[num_scores]                      (flag 8)
+// Every section starts on a multiple of 8 bytes (zero padding), so that the
+// raw arrays of a file mapped in memory are aligned.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct Snapshot {
+    bool is_periodic = true;
+    std::vector<double> points;   // xyz per point
+    std::vector<double> weights;  // one per point, or empty
+    std::vector<int> tets;        // 4 per tet
+    // Delaunay graph as in DelaunayContext::compute_adjacency(), or both
+    // empty.
+    std::vector<int> adjacency_rowptr;
+    std::vector<int> adjacency;
+    std::vector<int> scores;      // or empty
+
+    int num_points() const {
+        return int(points.size() / 3);
+    }
+};
+
+// Serializes snapshot into out (replaced). Returns false if the sections are
+// inconsistent: weights not one per point, an adjacency without num_points + 1
+// row pointers or with unsorted rows, or an index out of range.
+bool write_snapshot(const Snapshot& snapshot, std::vector<uint8_t>& out);
+
+// Decodes size bytes of a snapshot into out. Returns false on a bad magic, a
+// newer version, a truncated section or an index out of range.
+bool read_snapshot(const uint8_t* data, size_t size, Snapshot& out);
+
+// Writes the snapshot to path.
+bool save_snapshot(const Snapshot& snapshot, const std::string& path);
+
+// Reads the snapshot at path, decoding it straight from a memory mapping of
+// the file where available.
+bool load_snapshot(const std::string& path, Snapshot& out);
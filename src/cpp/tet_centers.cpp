@@ -0,0 +1,79 @@
+// tet_centers.cpp
+//
+// Implementation of tet_centers.h.
+
+#include "tet_centers.h"
+#include <cmath>
+#include <cstddef>
+
+namespace {
+
+double wrap(double x) {
+    x -= std::floor(x);
+    return x < 1.0 ? x : 0.0;
+}
+
+// Circumcenter of the tet (0, b, c, d), relative to its first vertex.
+// Returns false if the tet is flat.
+bool circumcenter(const double* b, const double* c, const double* d, double* out) {
+    const double cd[3] = {c[1] * d[2] - c[2] * d[1], c[2] * d[0] - c[0] * d[2],
+                          c[0] * d[1] - c[1] * d[0]};
+    const double db[3] = {d[1] * b[2] - d[2] * b[1], d[2] * b[0] - d[0] * b[2],
+                          d[0] * b[1] - d[1] * b[0]};
+    const double bc[3] = {b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2],
+                          b[0] * c[1] - b[1] * c[0]};
+    const double det = b[0] * cd[0] + b[1] * cd[1] + b[2] * cd[2];
+    const double b2 = b[0] * b[0] + b[1] * b[1] + b[2] * b[2];
+    const double c2 = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+    const double d2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    // Relative to the scale of the tet, so that small tets are not flat.
+    const double scale = std::sqrt(std::fmax(b2, std::fmax(c2, d2)));
+    if (!(std::fabs(det) > 1e-12 * scale * scale * scale)) {
+        return false;
+    }
+    const double inv = 0.5 / det;
+    for (int k = 0; k < 3; ++k) {
+        out[k] = (b2 * cd[k] + c2 * db[k] + d2 * bc[k]) * inv;
+    }
+    return true;
+}
+
+} // namespace
+
+void compute_tet_centers(const double* points, const int* tets, int num_tets,
+                         const int8_t* translations, bool is_periodic, TetCenter kind,
+                         double* out) {
+    for (int t = 0; t < num_tets; ++t) {
+        const int* tet = &tets[size_t(t) * 4];
+        const double* a = &points[size_t(tet[0]) * 3];
+        // The other vertices, relative to the first one.
+        double rel[3][3];
+        for (int k = 1; k < 4; ++k) {
+            const double* p = &points[size_t(tet[k]) * 3];
+            for (int c = 0; c < 3; ++c) {
+                double delta = p[c] - a[c];
+                if (is_periodic) {
+                    if (translations) {
+                        delta += double(translations[size_t(t) * 12 + k * 3 + c]);
+                    } else if (delta > 0.5) {
+                        delta -= 1.0;
+                    } else if (delta < -0.5) {
+                        delta += 1.0;
+                    }
+                }
+                rel[k - 1][c] = delta;
+            }
+        }
+
+        double center[3];
+        if (kind != TET_CIRCUMCENTER || !circumcenter(rel[0], rel[1], rel[2], center)) {
+            for (int c = 0; c < 3; ++c) {
+                center[c] = (rel[0][c] + rel[1][c] + rel[2][c]) / 4;
+            }
+        }
+        double* result = &out[size_t(t) * 3];
+        for (int c = 0; c < 3; ++c) {
+            result[c] = is_periodic ? wrap(a[c] + center[c]) : a[c] + center[c];
+        }
+    }
+}
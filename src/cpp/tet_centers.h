@@ -0,0 +1,25 @@
+// tet_centers.h
+//
+// Voronoi vertices of a triangulation: the barycenter or the circumcenter of
+// every tet, computed in one pass over flat arrays. Periodic tets are first
+// unwrapped into one copy of the cube, from the translations of
+// compute_unique_tets() when available, else by the minimum image convention
+// around their first vertex as DelaunayComputation.js does, and the centers
+// are wrapped back into [0,1).
+
+#pragma once
+
+#include <cstdint>
+
+enum TetCenter {
+    TET_BARYCENTER = 0,
+    TET_CIRCUMCENTER = 1  // the true Voronoi vertex of a Delaunay tet
+};
+
+// Writes 3 coordinates per tet to out, for num_tets tets of 4 indices into
+// the xyz points. translations, if not null, holds 12 lattice offsets per
+// tet (see compute_unique_tets()). A flat tet, whose circumcenter is not
+// defined, gets its barycenter.
+void compute_tet_centers(const double* points, const int* tets, int num_tets,
+                         const int8_t* translations, bool is_periodic, TetCenter kind,
+                         double* out);
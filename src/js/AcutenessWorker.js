@@ -5,7 +5,8 @@
  * Offloads heavy angle calculations from the main thread
  */
 
-// Import the calculation functions (we'll need to inline them since workers can't import modules easily)
+// Runs as a module worker so that it can share the task ring with WorkerManager
+import { SharedTaskRing, runRingWorker, TASK_CELL, TASK_FACE, TASK_VERTEX } from './SharedTaskRing.js';
 
 /**
  * Calculate squared distance between two points (faster than actual distance)
@@ -274,6 +275,148 @@ function processTetraChunk(tetraChunk, points, maxScore) {
     };
 }
 
+/**
+ * Cell acuteness over the shared geometry: writes the score of every cell in
+ * [begin, end) into geometry.cellScores. Same metric as processCellChunk, with
+ * the acute test done on the sign of the dot product.
+ */
+function processSharedCells(geometry, begin, end, maxScore) {
+    const { cellPtr, cellVertices, cellScores } = geometry;
+    const order = [];
+    const distSq = [];
+    
+    for (let c = begin; c < end; c++) {
+        const first = cellPtr[c];
+        const count = cellPtr[c + 1] - first;
+        if (count < 4) {
+            cellScores[c] = 0;
+            continue;
+        }
+        
+        let acuteAngles = 0;
+        for (let i = 0; i < count; i++) {
+            const ci = 3 * (first + i);
+            const cx = cellVertices[ci], cy = cellVertices[ci + 1], cz = cellVertices[ci + 2];
+            
+            // Other vertices sorted by distance (stable, ties keep cell order)
+            order.length = 0;
+            for (let j = 0; j < count; j++) {
+                if (j === i) continue;
+                const cj = 3 * (first + j);
+                const dx = cellVertices[cj] - cx, dy = cellVertices[cj + 1] - cy, dz = cellVertices[cj + 2] - cz;
+                distSq[j] = dx * dx + dy * dy + dz * dz;
+                order.push(j);
+            }
+            order.sort((a, b) => distSq[a] - distSq[b]);
+            
+            const maxNeighbors = Math.min(6, order.length);
+            for (let j = 0; j < maxNeighbors; j++) {
+                const a = 3 * (first + order[j]);
+                const ax = cellVertices[a] - cx, ay = cellVertices[a + 1] - cy, az = cellVertices[a + 2] - cz;
+                for (let k = j + 1; k < maxNeighbors; k++) {
+                    const b = 3 * (first + order[k]);
+                    const bx = cellVertices[b] - cx, by = cellVertices[b + 1] - cy, bz = cellVertices[b + 2] - cz;
+                    if (ax * bx + ay * by + az * bz > 0 || distSq[order[j]] === 0 || distSq[order[k]] === 0) {
+                        acuteAngles++;
+                    }
+                }
+            }
+        }
+        
+        cellScores[c] = Math.min(Math.round(acuteAngles / count), maxScore);
+    }
+}
+
+/**
+ * Face acuteness over the shared geometry (interior polygon angles)
+ */
+function processSharedFaces(geometry, begin, end, maxScore) {
+    const { facePtr, faceVertices, faceScores } = geometry;
+    
+    for (let f = begin; f < end; f++) {
+        const first = facePtr[f];
+        const count = facePtr[f + 1] - first;
+        let acuteAngles = 0;
+        
+        for (let j = 0; count >= 3 && j < count; j++) {
+            const prev = 3 * (first + (j - 1 + count) % count);
+            const curr = 3 * (first + j);
+            const next = 3 * (first + (j + 1) % count);
+            const ax = faceVertices[prev] - faceVertices[curr];
+            const ay = faceVertices[prev + 1] - faceVertices[curr + 1];
+            const az = faceVertices[prev + 2] - faceVertices[curr + 2];
+            const bx = faceVertices[next] - faceVertices[curr];
+            const by = faceVertices[next + 1] - faceVertices[curr + 1];
+            const bz = faceVertices[next + 2] - faceVertices[curr + 2];
+            const dot = ax * bx + ay * by + az * bz;
+            if (dot > 0 || ax * ax + ay * ay + az * az === 0 || bx * bx + by * by + bz * bz === 0) {
+                acuteAngles++;
+            }
+        }
+        
+        faceScores[f] = Math.min(acuteAngles, maxScore);
+    }
+}
+
+/**
+ * Vertex (tetrahedron corner) acuteness over the shared geometry
+ */
+function processSharedTetrahedra(geometry, begin, end, maxScore) {
+    const { tets, points, vertexScores } = geometry;
+    const edges = new Float64Array(9);
+    
+    for (let t = begin; t < end; t++) {
+        let acuteAngles = 0;
+        for (let j = 0; j < 4; j++) {
+            const c = 3 * tets[4 * t + j];
+            let e = 0;
+            for (let k = 0; k < 4; k++) {
+                if (k === j) continue;
+                const o = 3 * tets[4 * t + k];
+                edges[e++] = points[o] - points[c];
+                edges[e++] = points[o + 1] - points[c + 1];
+                edges[e++] = points[o + 2] - points[c + 2];
+            }
+            for (const [a, b] of [[0, 3], [3, 6], [6, 0]]) {
+                const dot = edges[a] * edges[b] + edges[a + 1] * edges[b + 1] + edges[a + 2] * edges[b + 2];
+                const lenA = edges[a] * edges[a] + edges[a + 1] * edges[a + 1] + edges[a + 2] * edges[a + 2];
+                const lenB = edges[b] * edges[b] + edges[b + 1] * edges[b + 1] + edges[b + 2] * edges[b + 2];
+                if (dot > 0 || lenA === 0 || lenB === 0) {
+                    acuteAngles++;
+                }
+            }
+        }
+        vertexScores[t] = Math.min(acuteAngles, maxScore);
+    }
+}
+
+/**
+ * Drain the shared task ring: the geometry and score arrays are views over
+ * SharedArrayBuffers owned by the manager, so nothing is copied per task
+ */
+function runSharedRing(data) {
+    const startTime = performance.now();
+    const ring = SharedTaskRing.fromBuffers(data.ring);
+    const geometry = {};
+    for (const [name, buffer] of Object.entries(data.geometry)) {
+        geometry[name] = buffer.type === 'Float64' ? new Float64Array(buffer.buffer) : new Int32Array(buffer.buffer);
+    }
+    const maxScore = data.maxScore;
+    
+    const processed = runRingWorker(ring, data.workerId, (kind, begin, end) => {
+        if (kind === TASK_CELL) processSharedCells(geometry, begin, end, maxScore);
+        else if (kind === TASK_FACE) processSharedFaces(geometry, begin, end, maxScore);
+        else if (kind === TASK_VERTEX) processSharedTetrahedra(geometry, begin, end, maxScore);
+    });
+    
+    return {
+        metrics: {
+            duration: performance.now() - startTime,
+            itemsProcessed: processed
+        }
+    };
+}
+
 // Worker message handler
 self.onmessage = function(e) {
     const { type, data } = e.data;
@@ -294,6 +437,10 @@ self.onmessage = function(e) {
                 result = processTetraChunk(data.tetraChunk, data.points, data.maxScore);
                 break;
                 
+            case 'SHARED_RING':
+                result = runSharedRing(data);
+                break;
+                
             default:
                 throw new Error(`Unknown worker task type: ${type}`);
         }
@@ -5,6 +5,315 @@
  * and provides a clean API for Delaunay triangulation and Voronoi diagram computation.
  */
 
+import { permuteArray } from './SpatialOrder.js';
+import { DelaunayComputation2d, releaseDelaunayContexts2d } from './DelaunayComputation2d.js';
+
+// Persistent WASM triangulation contexts, one per module and periodicity.
+// Reusing them across frames keeps the C++ side's buffers allocated.
+const delaunayContexts = new WeakMap();
+
+// Full triangulations since the last sort_points_spatially(), per context.
+const framesSinceSpatialSort = new WeakMap();
+
+// Last JS copy of each context's Delaunay graph: { version, adjacency }.
+// The graph survives incremental updates, so most frames reuse the copy.
+const adjacencyCopies = new WeakMap();
+
+// Persistent kd-tree neighbor indices, one per module and periodicity.
+const neighborIndices = new WeakMap();
+
+// Persistent DelaunayBatch sweep engines, one per module and periodicity.
+const delaunayBatches = new WeakMap();
+
+// Lazy analysis caches (AnalysisCache), one per persistent context.
+const analysisCaches = new WeakMap();
+
+// Console verbosity, as the WASM module's log_level() (see delaunay_core.h).
+const LOG_ERRORS = 1;
+const LOG_INFO = 2;
+const LOG_DEBUG = 3;
+
+/**
+ * The WASM module's log level, LOG_ERRORS when it has none.
+ * @param {Object} wasmModule - The loaded WASM module, or null
+ * @returns {number}
+ */
+function moduleLogLevel(wasmModule) {
+    return wasmModule && typeof wasmModule.log_level === 'function' ? wasmModule.log_level() : LOG_ERRORS;
+}
+
+/**
+ * The persistent triangulation context of a WASM module for a periodicity,
+ * created on first use. Holds the points and tets of the last compute()
+ * @param {Object} wasmModule - The loaded WASM module
+ * @param {boolean} isPeriodic
+ */
+export function getDelaunayContext(wasmModule, isPeriodic) {
+    let contexts = delaunayContexts.get(wasmModule);
+    if (!contexts) {
+        contexts = {};
+        delaunayContexts.set(wasmModule, contexts);
+    }
+    const key = isPeriodic ? 'periodic' : 'nonPeriodic';
+    if (!contexts[key]) {
+        contexts[key] = new wasmModule.DelaunayContext(isPeriodic);
+    }
+    return contexts[key];
+}
+
+/**
+ * The persistent k-NN / radius index (NeighborIndex) of a WASM module for a
+ * periodicity, created on first use
+ * @param {Object} wasmModule - The loaded WASM module
+ * @param {boolean} isPeriodic
+ */
+export function getPersistentNeighborIndex(wasmModule, isPeriodic) {
+    let indices = neighborIndices.get(wasmModule);
+    if (!indices) {
+        indices = {};
+        neighborIndices.set(wasmModule, indices);
+    }
+    const key = isPeriodic ? 'periodic' : 'nonPeriodic';
+    if (!indices[key]) {
+        indices[key] = new wasmModule.NeighborIndex(isPeriodic);
+    }
+    return indices[key];
+}
+
+/**
+ * The lazy analysis cache (AnalysisCache) of the persistent context of a
+ * WASM module for a periodicity, created on first use: vertex / face / cell
+ * / edge scores computed when read and kept until an update moves their
+ * tets. See DelaunayComputation.getAnalysisCache()
+ * @param {Object} wasmModule - The loaded WASM module
+ * @param {boolean} isPeriodic
+ * @returns {Object|null} AnalysisCache, or null if the module has none
+ */
+export function getAnalysisCache(wasmModule, isPeriodic) {
+    if (!wasmModule || typeof wasmModule.AnalysisCache !== 'function') {
+        return null;
+    }
+    const context = getDelaunayContext(wasmModule, isPeriodic);
+    let cache = analysisCaches.get(context);
+    if (!cache) {
+        cache = new wasmModule.AnalysisCache(context);
+        analysisCaches.set(context, cache);
+    }
+    return cache;
+}
+
+/**
+ * A computation of the given dimension on the same points and options:
+ * DelaunayComputation for 3 (xyz points), DelaunayComputation2d for 2 (xy
+ * points, on the WASM DelaunayContext2d)
+ * @param {Array|Float64Array} points
+ * @param {boolean} isPeriodic
+ * @param {number} dimension - 2 or 3
+ */
+export function createDelaunayComputation(points, isPeriodic = true, dimension = 3) {
+    return dimension === 2 ? new DelaunayComputation2d(points, isPeriodic)
+                           : new DelaunayComputation(points, isPeriodic);
+}
+
+/**
+ * Free the persistent triangulation contexts (2D ones included), their
+ * analysis caches and the neighbor indices created for a WASM module
+ * @param {Object} wasmModule - The loaded WASM module
+ */
+export function releaseDelaunayContexts(wasmModule) {
+    const contexts = delaunayContexts.get(wasmModule);
+    if (contexts) {
+        for (const context of Object.values(contexts)) {
+            // A cache reads its context: free it first
+            const cache = analysisCaches.get(context);
+            if (cache) {
+                cache.release();
+                cache.delete();
+                analysisCaches.delete(context);
+            }
+            context.destroy();
+            context.delete();
+        }
+        delaunayContexts.delete(wasmModule);
+    }
+    const indices = neighborIndices.get(wasmModule);
+    if (indices) {
+        for (const index of Object.values(indices)) {
+            index.delete();
+        }
+        neighborIndices.delete(wasmModule);
+    }
+    const batches = delaunayBatches.get(wasmModule);
+    if (batches) {
+        for (const batch of Object.values(batches)) {
+            batch.release();
+            batch.delete();
+        }
+        delaunayBatches.delete(wasmModule);
+    }
+    releaseDelaunayContexts2d(wasmModule);
+}
+
+/**
+ * Triangulate several point sets in one WASM call, for parameter sweeps. The
+ * sets are packed into one buffer with offsets and run by the module's
+ * persistent DelaunayBatch, in which each job keeps its own pooled context:
+ * sweeping again over the same configurations reuses their buffers, and
+ * with incremental updates their triangulations.
+ * @param {Object} wasmModule - The loaded WASM module
+ * @param {Array} pointSets - Point sets, each flat xyz (array or typed array)
+ *     or [[x, y, z], ...]
+ * @param {boolean} isPeriodic
+ * @param {Object} options - { scores: also score the Voronoi cells,
+ *                             maxNeighbors: for the scores (default 6),
+ *                             incremental, maxDisplacement: as compute() }
+ * @returns {Array} One { ok, tets: Int32Array (4 indices per tet, local to
+ *     the set), scores: Int32Array (one per point) or null, stats } per set
+ */
+export function computeBatch(wasmModule, pointSets, isPeriodic, options = {}) {
+    if (!wasmModule || typeof wasmModule.DelaunayBatch !== 'function') {
+        throw new Error('Batches need the WASM DelaunayBatch');
+    }
+    const flatSets = pointSets.map(set =>
+        Array.isArray(set) && Array.isArray(set[0]) ? set.flat() : set);
+    const offsets = new Int32Array(flatSets.length + 1);
+    flatSets.forEach((set, j) => {
+        offsets[j + 1] = offsets[j] + Math.floor(set.length / 3);
+    });
+    const points = new Float64Array(offsets[flatSets.length] * 3);
+    flatSets.forEach((set, j) => {
+        const base = offsets[j] * 3;
+        for (let k = 0; k < (offsets[j + 1] - offsets[j]) * 3; k++) {
+            points[base + k] = set[k];
+        }
+    });
+
+    let batches = delaunayBatches.get(wasmModule);
+    if (!batches) {
+        batches = {};
+        delaunayBatches.set(wasmModule, batches);
+    }
+    const key = isPeriodic ? 'periodic' : 'nonPeriodic';
+    if (!batches[key]) {
+        batches[key] = new wasmModule.DelaunayBatch(isPeriodic);
+    }
+    const batch = batches[key];
+    if (batch.compute(points, offsets, options) < 0) {
+        throw new Error('Delaunay batch failed');
+    }
+
+    // One copy of each packed array, then per-set subarrays of it
+    const tetOffsets = batch.tet_offsets().slice();
+    const tets = batch.tets().slice();
+    const scores = options.scores ? batch.scores().slice() : null;
+    const jobOk = batch.job_ok().slice();
+    return flatSets.map((set, j) => ({
+        ok: jobOk[j] === 1,
+        tets: tets.subarray(tetOffsets[j] * 4, tetOffsets[j + 1] * 4),
+        scores: scores ? scores.subarray(offsets[j], offsets[j + 1]) : null,
+        stats: batch.job_stats(j)
+    }));
+}
+
+// Hands control back to the event loop between two streamed chunks.
+function nextTask() {
+    return new Promise(resolve => setTimeout(resolve, 0));
+}
+
+/**
+ * Triangulate in the persistent context and deliver the result in chunks,
+ * for inputs too large to copy out in one piece. Yields
+ *   { kind: 'tets', first, count, total, tets }: tets first to
+ *       first + count - 1, an Int32Array view of one reusable WASM buffer
+ *   { kind: 'cells', first, count, total, cells }: the Voronoi cells of
+ *       points first to first + count - 1, unpacked as computation.voronoiCellData
+ *       (cell k is point first + k), if voronoiCells
+ * and yields to the event loop after each chunk, so rendering or analysis
+ * can start on the first ones. Views are only valid until the generator
+ * resumes: copy what must be kept. JS memory stays bounded by the chunk
+ * sizes instead of the point count.
+ * @param {Object} wasmModule - The loaded WASM module
+ * @param {Float64Array|number[]} points - Flat xyz coordinates
+ * @param {boolean} isPeriodic
+ * @param {Object} options - { incremental, maxDisplacement: as compute(),
+ *                             voronoiCells: also stream the cells,
+ *                             chunkSize: tets per chunk,
+ *                             cellChunkSize: cells per chunk }
+ */
+export async function* streamTriangulation(wasmModule, points, isPeriodic, options = {}) {
+    const {
+        incremental = false,
+        maxDisplacement = 0.05,
+        voronoiCells = false,
+        chunkSize = 65536,
+        cellChunkSize = 4096
+    } = options;
+    if (!wasmModule || typeof wasmModule.DelaunayContext !== 'function') {
+        throw new Error('Streaming needs the WASM DelaunayContext');
+    }
+    const context = getDelaunayContext(wasmModule, isPeriodic);
+    context.update_points(points instanceof Float64Array ? points : new Float64Array(points));
+    if (context.is_weighted()) {
+        context.clear_weights();
+    }
+    const tetsView = incremental ? context.compute_incremental(maxDisplacement) : context.compute();
+    if (!tetsView) {
+        throw new Error('Delaunay triangulation failed');
+    }
+
+    const numTets = tetsView.length / 4;
+    for (let first = 0; first < numTets; first += chunkSize) {
+        const tets = context.tets_chunk(first, chunkSize);
+        yield { kind: 'tets', first, count: tets.length / 4, total: numTets, tets };
+        await nextTask();
+    }
+
+    if (!voronoiCells) return;
+    const numPoints = context.num_points();
+    for (let first = 0; first < numPoints; first += cellChunkSize) {
+        const count = Math.min(cellChunkSize, numPoints - first);
+        const cells = unpackVoronoiCells(
+            context.compute_voronoi_cells_range(first, count), context.voronoi_cell_vertices());
+        if (!cells) {
+            throw new Error('Voronoi cell extraction failed');
+        }
+        yield { kind: 'cells', first, count, total: numPoints, cells };
+        await nextTask();
+    }
+}
+
+/**
+ * Split the packed Int32Array returned by compute_voronoi_cells() into
+ * its sections. Both views alias WASM memory, so the sections are copied.
+ */
+function unpackVoronoiCells(packed, vertices) {
+    if (!packed) return null;
+    const numCells = packed[0];
+    const numFaces = packed[1];
+    let offset = 3;
+    const take = (length) => {
+        const section = packed.slice(offset, offset + length);
+        offset += length;
+        return section;
+    };
+    const cellVertexPtr = take(numCells + 1);
+    const cellFacePtr = take(numCells + 1);
+    const facePtr = take(numFaces + 1);
+    const faceNeighbor = take(numFaces);
+    const faceVertices = take(facePtr[numFaces]);
+    return {
+        numCells,
+        numFaces,
+        numVertices: packed[2],
+        vertices: new Float64Array(vertices), // xyz triplets
+        cellVertexPtr,
+        cellFacePtr,
+        facePtr,
+        faceNeighbor,
+        faceVertices
+    };
+}
+
 export class DelaunayComputation {
     constructor(points, isPeriodic = true) {
         // Convert points to flat array if needed
@@ -41,13 +350,28 @@ export class DelaunayComputation {
         
         // Results will be stored here
         this.tetrahedra = [];
+        this.tetrahedraFlat = null; // Int32Array, 4 indices per tet (zero-copy path only)
+        this.lastUpdateIncremental = false; // true when the context reused its previous triangulation
         this.voronoiEdges = [];
         this.voronoiCells = [];
+        this.voronoiCellData = null; // packed circumcentric cells (WASM DelaunayContext only)
+        this.changedCells = null; // Int32Array of cells changed by the last update, null = unknown
+        this.adjacency = null; // { rowptr, colidx } Delaunay graph from the WASM context, see getAdjacency()
+        this.frameArena = null; // WASM scratch arena usage in bytes { used, high_water_mark, capacity, blocks }
+        this.wasmStats = null; // counters and stage timings of the last WASM call (see last_stats())
+        this.permutation = null; // Int32Array new -> old index if this compute() reordered the points, else null
+        this.weights = null; // Float64Array of power weights of the last weighted compute(), else null
+        this.tetTranslations = null; // Int8Array, xyz lattice shift of each tet vertex from the first (12 per tet)
+        this.contextVersion = null; // update_version() of the persistent context after this compute()
         this.barycenters = [];
+        this.centers = 'barycenter'; // kind of Voronoi vertex in this.barycenters: 'barycenter' or 'circumcenter'
+        this.logLevel = LOG_ERRORS; // console verbosity of the last compute(), the module's log_level()
         
         // Simple caching for performance
         this._facesCache = null;
         this._cellsCache = null;
+        this._adjacencyCache = null;
+        this._renderBuffersCache = null;
     }
 
     /**
@@ -57,58 +381,213 @@ export class DelaunayComputation {
     _invalidateCaches() {
         this._facesCache = null;
         this._cellsCache = null;
+        this._adjacencyCache = null;
     }
 
     /**
      * Main method to run the computation
      * @param {Object} wasmModule - The loaded WASM module
+     * @param {Object} options - { incremental: try to update the previous triangulation,
+     *                             maxDisplacement: largest per-point move accepted incrementally,
+     *                             voronoiCells: also extract the true Voronoi cells in WASM,
+     *                             spatialOrder: lay the points out in the context's BRIO/Hilbert
+     *                                 order (see this.permutation),
+     *                             spatialOrderRefresh: re-sort after that many full
+     *                                 triangulations, 0 = only when the point count changes,
+     *                             weights: one power weight per point (persistent context
+     *                                 only): regular triangulation and Laguerre cells, for
+     *                                 the power distance |x - p|^2 - w,
+     *                             translations: also keep the periodic translation of
+     *                                 every tet vertex (persistent context only, see
+     *                                 this.tetTranslations),
+     *                             centers: 'barycenter' (default) or 'circumcenter', the
+     *                                 Voronoi vertex of each tet in this.barycenters;
+     *                                 circumcenters need the native kernel,
+     *                             lowMemory: free the context's construction buffers and
+     *                                 the stores this call's queries do not read after
+     *                                 the triangulation (persistent context only); the
+     *                                 bytes it keeps are wasmStats.retained_bytes }
      * @returns {DelaunayComputation} - Returns this for chaining
      */
-    async compute(wasmModule) {
+    async compute(wasmModule, options = {}) {
+        const {
+            incremental = false,
+            maxDisplacement = 0.05,
+            voronoiCells = false,
+            spatialOrder = false,
+            spatialOrderRefresh = 0,
+            weights = null,
+            translations = false,
+            centers = 'barycenter',
+            lowMemory = false
+        } = options;
         if (!wasmModule) {
             throw new Error('WASM module not provided');
         }
         
-        console.log(`Computing Delaunay triangulation for ${this.numPoints} points (${this.isPeriodic ? 'periodic' : 'non-periodic'})...`);
+        this.logLevel = moduleLogLevel(wasmModule);
+        if (this.logLevel >= LOG_INFO) {
+            console.log(`Computing Delaunay triangulation for ${this.numPoints} points (${this.isPeriodic ? 'periodic' : 'non-periodic'})...`);
+        }
         
         // Clear caches since we're recomputing
         this._invalidateCaches();
         
-        // Debug: Log the first few points
-        console.log('First 3 points:', this.pointsArray.slice(0, 3));
-        
         try {
-            // Call the WASM compute_delaunay function
-            console.log('Calling WASM with:', {
-                pointsLength: this.points.length,
-                numPoints: this.numPoints,
-                isPeriodic: this.isPeriodic
-            });
             
-            const rawResult = wasmModule.compute_delaunay(this.points, this.numPoints, this.isPeriodic);
+            let rawCount = 0;
+            this.lastUpdateIncremental = false;
+            this.voronoiCellData = null;
+            this.changedCells = null;
+            this.adjacency = null;
+            this.permutation = null;
+            this.tetTranslations = null;
+            this.contextVersion = null;
+            this.weights = weights ? new Float64Array(weights) : null;
+            if (this.weights && typeof wasmModule.DelaunayContext !== 'function') {
+                if (this.logLevel >= LOG_ERRORS) console.warn('Weights need the WASM DelaunayContext; computing unweighted');
+                this.weights = null;
+            }
+            if (typeof wasmModule.DelaunayContext === 'function' ||
+                typeof wasmModule.compute_delaunay_buffer === 'function') {
+                let tetsView;
+                if (typeof wasmModule.DelaunayContext === 'function') {
+                    // Persistent context: the triangulation state survives between frames
+                    const context = getDelaunayContext(wasmModule, this.isPeriodic);
+                    context.update_points(this.points);
+                    if (this.weights && typeof context.update_weights === 'function') {
+                        // A weight change is handled by compute_incremental like a move
+                        context.update_weights(this.weights);
+                    } else if (typeof context.is_weighted === 'function' && context.is_weighted()) {
+                        context.clear_weights();
+                    }
+                    if (spatialOrder && typeof context.sort_points_spatially === 'function') {
+                        this._sortPointsSpatially(context, spatialOrderRefresh);
+                    }
+                    if (typeof context.set_keeps_tet_translations === 'function') {
+                        context.set_keeps_tet_translations(translations);
+                    }
+                    if (typeof context.set_low_memory === 'function') {
+                        // The adjacency is always copied below, and PhysicsStepper reads the neighbors
+                        context.set_low_memory(lowMemory, { neighbors: true, voronoiCells, incremental });
+                    }
+                    if (incremental && typeof context.compute_incremental === 'function') {
+                        // Kinetic update: keeps the previous tets if the moved points stay valid
+                        tetsView = context.compute_incremental(maxDisplacement);
+                        this.lastUpdateIncremental = context.last_update_was_incremental();
+                    } else {
+                        tetsView = context.compute();
+                    }
+                    if (!this.lastUpdateIncremental && framesSinceSpatialSort.has(context)) {
+                        framesSinceSpatialSort.set(context, framesSinceSpatialSort.get(context) + 1);
+                    }
+                    if (tetsView && typeof context.update_version === 'function') {
+                        this.contextVersion = context.update_version();
+                    }
+                    if (tetsView && translations && typeof context.tet_translations === 'function') {
+                        this.tetTranslations = new Int8Array(context.tet_translations());
+                    }
+                    if (tetsView && typeof context.changed_cells === 'function') {
+                        this.changedCells = new Int32Array(context.changed_cells());
+                    }
+                    if (tetsView && typeof context.compute_adjacency === 'function') {
+                        this.adjacency = this._copyAdjacency(context);
+                    }
+                    if (voronoiCells && tetsView && typeof context.compute_voronoi_cells === 'function') {
+                        this.voronoiCellData = unpackVoronoiCells(
+                            context.compute_voronoi_cells(), context.voronoi_cell_vertices());
+                    }
+                } else {
+                    // Zero-copy path: write the coordinates into the module-owned buffer
+                    // and read the tets back as one flat Int32Array
+                    const pointsView = wasmModule.get_points_buffer(this.numPoints);
+                    pointsView.set(this.points);
+                    tetsView = wasmModule.compute_delaunay_buffer(this.numPoints, this.isPeriodic);
+                }
+                
+                // The view aliases WASM memory and is reused by the next call, so keep a copy
+                this.tetrahedraFlat = tetsView ? new Int32Array(tetsView) : new Int32Array(0);
+                rawCount = this.tetrahedraFlat.length / 4;
+                this.tetrahedra = this._filterTetrahedraFlat(this.tetrahedraFlat);
+            } else {
+                const rawResult = wasmModule.compute_delaunay(this.points, this.numPoints, this.isPeriodic);
+                rawCount = rawResult ? rawResult.length : 0;
+                this.tetrahedra = rawCount > 0 ? this._filterTetrahedra(rawResult) : [];
+            }
+            
+            if (typeof wasmModule.frame_arena_stats === 'function') {
+                this.frameArena = wasmModule.frame_arena_stats();
+            }
+            if (typeof wasmModule.last_stats === 'function') {
+                this.wasmStats = wasmModule.last_stats();
+            }
             
-            console.log('WASM returned:', rawResult ? `${rawResult.length} tetrahedra` : 'null/undefined');
+            if (this.logLevel >= LOG_INFO) {
+                console.log(`WASM returned: ${rawCount} tetrahedra${this.lastUpdateIncremental ? ' (incremental)' : ''}`);
+            }
             
-            if (rawResult && rawResult.length > 0) {
-                // Filter and convert the raw results
-                this.tetrahedra = this._filterTetrahedra(rawResult);
-                console.log(`Computed ${this.tetrahedra.length} valid tetrahedra (filtered from ${rawResult.length})`);
+            if (this.tetrahedra.length > 0) {
+                if (this.logLevel >= LOG_INFO) {
+                    console.log(`Computed ${this.tetrahedra.length} valid tetrahedra (filtered from ${rawCount})`);
+                }
                 
                 // Compute Voronoi diagram from Delaunay
-                this._computeVoronoiBarycentric();
+                this._computeVoronoiBarycentric(wasmModule, centers);
             } else {
-                console.warn('No tetrahedra generated');
+                if (this.logLevel >= LOG_ERRORS) console.warn('No tetrahedra generated');
                 this.tetrahedra = [];
                 this.voronoiEdges = [];
             }
         } catch (error) {
-            console.error('Error in Delaunay computation:', error);
+            if (this.logLevel >= LOG_ERRORS) console.error('Error in Delaunay computation:', error);
             throw error;
         }
         
         return this; // Allow chaining
     }
 
+    /**
+     * Sort the context's points spatially when the previous order no longer
+     * applies (first frame, point count changed) or is due for a refresh, and
+     * reorder this computation's points to match. Between sorts the context
+     * reuses the BRIO levels, so the Hilbert sort is paid once and not per
+     * frame. Callers holding per-point state must apply this.permutation.
+     * @private
+     */
+    _sortPointsSpatially(context, refresh) {
+        const due = !context.points_spatially_sorted() ||
+            (refresh > 0 && framesSinceSpatialSort.get(context) >= refresh);
+        if (!due || !context.sort_points_spatially()) return;
+        framesSinceSpatialSort.set(context, 0);
+        this.permutation = new Int32Array(context.spatial_order());
+        this.points = permuteArray(this.points, this.permutation, 3);
+        this.pointsArray = permuteArray(this.pointsArray, this.permutation);
+        if (this.weights) {
+            this.weights = permuteArray(this.weights, this.permutation);
+        }
+        if (this.logLevel >= LOG_INFO) console.log(`Reordered ${this.numPoints} points spatially`);
+    }
+
+    /**
+     * Copy the context's Delaunay graph unless the previous copy is still
+     * current (same adjacency_version). Copies are shared between
+     * computations and must not be modified.
+     * @private
+     */
+    _copyAdjacency(context) {
+        const rowptrView = context.compute_adjacency();
+        if (!rowptrView) return null;
+        const version = context.adjacency_version();
+        const copy = adjacencyCopies.get(context);
+        if (copy && copy.version === version) return copy.adjacency;
+        const adjacency = {
+            rowptr: new Int32Array(rowptrView),
+            colidx: new Int32Array(context.adjacency_colidx())
+        };
+        adjacencyCopies.set(context, { version, adjacency });
+        return adjacency;
+    }
+
     /**
      * Filter out tetrahedra with invalid vertex indices
      * @private
@@ -135,7 +614,7 @@ export class DelaunayComputation {
             }
         }
         
-        if (invalidCount > 0) {
+        if (invalidCount > 0 && this.logLevel >= LOG_INFO) {
             console.log(`Filtered out ${invalidCount} tetrahedra with invalid vertex indices`);
         }
         
@@ -143,17 +622,83 @@ export class DelaunayComputation {
     }
 
     /**
-     * Compute Voronoi diagram using tetrahedra barycenters
+     * Filter a flat Int32Array of tet indices (4 per tet) into nested arrays
      * @private
      */
-    _computeVoronoiBarycentric() {
+    _filterTetrahedraFlat(flatTets) {
+        const filtered = [];
+        let invalidCount = 0;
+        const n = this.numPoints;
+        
+        for (let i = 0; i + 3 < flatTets.length; i += 4) {
+            const v0 = flatTets[i];
+            const v1 = flatTets[i + 1];
+            const v2 = flatTets[i + 2];
+            const v3 = flatTets[i + 3];
+            
+            if (v0 >= 0 && v0 < n && v1 >= 0 && v1 < n &&
+                v2 >= 0 && v2 < n && v3 >= 0 && v3 < n) {
+                filtered.push([v0, v1, v2, v3]);
+            } else {
+                invalidCount++;
+            }
+        }
+        
+        if (invalidCount > 0 && this.logLevel >= LOG_INFO) {
+            console.log(`Filtered out ${invalidCount} tetrahedra with invalid vertex indices`);
+        }
+        
+        return filtered;
+    }
+
+    /**
+     * Voronoi vertices in WASM (compute_tet_centers): one center per tet,
+     * unwrapped with this.tetTranslations when they match the tets, wrapped
+     * back into the cube. Null if the module has no kernel.
+     * @private
+     */
+    _computeTetCentersNative(wasmModule, circumcenters) {
+        if (!wasmModule || typeof wasmModule.compute_tet_centers !== 'function') {
+            return null;
+        }
+        let flatTets = this.tetrahedraFlat;
+        let translations = this.tetTranslations;
+        if (!flatTets || flatTets.length !== this.tetrahedra.length * 4) {
+            flatTets = new Int32Array(this.tetrahedra.length * 4);
+            this.tetrahedra.forEach((tet, i) => flatTets.set(tet, i * 4));
+            translations = null; // no longer aligned with the tets
+        }
+        return wasmModule.compute_tet_centers(this.points, flatTets, translations,
+            this.isPeriodic, circumcenters);
+    }
+
+    /**
+     * Compute Voronoi diagram using tetrahedra barycenters, or circumcenters
+     * with the native kernel
+     * @param {Object} wasmModule - The loaded WASM module, or null for the JS path
+     * @param {string} centers - 'barycenter' or 'circumcenter'
+     * @private
+     */
+    _computeVoronoiBarycentric(wasmModule = null, centers = 'barycenter') {
         if (this.tetrahedra.length === 0) return;
 
-        console.log("Computing Voronoi diagram using barycenters...");
+        const circumcenters = centers === 'circumcenter';
+        if (this.logLevel >= LOG_INFO) {
+            console.log(`Computing Voronoi diagram using ${circumcenters ? 'circumcenters' : 'barycenters'}...`);
+        }
 
-        // 1. Calculate the barycenter for each valid tetrahedron
+        // 1. Calculate the barycenter (circumcenter) for each valid tetrahedron
         this.barycenters = [];
-        for (let i = 0; i < this.tetrahedra.length; i++) {
+        const native = this._computeTetCentersNative(wasmModule, circumcenters);
+        this.centers = native && circumcenters ? 'circumcenter' : 'barycenter';
+        if (native) {
+            for (let i = 0; i < this.tetrahedra.length; i++) {
+                this.barycenters.push([native[i * 3], native[i * 3 + 1], native[i * 3 + 2]]);
+            }
+        } else if (circumcenters && this.logLevel >= LOG_ERRORS) {
+            console.warn('Circumcenters need the WASM compute_tet_centers kernel; using barycenters');
+        }
+        for (let i = this.barycenters.length; i < this.tetrahedra.length; i++) {
             const tetraIndices = this.tetrahedra[i];
             const p0 = this.pointsArray[tetraIndices[0]];
             const p1 = this.pointsArray[tetraIndices[1]];
@@ -250,20 +795,25 @@ export class DelaunayComputation {
             }
         }
         
-        console.log(`Computed ${this.voronoiEdges.length} Voronoi edges.`);
+        if (this.logLevel >= LOG_INFO) {
+            console.log(`Computed ${this.voronoiEdges.length} Voronoi edges.`);
+        }
         
-        // ACUTENESS ANALYSIS: Log data structure exploration
-        console.log('=== ACUTENESS ANALYSIS DATA STRUCTURE EXPLORATION ===');
-        console.log('Available data structures:');
-        console.log('- getPoints():', this.getPoints());
-        console.log('- getVertices():', this.getVertices());
-        console.log('- getCells():', this.getCells());
-        console.log('- getFaces():', this.getFaces());
-        console.log('- getDelaunayTetrahedra():', this.getDelaunayTetrahedra());
-        console.log('- First 3 tetrahedra:', this.tetrahedra.slice(0, 3));
-        console.log('- First 3 barycenters:', this.barycenters.slice(0, 3));
-        console.log('- First 3 voronoi edges:', this.voronoiEdges.slice(0, 3));
-        console.log('==================================================');
+        // ACUTENESS ANALYSIS: Log data structure exploration (builds the
+        // cells and faces, so only at LOG_DEBUG)
+        if (this.logLevel >= LOG_DEBUG) {
+            console.log('=== ACUTENESS ANALYSIS DATA STRUCTURE EXPLORATION ===');
+            console.log('Available data structures:');
+            console.log('- getPoints():', this.getPoints());
+            console.log('- getVertices():', this.getVertices());
+            console.log('- getCells():', this.getCells());
+            console.log('- getFaces():', this.getFaces());
+            console.log('- getDelaunayTetrahedra():', this.getDelaunayTetrahedra());
+            console.log('- First 3 tetrahedra:', this.tetrahedra.slice(0, 3));
+            console.log('- First 3 barycenters:', this.barycenters.slice(0, 3));
+            console.log('- First 3 voronoi edges:', this.voronoiEdges.slice(0, 3));
+            console.log('==================================================');
+        }
     }
 
     /**
@@ -317,7 +867,12 @@ export class DelaunayComputation {
             numPoints: this.numPoints,
             numTetrahedra: this.tetrahedra.length,
             numVoronoiEdges: this.voronoiEdges.length,
-            isPeriodic: this.isPeriodic
+            isPeriodic: this.isPeriodic,
+            incremental: this.lastUpdateIncremental,
+            spatiallyReordered: this.permutation !== null,
+            weighted: this.weights !== null,
+            frameArena: this.frameArena,
+            wasm: this.wasmStats
         };
     }
 
@@ -364,6 +919,262 @@ export class DelaunayComputation {
         return cells;
     }
 
+    /**
+     * Get the cells whose Voronoi cell changed in the last update, derived
+     * from the Delaunay adjacency held by the WASM context. Returns null when
+     * unknown (no persistent context), in which case every cell should be
+     * treated as changed.
+     */
+    getChangedCells() {
+        return this.changedCells;
+    }
+
+    /**
+     * Get the Delaunay graph (vertex -> neighbor vertices) in CSR form: the
+     * neighbors of point v are colidx[rowptr[v]] .. colidx[rowptr[v + 1] - 1],
+     * sorted, periodic images folded back to their point. Comes from the WASM
+     * context when available, otherwise it is built once from the tetrahedra
+     * and cached. Shared, read-only.
+     * @returns {{ rowptr: Int32Array, colidx: Int32Array }}
+     */
+    getAdjacency() {
+        if (this.adjacency) {
+            return this.adjacency;
+        }
+        if (!this._adjacencyCache) {
+            this._adjacencyCache = this._buildAdjacencyFromTets();
+        }
+        return this._adjacencyCache;
+    }
+
+    /**
+     * The module's persistent k-NN / radius index, loaded with these points.
+     * Its kd-tree is rebuilt on the first query after the points moved, so
+     * calling this every frame costs one comparison pass when they did not.
+     * Periodic distances are taken across the faces of the cube. Query
+     * results (nearest, within_radius, all_nearest, all_within_radius) are
+     * typed array views valid until the next query.
+     * @param {Object} wasmModule - The loaded WASM module
+     * @returns {Object|null} NeighborIndex, or null if the module has none
+     */
+    getNeighborIndex(wasmModule) {
+        if (!wasmModule || typeof wasmModule.NeighborIndex !== 'function') {
+            return null;
+        }
+        const index = getPersistentNeighborIndex(wasmModule, this.isPeriodic);
+        index.set_points(this.points);
+        return index;
+    }
+
+    /**
+     * The persistent context's lazy analysis cache (see getAnalysisCache()),
+     * if the context still holds this computation's tets: scores(metric)
+     * and scores_of(metric, items) with metric 0 vertex (per tet), 1 face
+     * (per getFaces() entry), 2 cell (per point), 3 edge (per Voronoi edge),
+     * as Int32Array views valid until the next read. Only the items not
+     * yet valid are computed; an incremental update only invalidates those
+     * around the moved points.
+     * @param {Object} wasmModule - The loaded WASM module
+     * @returns {Object|null} AnalysisCache, or null if the module has none,
+     *     the context has moved on to another compute() or some tets were
+     *     filtered out (the scores would not match this.tetrahedra)
+     */
+    getAnalysisCache(wasmModule) {
+        if (this.contextVersion === null || !this.tetrahedraFlat ||
+            this.tetrahedraFlat.length !== this.tetrahedra.length * 4) {
+            return null;
+        }
+        const cache = getAnalysisCache(wasmModule, this.isPeriodic);
+        if (!cache || getDelaunayContext(wasmModule, this.isPeriodic).update_version() !== this.contextVersion) {
+            return null;
+        }
+        return cache;
+    }
+
+    /**
+     * Render-ready geometry built in WASM (build_render_buffers): the
+     * Delaunay edges, Voronoi edges, tets and Voronoi faces as flat vertex
+     * and index buffers for BufferGeometry attributes, periodic primitives
+     * unwrapped around their first vertex. Positions are Float32Arrays, or
+     * Uint16Arrays with `quantize`, decoding as offset + scale * q / 65535.
+     * The Voronoi vertices are this.centers, those of this.barycenters.
+     * Cached until the next compute().
+     * @param {Object} wasmModule - The loaded WASM module
+     * @param {Object} options - { quantize: 16-bit positions }
+     * @returns {Object|null} { delaunayEdges, voronoiEdges, tets, voronoiFaces:
+     *   { positions, indices }, faceOffsets, facePoints, quantized, offset,
+     *   scale }, or null if the module cannot build them
+     */
+    getRenderBuffers(wasmModule, options = {}) {
+        const quantize = !!options.quantize;
+        if (!wasmModule || typeof wasmModule.build_render_buffers !== 'function') {
+            return null;
+        }
+        if (this._renderBuffersCache && this._renderBuffersCache.quantized === quantize) {
+            return this._renderBuffersCache;
+        }
+        let flatTets = this.tetrahedraFlat;
+        if (!flatTets || flatTets.length !== this.tetrahedra.length * 4) {
+            flatTets = new Int32Array(this.tetrahedra.length * 4);
+            this.tetrahedra.forEach((tet, i) => flatTets.set(tet, i * 4));
+        }
+        const native = wasmModule.build_render_buffers(this.points, flatTets, this.isPeriodic, quantize,
+                                                       this.centers === 'circumcenter');
+
+        // The views alias module memory until the next call: copy them out.
+        const copyMesh = mesh => ({
+            positions: mesh.positions.slice(),
+            indices: mesh.indices.slice()
+        });
+        this._renderBuffersCache = {
+            delaunayEdges: copyMesh(native.delaunay_edges),
+            voronoiEdges: copyMesh(native.voronoi_edges),
+            tets: copyMesh(native.tets),
+            voronoiFaces: copyMesh(native.voronoi_faces),
+            faceOffsets: native.face_offsets.slice(),
+            facePoints: native.face_points.slice(),
+            quantized: native.quantized,
+            offset: native.offset,
+            scale: native.scale
+        };
+        return this._renderBuffersCache;
+    }
+
+    /**
+     * Compact binary snapshot (src/cpp/snapshot.h) of the points, weights,
+     * tets and Delaunay graph of this computation, little-endian with
+     * delta-encoded indices. DelaunayComputation.fromSnapshot() restores it
+     * without triangulating again.
+     * @param {Object} wasmModule - The loaded WASM module
+     * @param {Object} options - { scores: per-point acuteness scores to include }
+     * @returns {Uint8Array|null} - A copy, safe to keep or store, or null if the
+     *   module has no snapshot support
+     */
+    saveSnapshot(wasmModule, options = {}) {
+        if (!wasmModule || typeof wasmModule.encode_snapshot !== 'function') {
+            return null;
+        }
+        let flatTets = this.tetrahedraFlat;
+        if (!flatTets || flatTets.length !== this.tetrahedra.length * 4) {
+            flatTets = new Int32Array(this.tetrahedra.length * 4);
+            this.tetrahedra.forEach((tet, i) => flatTets.set(tet, i * 4));
+        }
+        const adjacency = this.getAdjacency();
+        const scores = options.scores ? Int32Array.from(options.scores) : null;
+        const bytes = wasmModule.encode_snapshot(this.isPeriodic, this.points, this.weights,
+            flatTets, adjacency.rowptr, adjacency.colidx, scores);
+        if (!bytes) {
+            throw new Error('Inconsistent computation, cannot snapshot');
+        }
+        // The view aliases module memory until the next call
+        return bytes.slice();
+    }
+
+    /**
+     * Restore a computation from saveSnapshot() bytes, skipping the
+     * triangulation: tets, Delaunay graph and weights come from the snapshot
+     * and only the barycentric Voronoi diagram is rebuilt. The persistent
+     * context is left as is, so the next compute() triangulates in full.
+     * @param {Object} wasmModule - The loaded WASM module
+     * @param {Uint8Array|ArrayBuffer} bytes - Snapshot bytes
+     * @returns {{ computation: DelaunayComputation, scores: Int32Array|null }}
+     */
+    static fromSnapshot(wasmModule, bytes) {
+        if (!wasmModule || typeof wasmModule.decode_snapshot !== 'function') {
+            throw new Error('WASM module has no snapshot support');
+        }
+        const snapshot = wasmModule.decode_snapshot(
+            bytes instanceof Uint8Array ? bytes : new Uint8Array(bytes));
+        if (!snapshot) {
+            throw new Error('Invalid snapshot');
+        }
+        // The views alias module memory until the next call: copy them out.
+        const computation = new DelaunayComputation(snapshot.points.slice(), snapshot.is_periodic);
+        computation.weights = snapshot.weights.length > 0 ? snapshot.weights.slice() : null;
+        computation.tetrahedraFlat = snapshot.tets.slice();
+        computation.tetrahedra = computation._filterTetrahedraFlat(computation.tetrahedraFlat);
+        if (snapshot.rowptr.length > 0) {
+            computation.adjacency = {
+                rowptr: snapshot.rowptr.slice(),
+                colidx: snapshot.colidx.slice()
+            };
+        }
+        const scores = snapshot.scores.length > 0 ? snapshot.scores.slice() : null;
+        computation._computeVoronoiBarycentric(wasmModule);
+        return { computation, scores };
+    }
+
+    /**
+     * CSR Delaunay graph from this.tetrahedra (no persistent context)
+     * @private
+     */
+    _buildAdjacencyFromTets() {
+        const n = this.numPoints;
+        // Each tet gives each of its vertices 3 neighbors, with repeats
+        const start = new Int32Array(n + 1);
+        for (const tet of this.tetrahedra) {
+            for (const v of tet) start[v + 1] += 3;
+        }
+        for (let v = 0; v < n; v++) start[v + 1] += start[v];
+        const raw = new Int32Array(start[n]);
+        const cursor = start.slice(0, n);
+        for (const tet of this.tetrahedra) {
+            for (let a = 0; a < 4; a++) {
+                for (let b = 0; b < 4; b++) {
+                    if (b !== a) raw[cursor[tet[a]]++] = tet[b];
+                }
+            }
+        }
+        // Sort each row and drop repeats and self loops, compacting in place
+        const rowptr = new Int32Array(n + 1);
+        let nnz = 0;
+        for (let v = 0; v < n; v++) {
+            const row = raw.subarray(start[v], start[v + 1]).sort();
+            let previous = -1;
+            for (let k = 0; k < row.length; k++) {
+                const w = row[k];
+                if (w !== previous && w !== v) raw[nnz++] = w;
+                previous = w;
+            }
+            rowptr[v + 1] = nnz;
+        }
+        return { rowptr, colidx: raw.slice(0, nnz) };
+    }
+
+    /**
+     * Get the packed true Voronoi cells computed in WASM, or null if they
+     * were not requested (compute(..., { voronoiCells: true })) or unavailable
+     */
+    getVoronoiCells() {
+        return this.voronoiCellData;
+    }
+
+    /**
+     * Get one true Voronoi cell as { vertices: [[x,y,z], ...], faces: [{ neighbor, vertices }] },
+     * face vertices being indices into the cell's own vertex list
+     * @param {number} cellIndex - Index of the generator point
+     */
+    getVoronoiCell(cellIndex) {
+        const data = this.voronoiCellData;
+        if (!data || cellIndex < 0 || cellIndex >= data.numCells) return null;
+
+        const firstVertex = data.cellVertexPtr[cellIndex];
+        const vertices = [];
+        for (let v = firstVertex; v < data.cellVertexPtr[cellIndex + 1]; v++) {
+            vertices.push([data.vertices[3 * v], data.vertices[3 * v + 1], data.vertices[3 * v + 2]]);
+        }
+
+        const faces = [];
+        for (let f = data.cellFacePtr[cellIndex]; f < data.cellFacePtr[cellIndex + 1]; f++) {
+            const faceVertices = [];
+            for (let k = data.facePtr[f]; k < data.facePtr[f + 1]; k++) {
+                faceVertices.push(data.faceVertices[k] - firstVertex);
+            }
+            faces.push({ neighbor: data.faceNeighbor[f], vertices: faceVertices });
+        }
+        return { vertices, faces };
+    }
+
     /**
      * Build edge-to-tetrahedra mapping (simple version)
      * @private
@@ -482,7 +1293,7 @@ export class DelaunayComputation {
             }
         }
         
-        console.log(`Generated ${faces.length} Voronoi faces with 3+ vertices`);
+        if (this.logLevel >= LOG_INFO) console.log(`Generated ${faces.length} Voronoi faces with 3+ vertices`);
         
         // Cache the result
         this._facesCache = faces;
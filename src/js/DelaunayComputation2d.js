@@ -0,0 +1,252 @@
+/**
+ * DelaunayComputation2d.js
+ *
+ * The plane counterpart of DelaunayComputation, on the WASM
+ * DelaunayContext2d: Delaunay triangles and Voronoi polygons of points in
+ * the unit square, periodic or not, with the same compute() options
+ * (incremental updates, power weights, true Voronoi cells) and the 2D
+ * acuteness kernels. Use createDelaunayComputation() in
+ * DelaunayComputation.js to pick the dimension.
+ */
+
+// Persistent WASM 2D contexts, one per module and periodicity.
+const delaunayContexts2d = new WeakMap();
+
+// Last JS copy of each context's Delaunay graph: { version, adjacency }.
+const adjacencyCopies2d = new WeakMap();
+
+/**
+ * The persistent 2D triangulation context of a WASM module for a
+ * periodicity, created on first use
+ * @param {Object} wasmModule - The loaded WASM module
+ * @param {boolean} isPeriodic
+ */
+export function getDelaunayContext2d(wasmModule, isPeriodic) {
+    let contexts = delaunayContexts2d.get(wasmModule);
+    if (!contexts) {
+        contexts = {};
+        delaunayContexts2d.set(wasmModule, contexts);
+    }
+    const key = isPeriodic ? 'periodic' : 'nonPeriodic';
+    if (!contexts[key]) {
+        contexts[key] = new wasmModule.DelaunayContext2d(isPeriodic);
+    }
+    return contexts[key];
+}
+
+/**
+ * Free the persistent 2D contexts created for a WASM module (also done by
+ * releaseDelaunayContexts)
+ * @param {Object} wasmModule - The loaded WASM module
+ */
+export function releaseDelaunayContexts2d(wasmModule) {
+    const contexts = delaunayContexts2d.get(wasmModule);
+    if (contexts) {
+        for (const context of Object.values(contexts)) {
+            context.destroy();
+            context.delete();
+        }
+        delaunayContexts2d.delete(wasmModule);
+    }
+}
+
+/**
+ * Copy the sections of a packed 2D Voronoi cell buffer
+ * (DelaunayContext2d.compute_voronoi_cells) and their vertices. Both views
+ * alias WASM memory, so the sections are copied.
+ */
+function unpackVoronoiCells2d(packed, vertices) {
+    if (!packed) return null;
+    const numCells = packed[0];
+    const numVertices = packed[1];
+    return {
+        numCells,
+        numVertices,
+        vertices: new Float64Array(vertices), // xy pairs, counterclockwise per cell
+        cellVertexPtr: packed.slice(2, 3 + numCells),
+        edgeNeighbor: packed.slice(3 + numCells, 3 + numCells + numVertices) // -1 for the box
+    };
+}
+
+export class DelaunayComputation2d {
+    /**
+     * @param {Array|Float64Array|Float32Array} points - Flat xy pairs or [[x, y], ...]
+     * @param {boolean} isPeriodic
+     */
+    constructor(points, isPeriodic = true) {
+        if (Array.isArray(points) && Array.isArray(points[0])) {
+            this.points = new Float64Array(points.flat());
+        } else {
+            this.points = new Float64Array(points);
+        }
+        this.isPeriodic = isPeriodic;
+        this.dimension = 2;
+        this.numPoints = this.points.length / 2;
+
+        this.triangles = new Int32Array(0); // 3 indices per triangle, counterclockwise
+        this.lastUpdateIncremental = false;
+        this.voronoiCellData = null; // packed Voronoi polygons, see unpackVoronoiCells2d()
+        this.changedCells = null; // Int32Array of cells changed by the last update
+        this.adjacency = null; // { rowptr, colidx } Delaunay graph
+        this.wasmStats = null; // last_stats() of the last call; the tet counters count triangles
+        this.weights = null;
+        this.cellScores = null; // Int32Array from analyzeAcuteness()
+        this.triangleScores = null;
+    }
+
+    /**
+     * Triangulate the points
+     * @param {Object} wasmModule - The loaded WASM module
+     * @param {Object} options - { incremental, maxDisplacement, voronoiCells,
+     *                             weights: as DelaunayComputation.compute() }
+     * @returns {DelaunayComputation2d} - Returns this for chaining
+     */
+    async compute(wasmModule, options = {}) {
+        const {
+            incremental = false,
+            maxDisplacement = 0.05,
+            voronoiCells = false,
+            weights = null
+        } = options;
+        if (!wasmModule || typeof wasmModule.DelaunayContext2d !== 'function') {
+            throw new Error('WASM module with DelaunayContext2d not provided');
+        }
+
+        this.lastUpdateIncremental = false;
+        this.voronoiCellData = null;
+        this.changedCells = null;
+        this.adjacency = null;
+        this.weights = weights ? new Float64Array(weights) : null;
+
+        const context = getDelaunayContext2d(wasmModule, this.isPeriodic);
+        context.update_points(this.points);
+        if (this.weights) {
+            context.update_weights(this.weights);
+        } else if (context.is_weighted()) {
+            context.clear_weights();
+        }
+        let trianglesView;
+        if (incremental) {
+            trianglesView = context.compute_incremental(maxDisplacement);
+            this.lastUpdateIncremental = context.last_update_was_incremental();
+        } else {
+            trianglesView = context.compute();
+        }
+        // The view aliases WASM memory and is reused by the next call, so keep a copy
+        this.triangles = trianglesView ? new Int32Array(trianglesView) : new Int32Array(0);
+        if (trianglesView) {
+            if (this.isPeriodic) {
+                this.points.set(context.points());
+            }
+            this.changedCells = new Int32Array(context.changed_cells());
+            this.adjacency = this._copyAdjacency(context);
+            if (voronoiCells) {
+                this.voronoiCellData = unpackVoronoiCells2d(
+                    context.compute_voronoi_cells(), context.voronoi_cell_vertices());
+            }
+        } else {
+            console.warn('No triangles generated');
+        }
+        this.wasmStats = wasmModule.last_stats();
+        return this;
+    }
+
+    /**
+     * Copy the context's Delaunay graph unless the previous copy is still
+     * current (same adjacency_version)
+     * @private
+     */
+    _copyAdjacency(context) {
+        const rowptrView = context.compute_adjacency();
+        if (!rowptrView) return null;
+        const version = context.adjacency_version();
+        const copy = adjacencyCopies2d.get(context);
+        if (copy && copy.version === version) return copy.adjacency;
+        const adjacency = {
+            rowptr: new Int32Array(rowptrView),
+            colidx: new Int32Array(context.adjacency_colidx())
+        };
+        adjacencyCopies2d.set(context, { version, adjacency });
+        return adjacency;
+    }
+
+    /**
+     * Score the last compute() in WASM: acute interior angles of each
+     * Voronoi polygon (0..3, needs voronoiCells) and acute corners of each
+     * triangle (0..3)
+     * @param {Object} wasmModule - The loaded WASM module
+     * @param {Object} options - { changedOnly: rescore only the changed
+     *                             cells when the context's scores are those
+     *                             of the update just before this one }
+     * @returns {Object} { cellScores: Int32Array or null, triangleScores: Int32Array }
+     */
+    analyzeAcuteness(wasmModule, options = {}) {
+        const { changedOnly = false } = options;
+        const context = getDelaunayContext2d(wasmModule, this.isPeriodic);
+        const cellView = this.voronoiCellData ?
+            context.cell_acuteness(changedOnly) : null;
+        this.cellScores = cellView ? new Int32Array(cellView) : null;
+        const triangleView = context.triangle_acuteness();
+        this.triangleScores = triangleView ? new Int32Array(triangleView) : new Int32Array(0);
+        return { cellScores: this.cellScores, triangleScores: this.triangleScores };
+    }
+
+    /**
+     * Get statistics about the computation
+     */
+    getStats() {
+        return {
+            numPoints: this.numPoints,
+            numTriangles: this.triangles.length / 3,
+            isPeriodic: this.isPeriodic,
+            dimension: 2,
+            incremental: this.lastUpdateIncremental,
+            weighted: this.weights !== null,
+            wasm: this.wasmStats
+        };
+    }
+
+    /**
+     * Get the input points (flat xy pairs, wrapped into [0, 1) when periodic)
+     */
+    getPoints() {
+        return this.points;
+    }
+
+    /**
+     * Get the cells changed in the last update, see
+     * DelaunayComputation.getChangedCells()
+     */
+    getChangedCells() {
+        return this.changedCells;
+    }
+
+    /**
+     * Get the Delaunay graph in CSR form, see DelaunayComputation.getAdjacency()
+     * @returns {{ rowptr: Int32Array, colidx: Int32Array }|null}
+     */
+    getAdjacency() {
+        return this.adjacency;
+    }
+
+    /**
+     * Get the packed Voronoi polygons, or null if they were not requested
+     */
+    getVoronoiCells() {
+        return this.voronoiCellData;
+    }
+
+    /**
+     * Get one Voronoi polygon as [[x, y], ...], counterclockwise
+     * @param {number} cellIndex - Index of the generator point
+     */
+    getVoronoiCell(cellIndex) {
+        const data = this.voronoiCellData;
+        if (!data || cellIndex < 0 || cellIndex >= data.numCells) return null;
+        const polygon = [];
+        for (let k = data.cellVertexPtr[cellIndex]; k < data.cellVertexPtr[cellIndex + 1]; k++) {
+            polygon.push([data.vertices[2 * k], data.vertices[2 * k + 1]]);
+        }
+        return polygon;
+    }
+}
@@ -5,6 +5,10 @@
  * Uses JavaScript optimization techniques to achieve near-WASM performance
  */
 
+import { invertPermutation, permuteArray, permuteIndexMap } from './SpatialOrder.js';
+import { QualityScheduler } from './QualityScheduler.js';
+import { getLazyAcuteness } from './GeometryAnalysis.js';
+
 // Pre-allocate arrays to avoid garbage collection
 const vec1 = new Float32Array(3);
 const vec2 = new Float32Array(3);
@@ -221,24 +225,28 @@ export class FastCellAcuteness {
     
     /**
      * Incremental update for animation
+     * @param {Object} options - as calculate(), and scheduled: the cells were
+     *     chosen by a QualityScheduler, so skip the throttling and the
+     *     preview fallback (the skipped cells would be lost)
      */
     updateIncremental(cells, changedCells, options = {}) {
         const now = performance.now();
         
         // Throttle updates
-        if (now - this.lastUpdateTime < this.updateInterval) {
+        if (!options.scheduled && now - this.lastUpdateTime < this.updateInterval) {
             return this.previousScores;
         }
         
         this.lastUpdateTime = now;
         
         // If too many changes, do preview calculation
-        if (changedCells.size > cells.size * 0.3) {
+        if (!options.scheduled && changedCells.size > cells.size * 0.3) {
             return this.calculate(cells, { ...options, isPreview: true });
         }
         
         // Otherwise, update only changed cells
-        const scores = new Float32Array(this.previousScores);
+        const scores = new Float32Array(Math.max(this.previousScores.length, cells.size));
+        scores.set(this.previousScores);
         
         for (const cellIdx of changedCells) {
             const cellVertices = cells.get(cellIdx);
@@ -279,108 +287,76 @@ export class FastCellAcuteness {
 }
 
 /**
- * Adaptive quality manager for maintaining frame rate
+ * Adaptive quality manager for maintaining frame rate: the shared
+ * QualityScheduler, under its former name
  */
-export class AdaptiveQuality {
-    constructor(targetFPS = 30) {
-        this.targetFPS = targetFPS;
-        this.frameTimings = new Float32Array(10);
-        this.frameIndex = 0;
-        this.quality = 'high';
-        this.qualitySettings = {
-            high: { maxNeighbors: 6, skipRatio: 0, updateInterval: 33 },
-            medium: { maxNeighbors: 4, skipRatio: 0.3, updateInterval: 50 },
-            low: { maxNeighbors: 3, skipRatio: 0.6, updateInterval: 100 }
-        };
-    }
-    
-    recordFrame(deltaTime) {
-        this.frameTimings[this.frameIndex] = deltaTime;
-        this.frameIndex = (this.frameIndex + 1) % this.frameTimings.length;
-        
-        // Calculate average FPS
-        const avgDelta = this.frameTimings.reduce((a, b) => a + b) / this.frameTimings.length;
-        const currentFPS = 1000 / avgDelta;
-        
-        // Adjust quality
-        if (currentFPS < this.targetFPS * 0.8) {
-            this.decreaseQuality();
-        } else if (currentFPS > this.targetFPS * 1.2 && this.quality !== 'high') {
-            this.increaseQuality();
-        }
-    }
-    
-    decreaseQuality() {
-        if (this.quality === 'high') {
-            this.quality = 'medium';
-            console.log('Reducing to medium quality for performance');
-        } else if (this.quality === 'medium') {
-            this.quality = 'low';
-            console.log('Reducing to low quality for performance');
-        }
-    }
-    
-    increaseQuality() {
-        if (this.quality === 'low') {
-            this.quality = 'medium';
-        } else if (this.quality === 'medium') {
-            this.quality = 'high';
-        }
-    }
-    
-    getSettings() {
-        return this.qualitySettings[this.quality];
-    }
+export class AdaptiveQuality extends QualityScheduler {
 }
 
 /**
  * Main class for fast acuteness analysis with live updates
  */
 export class FastAcutenessAnalyzer {
-    constructor() {
+    /**
+     * @param {QualityScheduler} scheduler - Frame budget shared with the rest
+     *     of the frame (the page's triangulation and rendering); a private one
+     *     by default
+     */
+    constructor(scheduler = null) {
         this.cellAnalyzer = new FastCellAcuteness();
-        this.qualityManager = new AdaptiveQuality();
+        this.qualityManager = scheduler || new AdaptiveQuality();
         this.lastPositions = new Map();
         this.movementThreshold = 0.001; // Minimum movement to trigger update
         this.HALF_PI = Math.PI / 2; // Add this constant
+        this.numCells = 0;
     }
     
     /**
-     * Analyze with optimizations for 1000+ points
+     * Analyze with optimizations for 1000+ points. The changed cells that do
+     * not fit in the frame budget are analyzed in the next calls. With
+     * options.wasmModule the face, vertex and edge scores are the lazy ones
+     * of the WASM analysis cache (see getLazyAcuteness()), computed only
+     * when read.
      */
     analyze(computation, options = {}) {
         const startTime = performance.now();
         
-        // Get quality settings
-        const qualitySettings = this.qualityManager.getSettings();
+        // Detect which cells changed
+        const changedCells = this.detectChangedCells(computation);
+        const cells = computation.getCells();
+        if (cells.size !== this.numCells) {
+            // New cell set: the queued indices and previous scores no longer apply
+            this.qualityManager.clearPending();
+        }
+        
+        const plan = this.qualityManager.planAnalysis(changedCells, cells.size, {
+            hasScores: cells.size === this.numCells
+        });
+        this.numCells = cells.size;
         const analysisOptions = { 
-            ...qualitySettings, 
+            ...plan.settings, 
             ...options,
             isPeriodic: computation.isPeriodic,
-            points: computation.getPoints()
+            points: computation.getPoints(),
+            scheduled: true
         };
         
-        // Detect which cells changed
-        const changedCells = this.detectChangedCells(computation);
-        
-        // Use incremental update if possible
-        const cells = computation.getCells();
         let cellScores;
-        
-        if (changedCells.size === 0) {
+        let analyzedCells = 0;
+        if (plan.mode === 'cached') {
             // No changes, return cached results
             cellScores = this.cellAnalyzer.previousScores;
-        } else if (changedCells.size < cells.size * 0.3) {
-            // Incremental update
-            cellScores = this.cellAnalyzer.updateIncremental(cells, changedCells, analysisOptions);
+        } else if (plan.mode === 'incremental') {
+            cellScores = this.cellAnalyzer.updateIncremental(cells, plan.cells, analysisOptions);
+            analyzedCells = plan.cells.size;
         } else {
             // Full recalculation with quality settings
             cellScores = this.cellAnalyzer.calculate(cells, analysisOptions);
+            analyzedCells = cells.size;
         }
         
-        // Record frame timing
-        const frameTime = performance.now() - startTime;
-        this.qualityManager.recordFrame(frameTime);
+        // Record the analysis cost
+        this.qualityManager.recordAnalysis(performance.now() - startTime, analyzedCells);
         
         // Compute face and vertex scores only if needed
         let faceScores = [];
@@ -391,6 +367,19 @@ export class FastAcutenessAnalyzer {
         const needsFaceScores = options.includeFaces !== false;
         const needsVertexScores = options.includeVertices !== false;
         const needsEdgeScores = options.includeEdges !== false;
+        const lazy = options.wasmModule ? getLazyAcuteness(computation, options.wasmModule) : null;
+        
+        if (lazy) {
+            const results = { cellScores: Array.from(cellScores), faceScores, vertexScores, edgeScores };
+            for (const [field, needed] of [['faceScores', needsFaceScores],
+                                           ['vertexScores', needsVertexScores],
+                                           ['edgeScores', needsEdgeScores]]) {
+                if (needed) {
+                    Object.defineProperty(results, field, { enumerable: true, get: () => lazy[field] });
+                }
+            }
+            return results;
+        }
         
         if (needsFaceScores) {
             const faces = computation.getFaces();
@@ -437,10 +426,30 @@ export class FastAcutenessAnalyzer {
     }
     
     /**
-     * Detect which cells have changed
+     * Follow a spatial reordering of the points (see
+     * DelaunayComputation.permutation), so that the cached positions and
+     * scores still match their cells and the reorder alone triggers no update.
+     * @param {Int32Array} order - new index -> old index
+     */
+    applyPermutation(order) {
+        const inverse = invertPermutation(order);
+        this.lastPositions = permuteIndexMap(this.lastPositions, inverse);
+        this.qualityManager.applyPermutation(inverse);
+        const previous = this.cellAnalyzer.previousScores;
+        if (previous.length >= order.length) {
+            const scores = new Float32Array(previous.length);
+            scores.set(permuteArray(previous, order));
+            this.cellAnalyzer.previousScores = scores;
+        }
+    }
+    
+    /**
+     * Detect which cells have changed: the moved points, and their Delaunay
+     * neighbors when the computation provides the graph (getAdjacency())
      */
     detectChangedCells(computation) {
         const changed = new Set();
+        const moved = [];
         const points = computation.getPoints();
         
         points.forEach((point, idx) => {
@@ -455,11 +464,23 @@ export class FastAcutenessAnalyzer {
                 
                 if (dx*dx + dy*dy + dz*dz > this.movementThreshold * this.movementThreshold) {
                     changed.add(idx);
+                    moved.push(idx);
                     this.lastPositions.set(idx, [...point]);
                 }
             }
         });
         
+        // A moved point also reshapes the cells around it
+        if (moved.length > 0 && computation.getAdjacency) {
+            const { rowptr, colidx } = computation.getAdjacency();
+            for (const idx of moved) {
+                if (idx >= rowptr.length - 1) continue;
+                for (let k = rowptr[idx]; k < rowptr[idx + 1]; k++) {
+                    changed.add(colidx[k]);
+                }
+            }
+        }
+        
         return changed;
     }
 } 
\ No newline at end of file
@@ -319,13 +319,14 @@ export function faceAcuteness(computation, maxScore = Infinity) {
  * @param {Object} computation - The DelaunayComputation object
  * @param {number} maxScore - Maximum score to compute (for early termination)
  * @param {number} searchRadius - Not used in current implementation
- * @returns {Array<number>} Array of acute angle counts for each cell
+ * @returns {Array<number>} Array of acute angle counts for each cell, indexed by point
  */
 export function cellAcuteness(computation, maxScore = Infinity, searchRadius = 0.3) {
     const startTime = performanceEnabled ? performance.now() : 0;
     
     const cells = computation.getCells();
-    const scores = [];
+    // Indexed by point: the cells Map is in first-seen order, not point order
+    const scores = new Array(computation.getPoints().length).fill(0);
     
     // In non-periodic mode, detect boundary cells
     let boundaryCells = new Map(); // Map cell index to boundary info
@@ -368,7 +369,6 @@ export function cellAcuteness(computation, maxScore = Infinity, searchRadius = 0
     // For each cell, analyze the angles at each Voronoi vertex 
     for (const [cellIdx, cellVertices] of cells.entries()) {
         if (cellVertices.length < 4) {
-            scores.push(0);
             continue;
         }
         
@@ -378,23 +378,6 @@ export function cellAcuteness(computation, maxScore = Infinity, searchRadius = 0
         
         let acuteAngles = 0;
         
-        // CORRECT APPROACH: Count acute angles in each face of the cell
-        // A Voronoi cell is a convex polyhedron with polygonal faces
-        // We need to find all faces and count acute angles in each face
-        
-        // Get the faces of this cell from the computation
-        const faces = computation.getFaces();
-        const cellFaces = [];
-        
-        // Find which faces belong to this cell
-        // A face belongs to a cell if its Delaunay edge connects to this cell's point
-        for (let faceIdx = 0; faceIdx < faces.length; faceIdx++) {
-            const face = faces[faceIdx];
-            if (face.delaunayEdge && (face.delaunayEdge[0] === cellIdx || face.delaunayEdge[1] === cellIdx)) {
-                cellFaces.push(face);
-            }
-        }
-        
         // TEMPORARY: Use a simpler, more consistent approach
         // Count acute angles between edges meeting at each vertex of the cell
         // This is scale-invariant and doesn't depend on face detection
@@ -468,7 +451,7 @@ export function cellAcuteness(computation, maxScore = Infinity, searchRadius = 0
             finalScore = Math.round(finalScore * adjustmentFactor);
         }
         
-        scores.push(finalScore);
+        scores[cellIdx] = finalScore;
         
         // Early termination if we've reached max score
         if (finalScore >= maxScore) break;
@@ -626,25 +609,168 @@ export function edgeAcuteness(computation, maxScore = Infinity) {
     return acutenessScores;
 }
 
+/**
+ * The four analyses of analyzeAcuteness() in one native call, at the
+ * Voronoi vertices of the computation (computation.barycenters, which hold
+ * the circumcenters when computation.centers is 'circumcenter').
+ * @param {Object} computation - The DelaunayComputation result
+ * @param {Object} wasmModule - Module exporting analyzeGeometryAcuteness
+ * @returns {Object|null} Int32Arrays indexed like the JS analyses, or null
+ */
+function nativeAcuteness(computation, wasmModule) {
+    const tets = computation.tetrahedra;
+    let flatTets = computation.tetrahedraFlat;
+    if (!flatTets || flatTets.length !== tets.length * 4) {
+        flatTets = new Int32Array(tets.length * 4);
+        tets.forEach((tet, i) => flatTets.set(tet, i * 4));
+    }
+    const points = computation.points instanceof Float64Array
+        ? computation.points
+        : new Float64Array(computation.getPoints().flat());
+    // Barycenters are recomputed natively; other centers are passed in
+    let centers = null;
+    if (computation.centers === 'circumcenter') {
+        const barycenters = computation.barycenters || [];
+        if (barycenters.length !== tets.length) return null;
+        centers = new Float64Array(tets.length * 3);
+        barycenters.forEach((center, i) => centers.set(center, i * 3));
+    }
+    const native = wasmModule.analyzeGeometryAcuteness(points, flatTets, computation.isPeriodic, centers);
+    if (!native) return null;
+
+    // The views alias module memory until the next call: copy them out.
+    const results = {
+        vertexScores: native.vertexScores.slice(),
+        faceScores: native.faceScores.slice(),
+        cellScores: native.cellScores.slice(),
+        edgeScores: native.edgeScores.slice()
+    };
+    // Voronoi edges come from the barycentric pass: fall back if they
+    // were built some other way.
+    if (results.edgeScores.length !== (computation.voronoiEdges || []).length) {
+        results.edgeScores = edgeAcuteness(computation);
+    }
+    return results;
+}
+
+// Metric indices of the WASM AnalysisCache, by result field.
+const ANALYSIS_METRICS = {
+    vertexScores: 0,
+    faceScores: 1,
+    cellScores: 2,
+    edgeScores: 3
+};
+
+// The JS analysis of each result field, for reads after the cache moved on.
+const JS_ANALYSES = {
+    vertexScores: vertexAcuteness,
+    faceScores: faceAcuteness,
+    cellScores: cellAcuteness,
+    edgeScores: edgeAcuteness
+};
+
+/**
+ * Lazy results of analyzeAcuteness() on the persistent context's analysis
+ * cache (DelaunayComputation.getAnalysisCache()): each of vertexScores,
+ * faceScores, cellScores and edgeScores is computed on first read, only
+ * for the items the cache does not hold yet, and kept. scoresOf(field,
+ * indices) reads a subset (e.g. the visible cells) without the rest.
+ * The cache scores at the computation's centers (barycenter or
+ * circumcenter), like analyzeAcuteness().
+ * Fields first read after the next compute() fall back to the JS analysis.
+ * @param {Object} computation - The DelaunayComputation result
+ * @param {Object} wasmModule - Module exporting AnalysisCache
+ * @returns {Object|null} The lazy results, or null without a current cache
+ */
+export function getLazyAcuteness(computation, wasmModule) {
+    if (!computation || typeof computation.getAnalysisCache !== 'function' ||
+        !computation.getAnalysisCache(wasmModule)) {
+        return null;
+    }
+    const numVoronoiEdges = (computation.voronoiEdges || []).length;
+    // The cache's Voronoi edges are those of the barycentric pass
+    const cacheFor = (field) => {
+        const cache = computation.getAnalysisCache(wasmModule);
+        if (cache) {
+            // Score at the computation's Voronoi vertices
+            cache.set_circumcenters(computation.centers === 'circumcenter');
+        }
+        if (cache && field === 'edgeScores' && cache.count(ANALYSIS_METRICS.edgeScores) !== numVoronoiEdges) {
+            return null;
+        }
+        return cache;
+    };
+    const results = {
+        /**
+         * Scores of some items of a field, e.g. scoresOf('cellScores', visibleCells)
+         * @param {string} field - vertexScores, faceScores, cellScores or edgeScores
+         * @param {Array|Int32Array} indices
+         * @returns {Int32Array}
+         */
+        scoresOf(field, indices) {
+            const cache = cacheFor(field);
+            const view = cache ? cache.scores_of(ANALYSIS_METRICS[field], indices) : null;
+            if (view) {
+                return new Int32Array(view);
+            }
+            const all = results[field];
+            return Int32Array.from(indices, (i) => all[i]);
+        }
+    };
+    for (const field of Object.keys(ANALYSIS_METRICS)) {
+        Object.defineProperty(results, field, {
+            enumerable: true,
+            configurable: true,
+            get() {
+                const cache = cacheFor(field);
+                const view = cache ? cache.scores(ANALYSIS_METRICS[field]) : null;
+                // The view aliases WASM memory: keep a copy
+                const scores = view ? new Int32Array(view) : JS_ANALYSES[field](computation);
+                Object.defineProperty(results, field, { value: scores, enumerable: true });
+                return scores;
+            }
+        });
+    }
+    return results;
+}
+
 /**
  * Comprehensive acuteness analysis for all geometric features.
  * @param {Object} computation - The DelaunayComputation result
- * @param {Object} options - Analysis options
+ * @param {Object} options - Analysis options. With `wasmModule` and no
+ *   `maxScore`, the four analyses run in the native kernel
+ *   (analyzeGeometryAcuteness) in one pass, on the same Voronoi vertices
+ *   (computation.barycenters). Its edge scores take the Voronoi edges at
+ *   each tet, where edgeAcuteness() groups them by rounded position, so the
+ *   two differ where distinct tets share a center (cospherical points, in
+ *   particular with circumcenters).
+ *   With `lazy` as well, nothing is computed until a field is read, see
+ *   getLazyAcuteness() (eager results if the module has no cache).
  * @returns {Object} Analysis results with scores for vertices, faces, and cells
  */
 export function analyzeAcuteness(computation, options = {}) {
     const { 
         maxScore = Infinity, 
         includePerformance = false,  // Default to false for speed
-        searchRadius = 0.3
+        searchRadius = 0.3,
+        wasmModule = null,
+        lazy = false
     } = options;
     
+    if (lazy && maxScore === Infinity && !includePerformance) {
+        const lazyResults = getLazyAcuteness(computation, wasmModule);
+        if (lazyResults) return lazyResults;
+    }
+    
     // Enable performance tracking only if requested
     setPerformanceTracking(includePerformance);
     
     const analysisStartTime = includePerformance ? performance.now() : 0;
     
-    const results = {
+    const native = (maxScore === Infinity && computation && computation.tetrahedra &&
+                    wasmModule && typeof wasmModule.analyzeGeometryAcuteness === 'function')
+        ? nativeAcuteness(computation, wasmModule) : null;
+    const results = native || {
         vertexScores: vertexAcuteness(computation, maxScore),
         faceScores: faceAcuteness(computation, maxScore),
         cellScores: cellAcuteness(computation, maxScore, searchRadius),
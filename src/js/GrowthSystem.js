@@ -25,11 +25,16 @@ export class GrowthSystem {
             // Power factor for non-linear growth (1 = linear, 2 = quadratic)
             growthPower: config.growthPower || 1.5,
             // Growth mode: 'more_grow_only', 'more_grow_both', 'more_shrink_only', 'more_shrink_both'
-            mode: config.mode || 'more_grow_both'
+            mode: config.mode || 'more_grow_both',
+            // Weighted growth (applyWeightGrowth): weight change per step at full
+            // flux, and largest |weight|, in units of the squared mean point spacing
+            weightK: config.weightK || 0.02,
+            maxWeight: config.maxWeight || 0.2
         };
         
         // Previous deltas for momentum
         this.previousDeltas = new Map();
+        this.previousWeightDeltas = null; // Float64Array, applyWeightGrowth only
         
         // Statistics
         this.stats = {
@@ -63,35 +68,19 @@ export class GrowthSystem {
     }
     
     /**
-     * Apply growth to points based on acuteness scores
-     * @param {Array} points - Current generator points [[x,y,z], ...]
-     * @param {Object} computation - DelaunayComputation instance
-     * @param {Object} analysisResults - Results from acuteness analysis
-     * @returns {Array} New points after growth
+     * Signed growth flux of each cell from its acuteness score: positive to
+     * grow, negative to shrink, following config.mode, threshold,
+     * growthPower and normalize
+     * @param {Array} cellScores - Acuteness score per cell
+     * @param {number} numPoints - Number of cells
+     * @returns {Array} Flux per cell
      */
-    applyGrowth(points, computation, analysisResults) {
-        if (!analysisResults || !analysisResults.cellScores) {
-            console.warn('No analysis results available for growth');
-            return points;
-        }
-        
-        const cells = computation.getCells();
-        const cellScores = analysisResults.cellScores;
-        
-        // Reset stats
-        this.stats = {
-            totalDisplacement: 0,
-            maxDisplacement: 0,
-            activePoints: 0,
-            growingPoints: 0,
-            shrinkingPoints: 0
-        };
-        
+    computeFlux(cellScores, numPoints) {
         // Calculate raw flux (stress) for each point
-        const rawFlux = new Array(points.length).fill(0);
+        const rawFlux = new Array(numPoints).fill(0);
         let maxFlux = 0;
         
-        for (let i = 0; i < points.length; i++) {
+        for (let i = 0; i < numPoints; i++) {
             const score = cellScores[i] || 0;
             
             // Determine if this cell should grow or shrink based on mode and threshold
@@ -163,6 +152,36 @@ export class GrowthSystem {
             }
         }
         
+        return rawFlux;
+    }
+    
+    /**
+     * Apply growth to points based on acuteness scores
+     * @param {Array} points - Current generator points [[x,y,z], ...]
+     * @param {Object} computation - DelaunayComputation instance
+     * @param {Object} analysisResults - Results from acuteness analysis
+     * @returns {Array} New points after growth
+     */
+    applyGrowth(points, computation, analysisResults) {
+        if (!analysisResults || !analysisResults.cellScores) {
+            console.warn('No analysis results available for growth');
+            return points;
+        }
+        
+        const cells = computation.getCells();
+        const cellScores = analysisResults.cellScores;
+        
+        // Reset stats
+        this.stats = {
+            totalDisplacement: 0,
+            maxDisplacement: 0,
+            activePoints: 0,
+            growingPoints: 0,
+            shrinkingPoints: 0
+        };
+        
+        const rawFlux = this.computeFlux(cellScores, points.length);
+        
         // Calculate new positions
         const newPoints = [];
         
@@ -251,6 +270,72 @@ export class GrowthSystem {
         return newPoints;
     }
     
+    /**
+     * Weighted alternative to applyGrowth: cells grow or shrink by a change
+     * of their power weight instead of a move of their generator, so a step
+     * is one incremental recompute of the Laguerre diagram,
+     * DelaunayComputation.compute(wasmModule, { weights, incremental: true }),
+     * and needs no relaxation. Weights stay within +-maxWeight squared
+     * spacings, which keeps every power cell non-empty in practice.
+     * The displacement statistics hold the weight changes.
+     * @param {Float64Array|null} weights - Current weights, null = all zero
+     * @param {number} numPoints - Number of generator points
+     * @param {Object} analysisResults - Results from acuteness analysis
+     * @returns {Float64Array} New weights
+     */
+    applyWeightGrowth(weights, numPoints, analysisResults) {
+        const newWeights = weights && weights.length === numPoints ?
+            new Float64Array(weights) : new Float64Array(numPoints);
+        if (!analysisResults || !analysisResults.cellScores) {
+            console.warn('No analysis results available for growth');
+            return newWeights;
+        }
+        
+        this.stats = {
+            totalDisplacement: 0,
+            maxDisplacement: 0,
+            activePoints: 0,
+            growingPoints: 0,
+            shrinkingPoints: 0
+        };
+        
+        if (!this.previousWeightDeltas || this.previousWeightDeltas.length !== numPoints) {
+            this.previousWeightDeltas = new Float64Array(numPoints);
+        }
+        
+        // Squared mean spacing of numPoints points in the unit cube
+        const spacing2 = Math.pow(numPoints, -2 / 3);
+        const maxWeight = this.config.maxWeight * spacing2;
+        const rawFlux = this.computeFlux(analysisResults.cellScores, numPoints);
+        
+        for (let i = 0; i < numPoints; i++) {
+            let delta = this.config.weightK * spacing2 * rawFlux[i];
+            delta = this.config.damping * this.previousWeightDeltas[i] +
+                    (1 - this.config.damping) * delta;
+            if (this.config.dt > 0) {
+                delta *= this.config.dt;
+            }
+            this.previousWeightDeltas[i] = delta;
+            
+            const weight = Math.max(-maxWeight, Math.min(maxWeight, newWeights[i] + delta));
+            const change = Math.abs(weight - newWeights[i]);
+            newWeights[i] = weight;
+            
+            if (change > 0) {
+                this.stats.activePoints++;
+                this.stats.totalDisplacement += change;
+                this.stats.maxDisplacement = Math.max(this.stats.maxDisplacement, change);
+                if (rawFlux[i] > 0) {
+                    this.stats.growingPoints++;
+                } else if (rawFlux[i] < 0) {
+                    this.stats.shrinkingPoints++;
+                }
+            }
+        }
+        
+        return newWeights;
+    }
+    
     /**
      * Adjust direction vector for periodic boundaries
      * @private
@@ -303,6 +388,7 @@ export class GrowthSystem {
      */
     reset() {
         this.previousDeltas.clear();
+        this.previousWeightDeltas = null;
         this.stats = {
             totalDisplacement: 0,
             maxDisplacement: 0,
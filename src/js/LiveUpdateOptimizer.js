@@ -5,8 +5,14 @@
  * Only recalculates what actually changed
  */
 
+import { QualityScheduler } from './QualityScheduler.js';
+
 export class LiveUpdateOptimizer {
-    constructor() {
+    /**
+     * @param {QualityScheduler} scheduler - Frame budget shared with the rest
+     *     of the frame; a private one by default
+     */
+    constructor(scheduler = null) {
         this.previousPositions = new Map();
         this.previousScores = {
             cells: [],
@@ -14,9 +20,9 @@ export class LiveUpdateOptimizer {
             vertices: []
         };
         this.updateThreshold = 0.001; // Movement threshold to trigger update
-        this.frameSkip = 2; // Update every N frames
+        this.scheduler = scheduler || new QualityScheduler();
         this.currentFrame = 0;
-        this.dirtyFlags = new Set();
+        this.dirtyFlags = new Set(); // cells changed since the last analyzed frame
     }
     
     /**
@@ -51,11 +57,26 @@ export class LiveUpdateOptimizer {
      * Determine which cells need recalculation
      * @param {Map} cells - Cell to vertices mapping
      * @param {Set} movedPoints - Points that moved
+     * @param {Object} adjacency - Optional { rowptr, colidx } Delaunay graph
+     *     (DelaunayComputation.getAdjacency()): a moved point also changes
+     *     the cells of its neighbors
      * @returns {Set} Cell indices that need update
      */
-    getAffectedCells(cells, movedPoints) {
+    getAffectedCells(cells, movedPoints, adjacency = null) {
         const affectedCells = new Set();
         
+        if (adjacency) {
+            const { rowptr, colidx } = adjacency;
+            movedPoints.forEach(point => {
+                if (point < 0 || point >= rowptr.length - 1) return;
+                affectedCells.add(point);
+                for (let k = rowptr[point]; k < rowptr[point + 1]; k++) {
+                    affectedCells.add(colidx[k]);
+                }
+            });
+            return affectedCells;
+        }
+        
         for (const [cellIdx, cellVertices] of cells.entries()) {
             // Check if any vertex in this cell moved
             for (const vertex of cellVertices) {
@@ -74,16 +95,17 @@ export class LiveUpdateOptimizer {
     /**
      * Smart update decision based on frame rate and movement
      */
-    shouldUpdate(movedPoints) {
+    shouldUpdate(dirtyCells) {
         this.currentFrame++;
         
-        // Skip frames for performance
-        if (this.currentFrame % this.frameSkip !== 0) {
+        // Skip frames for performance, and to drain the cells queued by the
+        // scheduler
+        if (this.currentFrame % this.scheduler.getSettings().skipFrames !== 0) {
             return false;
         }
         
         // Only update if significant movement
-        return movedPoints.size > 0;
+        return dirtyCells.size > 0 || this.scheduler.pending.size > 0;
     }
     
     /**
@@ -102,117 +124,171 @@ export class LiveUpdateOptimizer {
         const currentPoints = computation.getPoints();
         const movedPoints = this.getMovedPoints(currentPoints);
         
+        // Every frame's changed cells, skipped frames included: each update
+        // only reports its own. Prefer the changed-cell set derived from the
+        // Delaunay adjacency in WASM, else the moved points and their neighbors.
+        const changedCells = computation.getChangedCells ? computation.getChangedCells() : null;
+        if (changedCells) {
+            for (const cell of changedCells) this.dirtyFlags.add(cell);
+        } else {
+            const adjacency = computation.getAdjacency ? computation.getAdjacency() : null;
+            const affected = adjacency ? this.getAffectedCells(null, movedPoints, adjacency) : movedPoints;
+            for (const cell of affected) this.dirtyFlags.add(cell);
+        }
+        
         // Skip if no significant movement
-        if (!this.shouldUpdate(movedPoints)) {
+        if (!this.shouldUpdate(this.dirtyFlags)) {
             return this.previousScores;
         }
         
         const cells = computation.getCells();
-        const affectedCells = this.getAffectedCells(cells, movedPoints);
+        const affectedCells = this.dirtyFlags;
+        this.dirtyFlags = new Set();
         
-        // If too many cells affected, do full recalculation
-        if (affectedCells.size > cells.size * 0.3) {
-            return this.fullRecalculation(computation, options);
+        // The scheduler splits the affected cells over the frame budget: full
+        // recalculation when most changed (or no previous scores to patch),
+        // else a batch now and the rest in the next frames
+        const startTime = performance.now();
+        const plan = this.scheduler.planAnalysis(affectedCells, cells.size, { hasScores: !!this.wasmScores });
+        const planOptions = { maxNeighbors: plan.settings.maxNeighbors, ...options };
+        let results;
+        if (plan.mode === 'full') {
+            results = this.fullRecalculation(computation, planOptions);
+        } else if (plan.mode === 'incremental') {
+            results = this.incrementalUpdate(computation, plan.cells, planOptions);
+        } else {
+            results = this.previousScores;
         }
-        
-        // Otherwise, incremental update
-        return this.incrementalUpdate(computation, affectedCells, options);
+        this.scheduler.recordAnalysis(performance.now() - startTime,
+            plan.mode === 'full' ? cells.size : plan.mode === 'incremental' ? plan.cells.size : 0);
+        return results;
     }
     
     /**
      * Incremental update - only recalculate affected cells
+     * @param {Object} options - { acutenessModule: loaded acuteness WASM module, maxNeighbors }
      */
     incrementalUpdate(computation, affectedCells, options) {
         const results = { ...this.previousScores };
+        const wasmModule = options.acutenessModule;
         
         // Only update affected cells
-        if (affectedCells.size > 0) {
-            // In real implementation, this would call WASM incremental update
+        if (affectedCells.size > 0 && wasmModule && typeof wasmModule.updateCellAcuteness === 'function') {
             console.log(`Updating ${affectedCells.size} cells incrementally`);
             
-            // Placeholder - would use WASM updateCellAcuteness
-            // const updatedScores = wasmModule.updateCellAcuteness(
-            //     vertices, cellIndices, Array.from(affectedCells), previousScores
-            // );
+            const { vertices, cellIndices } = this.packCells(wasmModule, computation.getCells());
+            const changedCells = new wasmModule.VectorInt();
+            for (const cellIdx of affectedCells) {
+                changedCells.push_back(cellIdx);
+            }
+            
+            // Scores live in a persistent VectorInt that the kernel updates in place
+            if (!this.wasmScores) {
+                this.wasmScores = new wasmModule.VectorInt();
+            }
+            wasmModule.updateCellAcuteness(
+                vertices, cellIndices, changedCells, this.wasmScores, options.maxNeighbors || 6
+            );
+            results.cells = this.readScores(this.wasmScores);
+            
+            vertices.delete();
+            cellIndices.delete();
+            changedCells.delete();
+            this.previousScores = results;
         }
         
         return results;
     }
     
+    /**
+     * Pack cell vertices into the flat layout used by the acuteness WASM module:
+     * xyz floats, with cellIndices[i]..cellIndices[i + 1] delimiting cell i
+     * (in floats). Cells are ordered by point index.
+     * @param {Object} wasmModule - Loaded acuteness WASM module
+     * @param {Map} cells - Point index to Voronoi vertex list (DelaunayComputation.getCells())
+     */
+    packCells(wasmModule, cells) {
+        const vertices = new wasmModule.VectorFloat();
+        const cellIndices = new wasmModule.VectorInt();
+        const numCells = cells.size > 0 ? Math.max(...cells.keys()) + 1 : 0;
+        
+        let offset = 0;
+        cellIndices.push_back(0);
+        for (let cellIdx = 0; cellIdx < numCells; cellIdx++) {
+            const cellVertices = cells.get(cellIdx) || [];
+            for (const v of cellVertices) {
+                vertices.push_back(v[0]);
+                vertices.push_back(v[1]);
+                vertices.push_back(v[2]);
+            }
+            offset += cellVertices.length * 3;
+            cellIndices.push_back(offset);
+        }
+        
+        return { vertices, cellIndices };
+    }
+    
+    /**
+     * Copy a VectorInt of scores into a plain array
+     */
+    readScores(vector) {
+        const scores = new Array(vector.size());
+        for (let i = 0; i < scores.length; i++) {
+            scores[i] = vector.get(i);
+        }
+        return scores;
+    }
+    
     /**
      * Full recalculation when too many changes
      */
     fullRecalculation(computation, options) {
         console.log('Full recalculation needed');
-        // Would use WASM calculateCellAcuteness for speed
-        // const scores = wasmModule.calculateCellAcuteness(vertices, cellIndices);
+        const wasmModule = options.acutenessModule;
         
-        // For now, fall back to JS implementation
         const results = {
-            cellScores: [], // Would be WASM results
-            faceScores: [],
-            vertexScores: []
+            cells: [],
+            faces: [],
+            vertices: []
         };
         
+        if (wasmModule && typeof wasmModule.calculateCellAcuteness === 'function') {
+            const { vertices, cellIndices } = this.packCells(wasmModule, computation.getCells());
+            // Kept for the next incrementalUpdate() to patch in place
+            if (typeof wasmModule.calculateCellAcutenessInto === 'function') {
+                if (!this.wasmScores) {
+                    this.wasmScores = new wasmModule.VectorInt();
+                }
+                wasmModule.calculateCellAcutenessInto(
+                    vertices, cellIndices, this.wasmScores, options.maxNeighbors || 6
+                );
+            } else {
+                if (this.wasmScores) {
+                    this.wasmScores.delete();
+                }
+                this.wasmScores = wasmModule.calculateCellAcuteness(vertices, cellIndices, options.maxNeighbors || 6);
+            }
+            results.cells = this.readScores(this.wasmScores);
+            vertices.delete();
+            cellIndices.delete();
+        }
+        
         this.previousScores = results;
         return results;
     }
 }
 
 /**
- * Frame rate adaptive quality
+ * Frame rate adaptive quality: the shared QualityScheduler, under its former
+ * name and methods
  */
-export class FrameRateAdapter {
-    constructor(targetFPS = 30) {
-        this.targetFPS = targetFPS;
-        this.measurements = [];
-        this.maxMeasurements = 10;
-        this.qualityLevel = 'high';
-    }
-    
+export class FrameRateAdapter extends QualityScheduler {
     measureFrame(deltaTime) {
-        this.measurements.push(deltaTime);
-        if (this.measurements.length > this.maxMeasurements) {
-            this.measurements.shift();
-        }
-        
-        const avgDelta = this.measurements.reduce((a, b) => a + b, 0) / this.measurements.length;
-        const currentFPS = 1000 / avgDelta;
-        
-        // Adjust quality based on performance
-        if (currentFPS < this.targetFPS * 0.7) {
-            this.decreaseQuality();
-        } else if (currentFPS > this.targetFPS * 0.95) {
-            this.increaseQuality();
-        }
-    }
-    
-    decreaseQuality() {
-        if (this.qualityLevel === 'high') {
-            this.qualityLevel = 'medium';
-            console.log('Reducing quality to maintain frame rate');
-        } else if (this.qualityLevel === 'medium') {
-            this.qualityLevel = 'low';
-            console.log('Further reducing quality');
-        }
-    }
-    
-    increaseQuality() {
-        if (this.qualityLevel === 'low') {
-            this.qualityLevel = 'medium';
-        } else if (this.qualityLevel === 'medium') {
-            this.qualityLevel = 'high';
-        }
+        this.recordFrame(deltaTime);
     }
     
     getQualitySettings() {
-        switch (this.qualityLevel) {
-            case 'high':
-                return { maxNeighbors: 6, skipFrames: 1 };
-            case 'medium':
-                return { maxNeighbors: 4, skipFrames: 2 };
-            case 'low':
-                return { maxNeighbors: 3, skipFrames: 4 };
-        }
+        const { maxNeighbors, skipFrames } = this.getSettings();
+        return { maxNeighbors, skipFrames };
     }
-} 
\ No newline at end of file
+}
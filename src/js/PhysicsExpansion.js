@@ -5,6 +5,9 @@
  * This creates real expansion effects rather than just moving cells around.
  */
 
+import { invertPermutation, permuteArray, permuteIndexMap } from './SpatialOrder.js';
+import { getDelaunayContext } from './DelaunayComputation.js';
+
 export class PhysicsExpansion {
     constructor() {
         // Physics parameters
@@ -13,20 +16,46 @@ export class PhysicsExpansion {
         this.maxForce = 0.1;
         this.minDistance = 0.01;
         
+        // Weighted mode (applyWeightStep), in units of the squared mean spacing
+        this.weightRate = 0.02; // weight change per second and unit of growth rate
+        this.maxWeight = 0.25; // largest |weight|, keeps the power cells non-empty
+        
         // State tracking
         this.forces = new Map(); // cellIndex -> {x, y, z}
         this.velocities = new Map(); // cellIndex -> {x, y, z}
         this.growthRates = new Map(); // cellIndex -> growth rate
+        this.weights = null; // Float64Array of power weights, weighted mode only
+        this.stepper = null; // WASM PhysicsStepper, applyNativeStep only
+        this.stepperModule = null;
         
         // Neighbor cache
+        this.adjacency = null; // { rowptr, colidx } Delaunay graph, see setAdjacency()
         this.neighborCache = new Map(); // cellIndex -> Set of neighbor indices
         this.neighborCacheValid = false;
     }
     
+    /**
+     * Use the Delaunay graph of the current triangulation
+     * (DelaunayComputation.getAdjacency()) for the neighbor queries, instead
+     * of comparing the vertices of every pair of cells. Pass null to go back
+     * to the Voronoi cell comparison.
+     * @param {Object|null} adjacency - { rowptr: Int32Array, colidx: Int32Array }
+     */
+    setAdjacency(adjacency) {
+        this.adjacency = adjacency;
+        this.neighborCache.clear();
+        this.neighborCacheValid = false;
+    }
+    
     /**
      * Find all neighbors of a cell (cells that share a Voronoi edge)
      */
     findCellNeighbors(cellIndex, voronoiCells) {
+        const adjacency = this.adjacency;
+        if (adjacency && cellIndex >= 0 && cellIndex < adjacency.rowptr.length - 1) {
+            return new Set(adjacency.colidx.subarray(adjacency.rowptr[cellIndex],
+                                                     adjacency.rowptr[cellIndex + 1]));
+        }
         if (!this.neighborCacheValid) {
             this.rebuildNeighborCache(voronoiCells);
         }
@@ -278,6 +307,81 @@ export class PhysicsExpansion {
         };
     }
     
+    /**
+     * Native version of applyPhysicsStep: the WASM PhysicsStepper takes the
+     * neighbors from the triangulation of the module's persistent context
+     * (the last DelaunayComputation.compute()) and integrates the context's
+     * points in place, without the quadratic neighbor search or per-step
+     * allocation. Same parameters and growth rates as the JS step.
+     * @param {Object} wasmModule - The loaded WASM module
+     * @param {boolean} isPeriodic - Selects the context
+     * @param {number} deltaTime - Time step in seconds
+     * @returns {Object|null} { positions: Float64Array view of the context's points
+     *     (valid until the next WASM call), maxDisplacement, averageForce },
+     *     or null if the module has no stepper or the context no triangulation
+     */
+    applyNativeStep(wasmModule, isPeriodic, deltaTime = 0.016) {
+        if (!wasmModule || typeof wasmModule.PhysicsStepper !== 'function') return null;
+        if (this.stepperModule !== wasmModule) {
+            this.releaseNativeStepper();
+            this.stepper = new wasmModule.PhysicsStepper();
+            this.stepperModule = wasmModule;
+        }
+        const stepper = this.stepper;
+        stepper.force_strength = this.forceStrength;
+        stepper.damping = this.damping;
+        stepper.max_force = this.maxForce;
+        stepper.min_distance = this.minDistance;
+        stepper.clear_growth_rates();
+        this.growthRates.forEach((growthRate, index) => stepper.set_growth_rate(index, growthRate));
+        
+        const context = getDelaunayContext(wasmModule, isPeriodic);
+        if (!stepper.step(context, deltaTime)) return null;
+        // Positions moved: the JS neighbor cache is stale like after applyPhysicsStep
+        this.neighborCacheValid = false;
+        return {
+            positions: context.points(),
+            maxDisplacement: stepper.max_displacement(),
+            averageForce: stepper.average_force()
+        };
+    }
+    
+    /**
+     * Free the WASM PhysicsStepper, if any
+     */
+    releaseNativeStepper() {
+        if (this.stepper) {
+            this.stepper.delete();
+        }
+        this.stepper = null;
+        this.stepperModule = null;
+    }
+    
+    /**
+     * Weighted alternative to applyPhysicsStep: a growing cell gains power
+     * weight at its growth rate instead of pushing its neighbors away, so the
+     * generators never move and each step is one incremental recompute,
+     * DelaunayComputation.compute(wasmModule, { weights, incremental: true }),
+     * rather than a relaxation of the positions.
+     * @param {number} numPoints - Number of generator points
+     * @param {number} deltaTime - Time step in seconds
+     * @returns {Float64Array} Power weight of every point
+     */
+    applyWeightStep(numPoints, deltaTime = 0.016) {
+        if (!this.weights || this.weights.length !== numPoints) {
+            this.weights = new Float64Array(numPoints);
+        }
+        // Squared mean spacing of numPoints points in the unit cube
+        const spacing2 = Math.pow(numPoints, -2 / 3);
+        const maxWeight = this.maxWeight * spacing2;
+        this.growthRates.forEach((growthRate, index) => {
+            if (index < 0 || index >= numPoints) return;
+            const weight = this.weights[index] + growthRate * this.weightRate * spacing2 * deltaTime;
+            this.weights[index] = Math.max(-maxWeight, Math.min(maxWeight, weight));
+        });
+        return this.weights;
+    }
+    
     /**
      * Get force vectors for visualization
      */
@@ -298,6 +402,30 @@ export class PhysicsExpansion {
         return vectors;
     }
     
+    /**
+     * Follow a spatial reordering of the generator points (see
+     * DelaunayComputation.permutation): re-keys the per-cell state so that
+     * growth rates and velocities stay with their cells.
+     * @param {Int32Array} order - new index -> old index
+     */
+    applyPermutation(order) {
+        const inverse = invertPermutation(order);
+        this.forces = permuteIndexMap(this.forces, inverse);
+        this.velocities = permuteIndexMap(this.velocities, inverse);
+        this.growthRates = permuteIndexMap(this.growthRates, inverse);
+        if (this.weights && this.weights.length === order.length) {
+            this.weights = permuteArray(this.weights, order);
+        }
+        if (this.stepper) {
+            this.stepper.apply_permutation(order);
+        }
+        // Indexed by the old order; the next compute() provides a new graph
+        this.adjacency = null;
+        this.neighborCache.clear();
+        this.neighborCacheValid = false;
+        return inverse;
+    }
+    
     /**
      * Reset all physics state
      */
@@ -305,6 +433,11 @@ export class PhysicsExpansion {
         this.forces.clear();
         this.velocities.clear();
         this.growthRates.clear();
+        this.weights = null;
+        if (this.stepper) {
+            this.stepper.reset();
+        }
+        this.adjacency = null;
         this.neighborCache.clear();
         this.neighborCacheValid = false;
     }
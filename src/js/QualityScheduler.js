@@ -0,0 +1,246 @@
+/**
+ * QualityScheduler.js
+ *
+ * One frame-budget controller for the live update path, shared by the page,
+ * FastAcutenessAnalyzer and LiveUpdateOptimizer. It learns what the work
+ * costs: the triangulation from the stage timings of the WASM calls
+ * (DelaunayComputation.wasmStats, see last_stats()), the analysis from the
+ * measured time per analyzed cell, the rest of the frame (rendering) from
+ * recordOverhead(). From these it plans each frame within 1000 / targetFPS
+ * ms: full or incremental triangulation, how many of the changed cells to
+ * analyze now (the others wait in a queue for the next frames), and the
+ * maxNeighbors / sampling of the analysis.
+ */
+
+// Analysis settings by quality level. skipRatio / isPreview: sampled full
+// calculations (FastCellAcuteness.calculate); skipFrames: analyze every N
+// frames (LiveUpdateOptimizer).
+export const QUALITY_LEVELS = {
+    high: { maxNeighbors: 6, skipRatio: 0, isPreview: false, skipFrames: 1, updateInterval: 33 },
+    medium: { maxNeighbors: 4, skipRatio: 0.3, isPreview: false, skipFrames: 2, updateInterval: 50 },
+    low: { maxNeighbors: 3, skipRatio: 0.6, isPreview: true, skipFrames: 4, updateInterval: 100 }
+};
+
+const LEVEL_ORDER = ['high', 'medium', 'low'];
+
+export class QualityScheduler {
+    /**
+     * @param {number} targetFPS - Frame rate to hold
+     * @param {Object} options - { smoothing: weight of a new sample in the
+     *                             running averages,
+     *                             probeInterval: plans between two tries of the
+     *                                 triangulation path currently not chosen,
+     *                             minBatch: cells analyzed per frame at least,
+     *                             fullThreshold: fraction of the cells above
+     *                                 which a full analysis replaces the batches }
+     */
+    constructor(targetFPS = 30, options = {}) {
+        const {
+            smoothing = 0.2,
+            probeInterval = 30,
+            minBatch = 64,
+            fullThreshold = 0.3
+        } = options;
+        this.targetFPS = targetFPS;
+        this.frameBudget = 1000 / targetFPS;
+        this.smoothing = smoothing;
+        this.probeInterval = probeInterval;
+        this.minBatch = minBatch;
+        this.fullThreshold = fullThreshold;
+        this.quality = 'high';
+
+        // Running averages, 0 until measured
+        this.frameTime = 0;       // ms between frames
+        this.overhead = 0;        // ms of each frame outside the scheduled work
+        this.fullCost = 0;        // ms per point of a full triangulation
+        this.incrementalCost = 0; // ms per point of an incremental request, fallbacks included
+        this.cellCost = 0;        // ms per analyzed cell
+
+        this.frameWork = 0;       // ms of scheduled work spent in the current frame
+        this.plans = 0;
+        this.lastProbe = 0;
+        this.pending = new Set(); // changed cells not analyzed yet
+    }
+
+    _average(current, sample) {
+        return current > 0 ? current + this.smoothing * (sample - current) : sample;
+    }
+
+    /**
+     * Record the time between two frames; adjusts the quality level
+     * @param {number} deltaTime - ms
+     */
+    recordFrame(deltaTime) {
+        if (!(deltaTime > 0)) return;
+        this.frameTime = this._average(this.frameTime, deltaTime);
+        this.frameWork = 0;
+
+        const currentFPS = 1000 / this.frameTime;
+        if (currentFPS < this.targetFPS * 0.8) {
+            this.decreaseQuality();
+        } else if (currentFPS > this.targetFPS * 1.2) {
+            this.increaseQuality();
+        }
+    }
+
+    /**
+     * Record the per-frame time of the work the scheduler does not plan
+     * (camera controls and rendering)
+     * @param {number} ms
+     */
+    recordOverhead(ms) {
+        if (ms >= 0) {
+            this.overhead = this._average(this.overhead, ms);
+        }
+    }
+
+    /**
+     * Record a triangulation
+     * @param {Object} stats - last_stats() of the call (DelaunayComputation.wasmStats)
+     * @param {Object} options - { numPoints, requestedIncremental: whether
+     *                             incremental was asked for (a fallback to a
+     *                             full triangulation counts as the cost of the
+     *                             request), elapsedMs: wall time of the whole
+     *                             compute(), else the C++ total }
+     */
+    recordTriangulation(stats, options = {}) {
+        const { numPoints = 0, requestedIncremental = false, elapsedMs = null } = options;
+        const total = stats && stats.stages_ms ? stats.stages_ms.total : null;
+        if (total !== null && numPoints > 0) {
+            if (requestedIncremental) {
+                this.incrementalCost = this._average(this.incrementalCost, total / numPoints);
+            } else {
+                this.fullCost = this._average(this.fullCost, total / numPoints);
+            }
+        }
+        this.frameWork += elapsedMs !== null ? elapsedMs : (total || 0);
+    }
+
+    /**
+     * Record an analysis pass
+     * @param {number} ms - Time it took
+     * @param {number} numCells - Cells it analyzed
+     */
+    recordAnalysis(ms, numCells) {
+        if (numCells > 0 && ms >= 0) {
+            this.cellCost = this._average(this.cellCost, ms / numCells);
+        }
+        this.frameWork += Math.max(ms, 0);
+    }
+
+    /**
+     * ms left in the current frame for more work
+     */
+    remainingBudget() {
+        return Math.max(this.frameBudget - this.overhead - this.frameWork, 0);
+    }
+
+    /**
+     * Choose the next triangulation: incremental while it costs less than a
+     * full one per point (the fallbacks of a failing kinetic update make it
+     * more expensive), with the other path tried every probeInterval plans
+     * so that its estimate follows the motion.
+     * @returns {Object} { incremental }
+     */
+    planTriangulation() {
+        this.plans++;
+        if (this.fullCost === 0 || this.incrementalCost === 0) {
+            return { incremental: this.incrementalCost === 0 };
+        }
+        const preferIncremental = this.incrementalCost <= this.fullCost;
+        if (this.plans - this.lastProbe >= this.probeInterval) {
+            this.lastProbe = this.plans;
+            return { incremental: !preferIncremental };
+        }
+        return { incremental: preferIncremental };
+    }
+
+    /**
+     * Plan the analysis of this frame. The changed cells join the queue of
+     * those still pending; the plan takes what fits in the rest of the frame.
+     * @param {Iterable<number>} changedCells - Cells changed since the last plan
+     * @param {number} numCells - Cells in total
+     * @param {Object} options - { hasScores: previous scores exist to patch }
+     * @returns {Object} { mode: 'full' | 'incremental' | 'cached', cells: Set of
+     *                     the cells to analyze (incremental), deferred: cells
+     *                     left for the next frames, settings: getSettings() }
+     */
+    planAnalysis(changedCells, numCells, options = {}) {
+        const { hasScores = true } = options;
+        for (const cell of changedCells) {
+            if (cell < numCells) this.pending.add(cell);
+        }
+        const settings = this.getSettings();
+        if (this.pending.size === 0) {
+            return { mode: 'cached', cells: null, deferred: 0, settings };
+        }
+
+        const available = this.remainingBudget();
+        const capacity = this.cellCost > 0 ?
+            Math.max(Math.floor(available / this.cellCost), this.minBatch) : Infinity;
+
+        // A full pass when most cells changed and it fits (or nothing can be patched)
+        if (!hasScores || (this.pending.size > numCells * this.fullThreshold && capacity >= numCells)) {
+            this.pending.clear();
+            return { mode: 'full', cells: null, deferred: 0, settings };
+        }
+
+        let cells = this.pending;
+        if (this.pending.size > capacity) {
+            cells = new Set();
+            for (const cell of this.pending) {
+                if (cells.size >= capacity) break;
+                cells.add(cell);
+            }
+            for (const cell of cells) {
+                this.pending.delete(cell);
+            }
+            // Even the smallest batch runs over: cheapen every cell
+            if (capacity === this.minBatch && this.cellCost * this.minBatch > available) {
+                this.decreaseQuality();
+            }
+        } else {
+            this.pending = new Set();
+        }
+        return { mode: 'incremental', cells, deferred: this.pending.size, settings };
+    }
+
+    /**
+     * Forget the queued cells (new cell numbering, or a full analysis done elsewhere)
+     */
+    clearPending() {
+        this.pending.clear();
+    }
+
+    /**
+     * Follow a spatial reordering of the points (see
+     * DelaunayComputation.permutation) in the queued cells
+     * @param {Int32Array} inverse - old index -> new index
+     */
+    applyPermutation(inverse) {
+        const pending = new Set();
+        for (const cell of this.pending) {
+            if (cell < inverse.length) pending.add(inverse[cell]);
+        }
+        this.pending = pending;
+    }
+
+    decreaseQuality() {
+        const level = LEVEL_ORDER.indexOf(this.quality);
+        if (level < LEVEL_ORDER.length - 1) {
+            this.quality = LEVEL_ORDER[level + 1];
+            console.log(`Reducing to ${this.quality} quality for performance`);
+        }
+    }
+
+    increaseQuality() {
+        const level = LEVEL_ORDER.indexOf(this.quality);
+        if (level > 0) {
+            this.quality = LEVEL_ORDER[level - 1];
+        }
+    }
+
+    getSettings() {
+        return QUALITY_LEVELS[this.quality];
+    }
+}
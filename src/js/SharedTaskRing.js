@@ -0,0 +1,237 @@
+/**
+ * SharedTaskRing.js
+ *
+ * Lock-free task ring and work-stealing ranges over SharedArrayBuffers,
+ * shared by WorkerManager (producer) and AcutenessWorker (consumers).
+ *
+ * Tasks are ranges [begin, end) of cells, faces or tetrahedra. The manager
+ * enqueues them into a bounded MPMC ring; each worker dequeues a task into
+ * its own range slot and consumes it a grain at a time. A worker that finds
+ * the ring empty steals the upper half of the largest range still owned by
+ * another worker, so nobody sits idle while another finishes a long range.
+ */
+
+export const TASK_CELL = 0;
+export const TASK_FACE = 1;
+export const TASK_VERTEX = 2;
+
+// Items consumed per step, by task kind (cells are much heavier than tets)
+export const TASK_GRAIN = [16, 64, 256];
+
+// Control header (Int32)
+const HEAD = 0;
+const TAIL = 1;
+const CAPACITY = 2;
+const REMAINING = 3;
+const HEADER_INTS = 4;
+
+// Ring slot (Int32): sequence number, kind, begin, end
+const SLOT_INTS = 4;
+
+// Worker range (BigUint64): kind in bits 62-63, begin in bits 31-61, end in bits 0-30
+const BITS = 31n;
+const MASK = (1n << BITS) - 1n;
+
+function encodeRange(kind, begin, end) {
+    return (BigInt(kind) << (2n * BITS)) | (BigInt(begin) << BITS) | BigInt(end);
+}
+
+function decodeRange(value) {
+    return {
+        kind: Number(value >> (2n * BITS)),
+        begin: Number((value >> BITS) & MASK),
+        end: Number(value & MASK)
+    };
+}
+
+export class SharedTaskRing {
+    /**
+     * @param {number} capacity - Maximum number of queued tasks
+     * @param {number} numWorkers - Number of consumers (one range slot each)
+     * @param {Object} buffers - Existing { control, ranges } buffers to attach to (worker side)
+     */
+    constructor(capacity, numWorkers, buffers = null) {
+        if (buffers) {
+            this.control = new Int32Array(buffers.control);
+            this.ranges = new BigUint64Array(buffers.ranges);
+        } else {
+            this.control = new Int32Array(new SharedArrayBuffer((HEADER_INTS + capacity * SLOT_INTS) * 4));
+            this.ranges = new BigUint64Array(new SharedArrayBuffer(numWorkers * 8));
+            this.control[CAPACITY] = capacity;
+            this.reset();
+        }
+        this.capacity = this.control[CAPACITY];
+        this.numWorkers = this.ranges.length;
+    }
+
+    /**
+     * Attach to the buffers of a ring created by another thread
+     */
+    static fromBuffers(buffers) {
+        return new SharedTaskRing(0, 0, buffers);
+    }
+
+    /**
+     * Buffers to post to the workers (shared, never copied)
+     */
+    get buffers() {
+        return { control: this.control.buffer, ranges: this.ranges.buffer };
+    }
+
+    /**
+     * Empty the ring and every range. Must not run concurrently with consumers.
+     */
+    reset() {
+        const capacity = this.control[CAPACITY];
+        Atomics.store(this.control, HEAD, 0);
+        Atomics.store(this.control, TAIL, 0);
+        Atomics.store(this.control, REMAINING, 0);
+        for (let i = 0; i < capacity; i++) {
+            Atomics.store(this.control, HEADER_INTS + i * SLOT_INTS, i);
+        }
+        for (let w = 0; w < this.ranges.length; w++) {
+            Atomics.store(this.ranges, w, 0n);
+        }
+    }
+
+    /**
+     * Add a task (multi-producer safe)
+     * @returns {boolean} false if the ring is full
+     */
+    enqueue(kind, begin, end) {
+        for (;;) {
+            const pos = Atomics.load(this.control, TAIL);
+            const slot = HEADER_INTS + (pos % this.capacity) * SLOT_INTS;
+            const diff = Atomics.load(this.control, slot) - pos;
+            if (diff < 0) return false;
+            if (diff === 0 && Atomics.compareExchange(this.control, TAIL, pos, pos + 1) === pos) {
+                this.control[slot + 1] = kind;
+                this.control[slot + 2] = begin;
+                this.control[slot + 3] = end;
+                Atomics.add(this.control, REMAINING, end - begin);
+                Atomics.store(this.control, slot, pos + 1); // publish
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Take the oldest task (multi-consumer safe)
+     * @returns {Object|null} { kind, begin, end } or null if the ring is empty
+     */
+    dequeue() {
+        for (;;) {
+            const pos = Atomics.load(this.control, HEAD);
+            const slot = HEADER_INTS + (pos % this.capacity) * SLOT_INTS;
+            const diff = Atomics.load(this.control, slot) - (pos + 1);
+            if (diff < 0) return null;
+            if (diff === 0 && Atomics.compareExchange(this.control, HEAD, pos, pos + 1) === pos) {
+                const task = {
+                    kind: this.control[slot + 1],
+                    begin: this.control[slot + 2],
+                    end: this.control[slot + 3]
+                };
+                Atomics.store(this.control, slot, pos + this.capacity); // release the slot
+                return task;
+            }
+        }
+    }
+
+    /**
+     * Make [begin, end) the range owned by worker
+     */
+    setRange(worker, kind, begin, end) {
+        Atomics.store(this.ranges, worker, encodeRange(kind, begin, end));
+    }
+
+    /**
+     * Take the next grain of the worker's own range
+     * @returns {Object|null} { kind, begin, end } or null if the range is exhausted
+     */
+    takeChunk(worker) {
+        for (;;) {
+            const value = Atomics.load(this.ranges, worker);
+            const { kind, begin, end } = decodeRange(value);
+            if (begin >= end) return null;
+            const split = Math.min(begin + TASK_GRAIN[kind], end);
+            if (Atomics.compareExchange(this.ranges, worker, value, encodeRange(kind, split, end)) === value) {
+                return { kind, begin, end: split };
+            }
+        }
+    }
+
+    /**
+     * Move the upper half of the largest range owned by another worker into
+     * the thief's (empty) range slot
+     * @returns {boolean} false if there is nothing left worth stealing
+     */
+    steal(thief) {
+        for (;;) {
+            let victim = -1;
+            let victimValue = 0n;
+            let largest = 0;
+            for (let w = 0; w < this.numWorkers; w++) {
+                if (w === thief) continue;
+                const value = Atomics.load(this.ranges, w);
+                const { kind, begin, end } = decodeRange(value);
+                if (end - begin > TASK_GRAIN[kind] && end - begin > largest) {
+                    victim = w;
+                    victimValue = value;
+                    largest = end - begin;
+                }
+            }
+            if (victim < 0) return false;
+
+            const { kind, begin, end } = decodeRange(victimValue);
+            const mid = begin + Math.ceil((end - begin) / 2);
+            if (Atomics.compareExchange(this.ranges, victim, victimValue, encodeRange(kind, begin, mid)) === victimValue) {
+                this.setRange(thief, kind, mid, end);
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Record that count items were processed
+     * @returns {number} Items still to process
+     */
+    complete(count) {
+        return Atomics.sub(this.control, REMAINING, count) - count;
+    }
+
+    /**
+     * Items enqueued and not yet processed
+     */
+    remaining() {
+        return Atomics.load(this.control, REMAINING);
+    }
+}
+
+/**
+ * Consumer loop: process own range, then queued tasks, then steal until no
+ * work is left anywhere
+ * @param {SharedTaskRing} ring - The shared ring
+ * @param {number} workerId - Index of this worker's range slot
+ * @param {Function} processRange - (kind, begin, end) => void
+ * @returns {number} Number of items processed by this worker
+ */
+export function runRingWorker(ring, workerId, processRange) {
+    let processed = 0;
+    for (;;) {
+        const chunk = ring.takeChunk(workerId);
+        if (chunk) {
+            processRange(chunk.kind, chunk.begin, chunk.end);
+            ring.complete(chunk.end - chunk.begin);
+            processed += chunk.end - chunk.begin;
+            continue;
+        }
+        const task = ring.dequeue();
+        if (task) {
+            ring.setRange(workerId, task.kind, task.begin, task.end);
+            continue;
+        }
+        if (!ring.steal(workerId)) {
+            return processed;
+        }
+    }
+}
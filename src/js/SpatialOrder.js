@@ -0,0 +1,55 @@
+/**
+ * SpatialOrder.js
+ *
+ * Helpers to keep per-point data in the spatially coherent order returned by
+ * the WASM DelaunayContext (sort_points_spatially / spatial_order).
+ *
+ * A permutation `order` maps new indices to old ones: after sorting, point k
+ * is the point that was at index order[k]. Every structure indexed by point
+ * (positions, velocities, growth rates, cached scores, selected cells...)
+ * must be permuted with the same order, or it ends up pointing at the wrong
+ * cells.
+ */
+
+/**
+ * Old index -> new index
+ * @param {Int32Array} order - new index -> old index
+ * @returns {Int32Array}
+ */
+export function invertPermutation(order) {
+    const inverse = new Int32Array(order.length);
+    for (let k = 0; k < order.length; k++) {
+        inverse[order[k]] = k;
+    }
+    return inverse;
+}
+
+/**
+ * Reorder an array (plain or typed) of per-point values, `stride` entries
+ * per point. Returns a new array of the same kind.
+ */
+export function permuteArray(values, order, stride = 1) {
+    const result = Array.isArray(values) ? new Array(order.length * stride)
+                                         : new values.constructor(order.length * stride);
+    for (let k = 0; k < order.length; k++) {
+        const from = order[k] * stride;
+        for (let c = 0; c < stride; c++) {
+            result[k * stride + c] = values[from + c];
+        }
+    }
+    return result;
+}
+
+/**
+ * Re-key a Map indexed by point, using the inverse permutation. Entries whose
+ * key is out of range are dropped.
+ */
+export function permuteIndexMap(map, inverse) {
+    const result = new Map();
+    map.forEach((value, index) => {
+        if (index >= 0 && index < inverse.length) {
+            result.set(inverse[index], value);
+        }
+    });
+    return result;
+}
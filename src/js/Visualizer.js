@@ -32,6 +32,37 @@ function isInitialized() {
     return true;
 }
 
+/**
+ * Wrap one mesh of DelaunayComputation.getRenderBuffers() in a BufferGeometry,
+ * without copying: Float32 positions as is, quantized ones as a normalized
+ * Uint16 attribute. Objects drawing a quantized geometry must go through
+ * applyRenderBufferTransform().
+ * @param {Object} mesh - { positions, indices }; no indices for line segments
+ * @returns {Object|null} THREE.BufferGeometry
+ */
+export function createRenderBufferGeometry(mesh) {
+    if (!THREE || !mesh) return null;
+    const geometry = new THREE.BufferGeometry();
+    const normalized = mesh.positions instanceof Uint16Array;
+    geometry.setAttribute('position', new THREE.BufferAttribute(mesh.positions, 3, normalized));
+    if (mesh.indices && mesh.indices.length > 0) {
+        geometry.setIndex(new THREE.BufferAttribute(mesh.indices, 1));
+    }
+    return geometry;
+}
+
+/**
+ * Decode quantized render buffer positions through the object's transform
+ * (position = offset + scale * normalized value); no-op for Float32 buffers.
+ * @param {Object} object - THREE.Object3D drawing a render buffer geometry
+ * @param {Object} renderBuffers - Result of getRenderBuffers()
+ */
+export function applyRenderBufferTransform(object, renderBuffers) {
+    if (!renderBuffers.quantized) return;
+    object.scale.setScalar(renderBuffers.scale);
+    object.position.setScalar(renderBuffers.offset);
+}
+
 /**
  * Apply minimum image convention for periodic boundaries
  * @param {Array} p1 - First point [x, y, z]
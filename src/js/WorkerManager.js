@@ -5,6 +5,16 @@
  * Handles task distribution, load balancing, and result aggregation
  */
 
+import { SharedTaskRing, TASK_CELL, TASK_FACE, TASK_VERTEX, TASK_GRAIN } from './SharedTaskRing.js';
+
+/**
+ * Whether workers can share memory with this thread (requires cross-origin isolation)
+ */
+export function canUseSharedMemory() {
+    return typeof SharedArrayBuffer !== 'undefined' &&
+        (typeof crossOriginIsolated === 'undefined' || crossOriginIsolated);
+}
+
 export class WorkerManager {
     constructor(maxWorkers = 4) {
         this.maxWorkers = Math.min(maxWorkers, navigator.hardwareConcurrency || 4);
@@ -26,7 +36,7 @@ export class WorkerManager {
         // Create worker pool
         for (let i = 0; i < this.maxWorkers; i++) {
             try {
-                const worker = new Worker('./src/js/AcutenessWorker.js');
+                const worker = new Worker('./src/js/AcutenessWorker.js', { type: 'module' });
                 worker.workerId = i;
                 worker.isIdle = true;
                 
@@ -127,6 +137,26 @@ export class WorkerManager {
         });
     }
     
+    /**
+     * Run the tasks of a shared ring on every worker. Only the buffer handles
+     * are posted: the geometry stays in its SharedArrayBuffers and each worker
+     * takes cell ranges from the ring, stealing from the others when it is empty.
+     * @param {SharedTaskRing} ring - Ring filled with the tasks to run
+     * @param {Object} geometry - name -> { type: 'Int32' | 'Float64', buffer: SharedArrayBuffer }
+     * @param {Object} params - Extra task parameters (e.g. maxScore)
+     */
+    runSharedRing(ring, geometry, params = {}) {
+        const count = Math.min(this.workers.length, ring.numWorkers);
+        for (let i = 0; i < count; i++) {
+            this.addTask('SHARED_RING', {
+                ring: ring.buffers,
+                geometry,
+                workerId: i,
+                ...params
+            }, `ring-${i}`);
+        }
+    }
+    
     /**
      * Wait for all tasks to complete
      * @returns {Promise} Promise that resolves when all tasks are done
@@ -218,7 +248,8 @@ export async function parallelAcutenessAnalysis(computation, options = {}) {
         maxScore = Infinity,
         searchRadius = 0.3,
         maxWorkers = 4,
-        chunkSize = 10
+        chunkSize = 10,
+        useSharedMemory = canUseSharedMemory()
     } = options;
     
     console.log('Starting parallel acuteness analysis...');
@@ -229,6 +260,10 @@ export async function parallelAcutenessAnalysis(computation, options = {}) {
     await workerManager.initialize();
     
     try {
+        if (useSharedMemory && workerManager.workers.length > 0) {
+            return await sharedAcutenessAnalysis(workerManager, computation, maxScore, startTime);
+        }
+        
         // Prepare data for parallel processing
         const cells = computation.getCells();
         const faces = computation.getFaces();
@@ -372,4 +407,120 @@ export async function parallelAcutenessAnalysis(computation, options = {}) {
         // Clean up workers
         workerManager.terminate();
     }
-} 
\ No newline at end of file
+} 
+/**
+ * Copy the analysis geometry once into SharedArrayBuffers
+ * @private
+ */
+function buildSharedGeometry(cells, faces, tetrahedra, points) {
+    const shared = (type, length) => {
+        const Type = type === 'Float64' ? Float64Array : Int32Array;
+        const buffer = new SharedArrayBuffer(Math.max(1, length) * Type.BYTES_PER_ELEMENT);
+        return { type, buffer, view: new Type(buffer) };
+    };
+    
+    // Cells, in the same order as cells.keys()
+    let numCellVertices = 0;
+    for (const cellVertices of cells.values()) numCellVertices += cellVertices.length;
+    const cellPtr = shared('Int32', cells.size + 1);
+    const cellVertices = shared('Float64', 3 * numCellVertices);
+    let c = 0, v = 0;
+    for (const vertices of cells.values()) {
+        cellPtr.view[c++] = v;
+        for (const p of vertices) {
+            cellVertices.view.set(p, 3 * v++);
+        }
+    }
+    cellPtr.view[c] = v;
+    
+    let numFaceVertices = 0;
+    for (const face of faces) numFaceVertices += face.voronoiVertices.length;
+    const facePtr = shared('Int32', faces.length + 1);
+    const faceVertices = shared('Float64', 3 * numFaceVertices);
+    v = 0;
+    faces.forEach((face, f) => {
+        facePtr.view[f] = v;
+        for (const p of face.voronoiVertices) {
+            faceVertices.view.set(p, 3 * v++);
+        }
+    });
+    facePtr.view[faces.length] = v;
+    
+    const tets = shared('Int32', 4 * tetrahedra.length);
+    tetrahedra.forEach((tet, t) => tets.view.set(tet, 4 * t));
+    const sharedPoints = shared('Float64', 3 * points.length);
+    points.forEach((p, i) => sharedPoints.view.set(p, 3 * i));
+    
+    return {
+        cellPtr,
+        cellVertices,
+        facePtr,
+        faceVertices,
+        tets,
+        points: sharedPoints,
+        cellScores: shared('Int32', cells.size),
+        faceScores: shared('Int32', faces.length),
+        vertexScores: shared('Int32', tetrahedra.length)
+    };
+}
+
+/**
+ * Shared-memory variant of parallelAcutenessAnalysis: one copy of the
+ * geometry, a lock-free task ring and work stealing between workers
+ * @private
+ */
+async function sharedAcutenessAnalysis(workerManager, computation, maxScore, startTime) {
+    const cells = computation.getCells();
+    const faces = computation.getFaces();
+    const tetrahedra = computation.getDelaunayTetrahedra();
+    const geometry = buildSharedGeometry(cells, faces, tetrahedra, computation.getPoints());
+    
+    // A few large tasks per worker per kind; stealing evens out the rest
+    const numWorkers = workerManager.workers.length;
+    const ring = new SharedTaskRing(64 * numWorkers, numWorkers);
+    const enqueueRange = (kind, count) => {
+        const taskSize = Math.max(TASK_GRAIN[kind], Math.ceil(count / (2 * numWorkers)));
+        for (let begin = 0; begin < count; begin += taskSize) {
+            ring.enqueue(kind, begin, Math.min(begin + taskSize, count));
+        }
+    };
+    enqueueRange(TASK_CELL, cells.size);
+    enqueueRange(TASK_FACE, faces.length);
+    enqueueRange(TASK_VERTEX, tetrahedra.length);
+    
+    const transferable = {};
+    for (const [name, { type, buffer }] of Object.entries(geometry)) {
+        transferable[name] = { type, buffer };
+    }
+    workerManager.runSharedRing(ring, transferable, { maxScore });
+    await workerManager.waitForCompletion();
+    
+    if (ring.remaining() !== 0) {
+        console.error(`Shared acuteness analysis left ${ring.remaining()} items unprocessed`);
+    }
+    
+    const workerMetrics = [];
+    for (const [taskId, result] of workerManager.getResults()) {
+        if (result.error) {
+            console.error(`Shared ring task ${taskId} failed:`, result.error);
+        } else {
+            workerMetrics.push({ taskId, type: 'shared', ...result.metrics });
+        }
+    }
+    
+    const totalTime = performance.now() - startTime;
+    const totalWorkerTime = workerMetrics.reduce((sum, metric) => sum + metric.duration, 0);
+    
+    console.log(`Shared-memory analysis complete in ${totalTime.toFixed(2)}ms`);
+    
+    return {
+        vertexScores: Array.from(geometry.vertexScores.view.subarray(0, tetrahedra.length)),
+        faceScores: Array.from(geometry.faceScores.view.subarray(0, faces.length)),
+        cellScores: Array.from(geometry.cellScores.view.subarray(0, cells.size)),
+        performance: {
+            totalTime,
+            workerMetrics,
+            parallelEfficiency: totalWorkerTime / totalTime
+        }
+    };
+}